@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Compares two Google Benchmark JSON outputs of vacationdb_bench.
+
+    vacationdb_bench --benchmark_out=current.json --benchmark_out_format=json
+    compare.py baseline.json current.json [--threshold 0.10]
+
+Prints the change in time of every benchmark found in both files and exits
+with 1 if any of them got slower by more than the threshold. When the runs
+used --benchmark_repetitions the median is compared. Both runs have to come
+from the same machine, timings from different hardware say nothing.
+"""
+
+import argparse
+import json
+import sys
+
+TO_NANOSECONDS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+
+    times = {}
+    medians = {}
+    for bench in data["benchmarks"]:
+        if bench.get("error_occurred"):
+            continue
+        ns = bench["real_time"] * TO_NANOSECONDS[bench.get("time_unit", "ns")]
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[bench["run_name"]] = ns
+        else:
+            times.setdefault(bench.get("run_name", bench["name"]), ns)
+
+    times.update(medians)
+    return times
+
+
+def format_ns(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return "%.2f %s" % (ns / scale, unit)
+    return "%.0f ns" % ns
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown that counts as a regression")
+    args = parser.parse_args()
+
+    try:
+        baseline = load(args.baseline)
+    except FileNotFoundError:
+        sys.exit("No baseline at %s, record one on this machine first "
+                 "(the vacationdb_bench_baseline target)" % args.baseline)
+    current = load(args.current)
+
+    width = max([len(name) for name in baseline] + [9])
+    print("%-*s %12s %12s %8s" % (width, "Benchmark", "Baseline", "Current", "Change"))
+
+    regressions = []
+    for name, before in baseline.items():
+        if name not in current:
+            print("%-*s %12s %12s %8s" % (width, name, format_ns(before), "-", "missing"))
+            continue
+
+        after = current[name]
+        change = (after - before) / before
+        flag = ""
+        if change > args.threshold:
+            flag = "  <- slower"
+            regressions.append(name)
+        print("%-*s %12s %12s %+7.1f%%%s" % (width, name, format_ns(before), format_ns(after),
+                                            change * 100, flag))
+
+    for name in current:
+        if name not in baseline:
+            print("%-*s %12s %12s %8s" % (width, name, "-", format_ns(current[name]), "new"))
+
+    if regressions:
+        print("\n%d benchmark(s) regressed by more than %.0f%%" %
+              (len(regressions), args.threshold * 100))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
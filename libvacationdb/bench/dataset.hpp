@@ -0,0 +1,44 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "generator.hpp"
+#include "vacationdb.hpp"
+
+namespace Vacationdb_Bench {
+	// The last year of history in every dataset. Queries are made at its end.
+	constexpr uint16_t final_year = 2017;
+
+	// The day type most days off are taken from
+	const Vacationdb::DayID_t main_day{size_t{0}};
+
+	inline std::string employee_name(size_t index) {
+		return Vacationdb_Tools::Generator::employee_name(index);
+	}
+
+	// Everyone has exactly history_years of history, the rest is left to the
+	// generator's defaults so the benchmarks see the same data as the tool.
+	inline Vacationdb_Tools::Generator_Config_t dataset_config(size_t employees,
+	                                                           uint16_t history_years) {
+		Vacationdb_Tools::Generator_Config_t cfg;
+		cfg.employees = employees;
+		cfg.final_year = final_year;
+		cfg.min_years = history_years;
+		cfg.max_years = history_years;
+		return cfg;
+	}
+
+	// Datasets are expensive to build, so each one is only built once per run
+	inline Vacationdb::Database& dataset(size_t employees, uint16_t history_years) {
+		static std::map<std::tuple<size_t, uint16_t>, std::unique_ptr<Vacationdb::Database>> cache;
+
+		auto& db = cache[std::make_tuple(employees, history_years)];
+		if (!db) {
+			db.reset(new Vacationdb::Database);
+			Vacationdb_Tools::Generator{dataset_config(employees, history_years)}.fill(*db);
+		}
+		return *db;
+	}
+}
@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+
+#include "dataset.hpp"
+
+using Vacationdb_Bench::dataset;
+
+namespace {
+	const char* bench_file = "vdb_bench.json";
+
+	int64_t file_size(const char* name) {
+		std::ifstream file(name, std::ios::binary | std::ios::ate);
+		return static_cast<int64_t>(file.tellg());
+	}
+
+	// Saving employees with 5 years of history, by employee count
+	void BM_Save(benchmark::State& state) {
+		auto& db = dataset(static_cast<size_t>(state.range(0)), 5);
+
+		for (auto _ : state) {
+			db.save(bench_file);
+		}
+		state.SetBytesProcessed(state.iterations() * file_size(bench_file));
+		std::remove(bench_file);
+	}
+	BENCHMARK(BM_Save)->Arg(100)->Arg(1000)->Arg(10000)->UseRealTime()->Unit(
+	    benchmark::kMillisecond);
+
+	void BM_Load(benchmark::State& state) {
+		dataset(static_cast<size_t>(state.range(0)), 5).save(bench_file);
+
+		Vacationdb::Database db;
+		for (auto _ : state) {
+			db.load(bench_file);
+		}
+		state.SetBytesProcessed(state.iterations() * file_size(bench_file));
+		std::remove(bench_file);
+	}
+	BENCHMARK(BM_Load)->Arg(100)->Arg(1000)->Arg(10000)->UseRealTime()->Unit(
+	    benchmark::kMillisecond);
+}
@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include "dataset.hpp"
+
+using Vacationdb_Bench::dataset;
+using Vacationdb_Bench::employee_name;
+using Vacationdb_Bench::final_year;
+
+namespace {
+	// Looking up the last employee added, by employee count
+	void BM_Find_Employee(benchmark::State& state) {
+		auto employees = static_cast<size_t>(state.range(0));
+		auto& db = dataset(employees, 1);
+		auto name = employee_name(employees - 1);
+
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(db.find_employee(name.c_str()));
+		}
+	}
+	BENCHMARK(BM_Find_Employee)->Arg(100)->Arg(1000)->Arg(10000);
+
+	void BM_List_Employee_Info(benchmark::State& state) {
+		auto employees = static_cast<size_t>(state.range(0));
+		auto& db = dataset(employees, 1);
+
+		for (auto _ : state) {
+			auto list = db.list_employee_info();
+			benchmark::DoNotOptimize(list);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	BENCHMARK(BM_List_Employee_Info)->Arg(100)->Arg(1000)->Arg(10000);
+
+	void BM_List_Day_Info(benchmark::State& state) {
+		auto& db = dataset(100, 1);
+
+		for (auto _ : state) {
+			auto list = db.list_day_info();
+			benchmark::DoNotOptimize(list);
+		}
+	}
+	BENCHMARK(BM_List_Day_Info);
+
+	// Full history against a one month window, by years of history
+	void BM_List_Days_Off(benchmark::State& state) {
+		auto& db = dataset(64, static_cast<uint16_t>(state.range(0)));
+		auto day = Vacationdb_Bench::main_day;
+
+		for (auto _ : state) {
+			auto list = db.list_days_off(Vacationdb::PersonID_t{0}, day);
+			benchmark::DoNotOptimize(list);
+		}
+	}
+	BENCHMARK(BM_List_Days_Off)->Arg(1)->Arg(20)->Arg(40);
+
+	void BM_List_Days_Off_Range(benchmark::State& state) {
+		auto& db = dataset(64, static_cast<uint16_t>(state.range(0)));
+		auto day = Vacationdb_Bench::main_day;
+
+		for (auto _ : state) {
+			auto list = db.list_days_off(Vacationdb::PersonID_t{0}, day, final_year, 6, 1,
+			                             final_year, 6, 30);
+			benchmark::DoNotOptimize(list);
+		}
+	}
+	BENCHMARK(BM_List_Days_Off_Range)->Arg(1)->Arg(20)->Arg(40);
+}
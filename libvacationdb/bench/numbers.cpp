@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+
+#include "database_impl.hpp"
+
+namespace {
+	void parse(benchmark::State& state, const char* text) {
+		for (auto _ : state) {
+			auto number = Vacationdb::_detail::create_number_safe(text);
+			benchmark::DoNotOptimize(number);
+		}
+	}
+
+	void BM_Parse_Integer(benchmark::State& state) {
+		parse(state, "24");
+	}
+	BENCHMARK(BM_Parse_Integer);
+
+	void BM_Parse_Decimal(benchmark::State& state) {
+		parse(state, "-9.96");
+	}
+	BENCHMARK(BM_Parse_Decimal);
+
+	void BM_Parse_Fraction(benchmark::State& state) {
+		parse(state, "4/5");
+	}
+	BENCHMARK(BM_Parse_Fraction);
+
+	// Too long for 64 bits, takes the slow path
+	void BM_Parse_Long_Decimal(benchmark::State& state) {
+		parse(state, "12345678901234567890.123456789");
+	}
+	BENCHMARK(BM_Parse_Long_Decimal);
+
+	void BM_Format_Number(benchmark::State& state) {
+		auto number = Vacationdb::_detail::create_number_safe("1158/73");
+		for (auto _ : state) {
+			auto text = number.convert_to<std::string>();
+			benchmark::DoNotOptimize(text);
+		}
+	}
+	BENCHMARK(BM_Format_Number);
+}
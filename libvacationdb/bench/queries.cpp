@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include "dataset.hpp"
+
+using Vacationdb_Bench::dataset;
+using Vacationdb_Bench::final_year;
+
+namespace {
+	constexpr size_t query_employees = 64;
+
+	// One day type of one employee, by years of history
+	void BM_Query_Single(benchmark::State& state) {
+		auto& db = dataset(query_employees, static_cast<uint16_t>(state.range(0)));
+		auto day = Vacationdb_Bench::main_day;
+
+		size_t e = 0;
+		for (auto _ : state) {
+			auto days = db.query_vacation_days(Vacationdb::PersonID_t{e}, day, final_year, 12, 31);
+			benchmark::DoNotOptimize(days);
+			e = (e + 1) % query_employees;
+		}
+	}
+	BENCHMARK(BM_Query_Single)->Arg(1)->Arg(5)->Arg(20)->Arg(40);
+
+	// Every day type of one employee, by years of history
+	void BM_Query_All_Types(benchmark::State& state) {
+		auto& db = dataset(query_employees, static_cast<uint16_t>(state.range(0)));
+
+		size_t e = 0;
+		for (auto _ : state) {
+			auto days = db.query_vacation_days(Vacationdb::PersonID_t{e}, final_year, 12, 31);
+			benchmark::DoNotOptimize(days);
+			e = (e + 1) % query_employees;
+		}
+	}
+	BENCHMARK(BM_Query_All_Types)->Arg(1)->Arg(5)->Arg(20)->Arg(40);
+
+	// A batch of asynchronous queries over 10 years of history, by batch size
+	void BM_Query_Async_Batch(benchmark::State& state) {
+		auto& db = dataset(query_employees, 10);
+		auto day = Vacationdb_Bench::main_day;
+		auto batch = static_cast<size_t>(state.range(0));
+
+		std::vector<std::future<std::string>> futures;
+		futures.reserve(batch);
+
+		for (auto _ : state) {
+			for (size_t i = 0; i < batch; ++i) {
+				futures.push_back(db.query_vacation_days_async(
+				    Vacationdb::PersonID_t{i % query_employees}, day, final_year, 12, 31));
+			}
+			for (auto& f : futures) {
+				benchmark::DoNotOptimize(f.get());
+			}
+			futures.clear();
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	BENCHMARK(BM_Query_Async_Batch)->Arg(16)->Arg(256)->UseRealTime();
+
+	// One day type for every employee with 5 years of history, by employee count
+	void BM_Report(benchmark::State& state) {
+		auto& db = dataset(static_cast<size_t>(state.range(0)), 5);
+		auto day = Vacationdb_Bench::main_day;
+
+		for (auto _ : state) {
+			auto report = db.report_vacation_days(day, final_year, 12, 31);
+			benchmark::DoNotOptimize(report);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	BENCHMARK(BM_Report)->Arg(100)->Arg(1000)->Arg(10000)->UseRealTime()->Unit(
+	    benchmark::kMillisecond);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cinttypes>
+#include <vector>
+
+#include "vacationdb.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		// How the balance carries over into a new year. A rollover of 0 drops
+		// what is left, a positive one caps it and a negative one keeps it all.
+		enum class Rollover_Policy : uint8_t { None, Capped, Full };
+
+		// Employees of a single day type whose balance only moves by whole and
+		// partial years of a constant rate, days off and the rollover at each
+		// year start. One lane per employee, every amount is an exact integer
+		// numerator over a scale of the lane's own choosing.
+		struct Batch_Columns_t {
+			size_t lanes = 0;
+			// days_off has a row of lanes for each year in [first_year, query_year)
+			int64_t first_year = 0;
+			int64_t query_year = 0;
+
+			std::vector<int64_t> start_year;
+			std::vector<int64_t> accrual_year;
+			// Gained in accrual_year when that is before the query year
+			std::vector<int64_t> first_gain;
+			// Gained in a whole year
+			std::vector<int64_t> year_gain;
+			// Gained in the query year up to the query date
+			std::vector<int64_t> final_gain;
+			std::vector<int64_t> bonus;
+			std::vector<int64_t> cap;
+			std::vector<int64_t> days_off;
+			// Taken in the query year up to and including the query date
+			std::vector<int64_t> final_days_off;
+
+			// Starts out as the bonus on the first day, ends as the balance
+			std::vector<int64_t> balance;
+
+			void resize(size_t lane_count, int64_t first, int64_t query);
+		};
+
+		VACATIONDB_SHARED void run_batch_scalar(Batch_Columns_t& columns, Rollover_Policy policy);
+		// Only callable when batch_avx2_supported()
+		VACATIONDB_SHARED void run_batch_avx2(Batch_Columns_t& columns, Rollover_Policy policy);
+		VACATIONDB_SHARED bool batch_avx2_supported();
+		// The fastest kernel the processor supports
+		VACATIONDB_SHARED void run_batch(Batch_Columns_t& columns, Rollover_Policy policy);
+	}
+}
@@ -1,24 +1,65 @@
 #pragma once
 
-#include <boost/date_time/gregorian/gregorian_types.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
 
 #include <atomic>
 #include <cinttypes>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <future>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#include "date.hpp"
+#include "metrics.hpp"
+#include "page_store.hpp"
+#include "string_table.hpp"
+#include "thread_pool.hpp"
 #include "vacationdb.hpp"
 
 namespace Vacationdb {
 	namespace _detail {
-		using Date = boost::gregorian::date;
 		using Number = boost::multiprecision::cpp_rational;
 
+		// Records and their containers take their memory from the database's
+		// memory resource. Numbers still keep large values on the global heap.
+		using Allocator = std::pmr::polymorphic_allocator<char>;
+
 		struct Person {
-			std::string name;
+			using allocator_type = Allocator;
+
+			explicit Person(const allocator_type& alloc = {})
+			    : extra_time(alloc), work_time(alloc), days_taken(alloc) {}
+			Person(const Person& other, const allocator_type& alloc)
+			    : name(other.name),
+			      start_date(other.start_date),
+			      percent_time(other.percent_time),
+			      extra_time(other.extra_time, alloc),
+			      work_time(other.work_time, alloc),
+			      days_taken(other.days_taken, alloc),
+			      valid(other.valid) {}
+			Person(Person&& other, const allocator_type& alloc)
+			    : name(other.name),
+			      start_date(std::move(other.start_date)),
+			      percent_time(std::move(other.percent_time)),
+			      extra_time(std::move(other.extra_time), alloc),
+			      work_time(std::move(other.work_time), alloc),
+			      days_taken(std::move(other.days_taken), alloc),
+			      valid(other.valid) {}
+			Person(const Person&) = default;
+			Person(Person&&) = default;
+			Person& operator=(const Person&) = default;
+			Person& operator=(Person&&) = default;
+
+			// In the database's string table
+			Name_ID name = 0;
 			Date start_date;
 			Number percent_time;
 			struct Extra_Time_t {
@@ -27,12 +68,28 @@ namespace Vacationdb {
 				Number percent_time;
 				bool valid = true;
 			};
-			std::vector<Extra_Time_t> extra_time;
+			std::pmr::vector<Extra_Time_t> extra_time;
+			// The effective work percentage built from extra_time: sorted, non
+			// overlapping [begin, end) spans. Outside of them percent_time applies.
+			// Where extra times overlap the most recently added one wins.
+			struct Work_Time_Span_t {
+				Date begin;
+				Date end;
+				Number percent_time;
+			};
+			std::pmr::vector<Work_Time_Span_t> work_time;
+			// Every day off of the person in one flat ledger, sorted by day type
+			// and then by date, so each day type is a contiguous range.
+			// running_total is the sum of value over the day type up to and
+			// including this entry, so any span of days off sums in O(1).
 			struct Day_Taken_t {
+				uint32_t day_type;
 				Date day;
 				Number value;
+				Number running_total;
 			};
-			std::vector<std::vector<Day_Taken_t>> days_taken;
+			using Ledger = std::pmr::vector<Day_Taken_t>;
+			Ledger days_taken;
 			bool valid = true;
 		};
 
@@ -40,7 +97,28 @@ namespace Vacationdb {
 		static_assert(std::is_move_assignable<Person>::value, "Person must be move assignable");
 
 		struct Day {
-			std::string name;
+			using allocator_type = Allocator;
+
+			explicit Day(const allocator_type& alloc = {}) : rules(alloc) {}
+			Day(const Day& other, const allocator_type& alloc)
+			    : name(other.name),
+			      rollover(other.rollover),
+			      yearly_bonus(other.yearly_bonus),
+			      rules(other.rules, alloc),
+			      valid(other.valid) {}
+			Day(Day&& other, const allocator_type& alloc)
+			    : name(other.name),
+			      rollover(std::move(other.rollover)),
+			      yearly_bonus(std::move(other.yearly_bonus)),
+			      rules(std::move(other.rules), alloc),
+			      valid(other.valid) {}
+			Day(const Day&) = default;
+			Day(Day&&) = default;
+			Day& operator=(const Day&) = default;
+			Day& operator=(Day&&) = default;
+
+			// In the database's string table
+			Name_ID name = 0;
 			Number rollover;
 			Number yearly_bonus;
 			struct Day_Rules_Data {
@@ -48,39 +126,372 @@ namespace Vacationdb {
 				Number days_per_year;
 				bool valid = true;
 			};
-			std::vector<Day_Rules_Data> rules;
+			std::pmr::vector<Day_Rules_Data> rules;
 			bool valid = true;
 		};
 
 		static_assert(std::is_move_constructible<Day>::value, "Day must be move constructible");
 		static_assert(std::is_move_assignable<Day>::value, "Day must be move assignable");
 
+		// Picks how accrue_day answers each person and day type. The classification
+		// comes from traits of the person and of the day type, which every edit
+		// keeps up to date. Checkpoints hold the balance right after the rollover
+		// of a year start, so later queries only sweep on from there.
+		class Query_Planner {
+		  public:
+			using Strategy_t = Query_Plan_t::Strategy_t;
+			struct Checkpoint_t {
+				Date date;
+				Number balance;
+			};
+
+			void update_person(size_t person, const Person& record);
+			void update_day(size_t day, const Day& record);
+			Strategy_t classify(size_t person, size_t day) const;
+
+			// The latest checkpoint on or before date
+			bool find_checkpoint(size_t person, size_t day, const Date& date,
+			                     Checkpoint_t& checkpoint);
+			// Only kept if it is later than the one already there
+			void store_checkpoint(size_t person, size_t day, Checkpoint_t checkpoint);
+			void forget(size_t person, size_t day);
+			void forget_person(size_t person);
+			void forget_day(size_t day);
+			void clear();
+			size_t heap_bytes() const;
+
+		  private:
+			enum Trait_t : uint8_t { Work_Time = 1, Several_Rules = 2, Full_Rollover = 4 };
+			std::vector<uint8_t> person_traits;
+			std::vector<uint8_t> day_traits;
+			// Queries on several workers store checkpoints at the same time
+			mutable std::mutex checkpoints_lock;
+			std::unordered_map<uint64_t, Checkpoint_t> checkpoints;
+		};
+
+		class Detail_Cache;
+
+		// Keeps a person's extra times and days off in memory while held
+		class Detail_Pin {
+		  public:
+			Detail_Pin() = default;
+			Detail_Pin(Detail_Cache* detail_cache, size_t pinned)
+			    : cache(detail_cache), person(pinned) {}
+			Detail_Pin(Detail_Pin&& other) noexcept : cache(other.cache), person(other.person) {
+				other.cache = nullptr;
+			}
+			Detail_Pin& operator=(Detail_Pin&& other) noexcept {
+				if (this != &other) {
+					release();
+					cache = other.cache;
+					person = other.person;
+					other.cache = nullptr;
+				}
+				return *this;
+			}
+			Detail_Pin(const Detail_Pin&) = delete;
+			Detail_Pin& operator=(const Detail_Pin&) = delete;
+			~Detail_Pin() {
+				release();
+			}
+
+		  private:
+			void release() noexcept;
+			Detail_Cache* cache = nullptr;
+			size_t person = 0;
+		};
+
+		// The out of core mode. People that nothing has pinned for a while get
+		// their extra times, work time spans and days off written to the page
+		// file and dropped from memory, the least recently used first, until the
+		// rest fits in the limit. Pinning them reads them back in.
+		//
+		// Lazy loads use it without a page file. Everyone starts out only in the
+		// loaded file and is read from there when first pinned.
+		//
+		// Reading someone in happens outside the lock, so several people can be
+		// read in at once. Pinning someone that is being read in waits for it.
+		class Detail_Cache {
+		  public:
+			// Reads a person's details into memory, from wherever a lazy load left them
+			using Source_t = std::function<void(size_t person)>;
+
+			Detail_Cache(std::string page_file, size_t limit, std::pmr::vector<Person>& records);
+			// Without a page file, nothing is ever dropped again
+			explicit Detail_Cache(std::pmr::vector<Person>& records);
+
+			// write marks the person to be written again before they are dropped
+			Detail_Pin pin(size_t person, bool write);
+			void unpin(size_t person) noexcept;
+			// After a load or clear everyone is new and in memory
+			void reset();
+			// After a lazy load everyone is still in source, which holds source_bytes
+			void reset(Source_t source, size_t source_bytes);
+			// Everyone back into memory, before the cache goes away
+			void fault_all();
+			// Holds off faults and evictions while every person is looked at,
+			// once nobody is half read in
+			std::unique_lock<std::mutex> hold() const;
+
+			bool paged() const {
+				return pages != nullptr;
+			}
+			// People a lazy load hasn't read in yet
+			size_t pending() const;
+			Out_Of_Core_Stats_t stats() const;
+			size_t heap_bytes() const;
+
+		  private:
+			struct Slot_t {
+				Page_Store::Extent_t extent;
+				size_t bytes = 0;
+				uint32_t pins = 0;
+				bool resident = true;
+				// Being read in by whoever faulted it, without the lock held
+				bool loading = false;
+				bool in_source = false;
+				bool on_disk = false;
+				bool dirty = true;
+				bool in_lru = false;
+				std::list<size_t>::iterator lru_position;
+			};
+
+			// Unlocks l while reading, the slot has to be looked up again after
+			void fault(size_t person, std::unique_lock<std::mutex>& l);
+			bool evict(size_t person, Slot_t& slot);
+			void evict_over_limit();
+
+			std::pmr::vector<Person>& people;
+			size_t memory_limit;
+			std::unique_ptr<Page_Store> pages;
+			// Taken inside lock, or alone by a fault reading its record
+			std::mutex pages_lock;
+			// Dropped once everyone has been read from it. Faults keep their own
+			// reference while they read.
+			std::shared_ptr<const Source_t> source;
+			size_t source_bytes = 0;
+			size_t in_source = 0;
+
+			mutable std::mutex lock;
+			// Signalled whenever a fault finishes, worked or not
+			mutable std::condition_variable loaded;
+			size_t loading = 0;
+			std::vector<Slot_t> slots;
+			// Unpinned people in memory, the least recently used at the back
+			std::list<size_t> lru;
+			size_t resident_bytes = 0;
+			uint64_t faults = 0;
+			uint64_t evictions = 0;
+		};
+
+		inline void Detail_Pin::release() noexcept {
+			if (cache) {
+				cache->unpin(person);
+				cache = nullptr;
+			}
+		}
+
+		// Years from from to to, each year counted by its own length. Zero if to
+		// isn't after from.
+		Number years_between(const Date& from, const Date& to);
+		// Work time spans from a person's extra times, the latest one added wins
+		void build_work_time(Person& person);
+
 		VACATIONDB_SHARED Date create_date_safe(uint16_t start_year, uint16_t start_month, uint16_t start_day);
 		VACATIONDB_SHARED Number create_number_safe(const char* value);
+		VACATIONDB_SHARED Number create_number_safe(const Rational_t& value);
+		VACATIONDB_SHARED Rational_t create_rational_safe(const Number& value);
 
 		class db_impl {
 		public:
-			db_impl() : io_lock(false) {};
+			explicit db_impl(std::pmr::memory_resource* resource)
+			    : people(resource), day_types(resource), names(resource), io_lock(false) {}
 
-			std::vector<Person> people;
-			std::vector<Day> day_types;
+			std::pmr::vector<Person> people;
+			std::pmr::vector<Day> day_types;
+			String_Table names;
 			void validate(PersonID_t);
 			void validate(PersonID_t, Extra_TimeID_t);
 			void validate(DayID_t);
 			void validate(DayID_t, RuleID_t);
-			void add_day_to_people();
+			// Storing new records, the arguments are already validated
+			size_t add_person(const char* name, Date start_date, Number percent_time);
+			size_t add_extra_time(size_t person, Date begin, Date end, Number percent_time);
+			size_t add_day_type(const char* name, Number rollover, Number yearly_bonus);
+			size_t add_rule(size_t day, uint32_t month_begin, Number days_per_year);
+			void add_day_taken(size_t person, size_t day, Date date, Number value);
+			// Merges many days off into the ledger at once
+			void add_days_taken(size_t person, size_t day,
+			                    std::vector<std::pair<Date, Number>> days);
+
+			// Lookups in the day off ledger are binary searches
+			using Days_Taken_Range =
+			    std::pair<Person::Ledger::const_iterator, Person::Ledger::const_iterator>;
+			Days_Taken_Range days_taken(size_t person, size_t day) const;
+			// Only the days off from from to to, both inclusive
+			Days_Taken_Range days_taken(size_t person, size_t day, const Date& from,
+			                            const Date& to) const;
+			void remove_day_taken(size_t person, size_t day, const Date& date);
+			// Sum of the days off in a range of a single day type
+			static Number days_taken_total(const Person& person, Days_Taken_Range range);
+			std::vector<Date_t> days_taken_list(Days_Taken_Range range) const;
+
+			// Rebuilds the work time spans, then replans the person
+			void rebuild_work_time(size_t person);
+			const Number& work_time_on(size_t person, const Date& date) const;
 			void remove_day_from_people(size_t index);
 
+			// Keeps the planner in step with edits of a person or a day type
+			void replan_person(size_t person);
+			void replan_day(size_t day);
+			Query_Plan_t explain_query(size_t person, size_t day, const Date& query_date) const;
+
+			// Accrued days of a single day type, in closed form or through a sweep
+			// specialized for the person and day type, as the planner decides
+			Number accrue_day(size_t person, size_t day, const Date& query_date) const;
+			// Accrued days for each of the requested day types of one person, in
+			// the same order as the day types were given.
+			std::vector<Number> accrue_days(size_t person, const std::vector<size_t>& days,
+			                                const Date& query_date) const;
+			// Balances of one day type for the employees with a constant rate and
+			// work percentage, through exact integer columns. Returns the positions
+			// that need accrue_day instead.
+			std::vector<size_t> accrue_batch(size_t day, const Date& query_date,
+			                                 const size_t* employees, size_t count,
+			                                 Number* balances) const;
+			// Balances of one day type for the given employees, split between the workers
+			void balances_of(size_t day, const Date& query_date,
+			                 const std::vector<size_t>& employees, std::vector<Number>& balances);
+
+			// Bounds on a balance from a few lookups instead of a sweep. Not every
+			// rollover policy bounds a balance from below.
+			struct Balance_Bounds_t {
+				Number upper;
+				Number lower;
+				bool has_lower;
+			};
+			Balance_Bounds_t balance_bounds(size_t person, size_t day,
+			                                const Date& query_date) const;
+			// Employees whose balance passes scan, in order of employee
+			void scan_balances(size_t day, const Date& query_date, const Number& threshold,
+			                   Balance_Scan_t::Op_t op, std::vector<size_t>& employees,
+			                   std::vector<Number>& balances);
+			// The count highest or lowest balances, best first and ties in order of employee
+			void top_balances(size_t day, const Date& query_date, size_t count, bool highest,
+			                  std::vector<size_t>& employees, std::vector<Number>& balances);
+			// Balances of one day type for every valid employee, in order of employee
+			void report_balances(size_t day, const Date& query_date, std::vector<size_t>& employees,
+			                     std::vector<Number>& balances);
+			std::vector<Employee_Days_t> report_days(size_t day, const Date& query_date);
+			// Days off taken from from to to, both inclusive
+			Number days_used(size_t person, size_t day, const Date& from, const Date& to) const;
+
+			Memory_Usage_t memory_usage() const;
+
+			Person_Info_t employee_info(size_t person) const;
+			std::vector<Person_Info_t> employee_info_list() const;
+
+			// Valid people sorted by name, built when first asked for. Every edit
+			// that adds, renames or removes a person drops it.
+			std::vector<size_t> people_by_name();
+			void invalidate_name_index();
+			mutable std::mutex name_index_lock;
+			std::vector<size_t> name_index;
+			bool name_index_valid = false;
+
+			// Reads handed to the workers. Writers wait for all of them to finish.
+			std::mutex reads_lock;
+			std::condition_variable reads_done;
+			size_t pending_reads = 0;
+			void begin_read();
+			void end_read();
+			void block_for_write();
+
+			template <class F>
+			auto submit_read(F&& f) -> std::future<typename std::result_of<F()>::type> {
+				struct Read_Guard {
+					db_impl* db;
+					~Read_Guard() {
+						db->end_read();
+					}
+				};
+
+				begin_read();
+				db_impl* db = this;
+				return workers().submit([ db, fn = std::forward<F>(f) ]() mutable {
+					Read_Guard guard{db};
+					return fn();
+				});
+			}
+
+			// Balance queries handed to the workers. Everything queued by the time
+			// a worker picks them up is answered together, queries for the same
+			// person and date share a single sweep.
+			struct Batched_Query_t {
+				size_t person;
+				Date date;
+				std::vector<size_t> days;
+				// Receives the balances in the same order as days
+				std::function<void(std::vector<Number>&)> deliver;
+				std::function<void(std::exception_ptr)> fail;
+			};
+			std::mutex batch_lock;
+			std::vector<Batched_Query_t> batch;
+			bool batch_scheduled = false;
+			void submit_query(Batched_Query_t query);
+			void run_query_batch();
+
 			// File loading
 			std::string current_file_name = "vdb.json";
+			// The file of the load or save under way, it becomes current_file_name
+			// once it has worked
+			std::string io_file_name;
 			std::atomic<bool> io_lock;
 			std::atomic<float> io_percentage;
 			std::future<void> io_future;
-			Vacationdb::IO_Status_t::Op_t io_curop = IO_Status_t::NOOP;
+			// Read by get_load_status from other threads while a load or save runs
+			std::atomic<Vacationdb::IO_Status_t::Op_t> io_curop{IO_Status_t::NOOP};
 			void block_if_locked();
 			void load_file();
 			void save_file();
 			void clear();
+
+			// Lazy loads leave everyone's extra times and days off in the file
+			// until they are pinned, warming reads the rest in on the workers
+			// until something is edited
+			bool lazy_load = false;
+			bool warm_lazy_load = false;
+			std::atomic<bool> warm_stop{true};
+			// Several warmers run at once, each takes the next chunk of people from here
+			static constexpr size_t warm_chunk = 64;
+			std::atomic<size_t> warm_next{0};
+			void start_warming();
+			void warm_details();
+			void stop_warming();
+			// Reads the history of the person whose object starts at offset
+			void read_lazy_person(const std::string& contents, size_t offset, size_t day_count,
+			                      size_t person);
+
+			// Recorded from const queries too
+			mutable Metrics metrics;
+			mutable Query_Planner planner;
+
+			// Only there in out of core mode. Everything that looks at a person's
+			// extra times, work time spans or days off holds a pin on them.
+			std::unique_ptr<Detail_Cache> detail_cache;
+			Detail_Pin pin(size_t person, bool write = false) const {
+				if (!detail_cache) {
+					return Detail_Pin{};
+				}
+				return detail_cache->pin(person, write);
+			}
+
+			// Worker threads, only started once something needs them.
+			// Kept last so queued work finishes before anything else is destroyed.
+			size_t thread_count = 0;
+			std::mutex pool_lock;
+			std::unique_ptr<Thread_Pool> pool;
+			Thread_Pool& workers();
 		};
 	}
 }
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cinttypes>
+
+namespace Vacationdb {
+	namespace _detail {
+		namespace date_tables {
+			// Days before the first of each month, for common and leap years
+			constexpr uint16_t month_offsets[2][13] = {
+			    {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365},
+			    {0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366}};
+		}
+
+		constexpr bool is_leap_year(int32_t year) {
+			return (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0));
+		}
+
+		constexpr uint16_t days_in_year(int32_t year) {
+			return is_leap_year(year) ? 366 : 365;
+		}
+
+		// Days before the first of month (1-12) in year
+		constexpr uint16_t month_offset(int32_t year, uint32_t month) {
+			return date_tables::month_offsets[is_leap_year(year)][month - 1];
+		}
+
+		constexpr uint16_t days_in_month(int32_t year, uint32_t month) {
+			return date_tables::month_offsets[is_leap_year(year)][month] -
+			       date_tables::month_offsets[is_leap_year(year)][month - 1];
+		}
+
+		// The range of dates the database has always accepted
+		constexpr bool is_valid_date(int32_t year, uint32_t month, uint32_t day) {
+			return (year >= 1400) && (year <= 9999) && (month >= 1) && (month <= 12) &&
+			       (day >= 1) && (day <= days_in_month(year, month));
+		}
+
+		// A day in the gregorian calendar stored as the number of days since
+		// 1970-01-01, so the difference between two dates is a subtraction.
+		class Date {
+		  public:
+			constexpr Date() : day_number(0) {}
+			constexpr explicit Date(int32_t days) : day_number(days) {}
+			// Does not check the date, see is_valid_date
+			constexpr Date(int32_t year, uint32_t month, uint32_t day)
+			    : day_number(days_before_year(year) + month_offset(year, month) +
+			                 static_cast<int32_t>(day) - 1) {}
+
+			constexpr int32_t days() const {
+				return day_number;
+			}
+
+			constexpr uint16_t year() const {
+				return static_cast<uint16_t>(year_of(day_number));
+			}
+
+			constexpr uint16_t month() const {
+				int32_t y = year_of(day_number);
+				int32_t day_of_year = day_number - days_before_year(y);
+
+				uint32_t m = 1;
+				while (m < 12 && date_tables::month_offsets[is_leap_year(y)][m] <= day_of_year) {
+					++m;
+				}
+				return static_cast<uint16_t>(m);
+			}
+
+			constexpr uint16_t day() const {
+				int32_t y = year_of(day_number);
+				int32_t day_of_year = day_number - days_before_year(y);
+				return static_cast<uint16_t>(day_of_year - month_offset(y, month()) + 1);
+			}
+
+			constexpr int32_t operator-(const Date& rhs) const {
+				return day_number - rhs.day_number;
+			}
+
+			constexpr Date operator+(int32_t days) const {
+				return Date{day_number + days};
+			}
+
+			constexpr bool operator==(const Date& rhs) const {
+				return day_number == rhs.day_number;
+			}
+			constexpr bool operator!=(const Date& rhs) const {
+				return day_number != rhs.day_number;
+			}
+			constexpr bool operator<(const Date& rhs) const {
+				return day_number < rhs.day_number;
+			}
+			constexpr bool operator<=(const Date& rhs) const {
+				return day_number <= rhs.day_number;
+			}
+			constexpr bool operator>(const Date& rhs) const {
+				return day_number > rhs.day_number;
+			}
+			constexpr bool operator>=(const Date& rhs) const {
+				return day_number >= rhs.day_number;
+			}
+
+			// Days from 1970-01-01 to the first of january of year
+			static constexpr int32_t days_before_year(int32_t year) {
+				int32_t y = year - 1;
+				return 365 * (y - 1969) + (floor_div(y, 4) - floor_div(1969, 4)) -
+				       (floor_div(y, 100) - floor_div(1969, 100)) +
+				       (floor_div(y, 400) - floor_div(1969, 400));
+			}
+
+		  private:
+			int32_t day_number;
+
+			static constexpr int32_t floor_div(int32_t a, int32_t b) {
+				return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+			}
+
+			static constexpr int32_t year_of(int32_t days) {
+				// Close estimate from the average year length, then correct it
+				int32_t y = 1970 + floor_div(days * 400, 146097);
+				while (days_before_year(y) > days) {
+					--y;
+				}
+				while (days_before_year(y + 1) <= days) {
+					++y;
+				}
+				return y;
+			}
+		};
+
+		static_assert(sizeof(Date) == 4, "Date must stay 32 bits");
+		static_assert(Date(1970, 1, 1).days() == 0, "Date epoch is 1970-01-01");
+		static_assert(Date(2000, 3, 1) - Date(2000, 2, 1) == 29, "2000 is a leap year");
+		static_assert(Date(2017, 12, 31).month() == 12 && Date(2017, 12, 31).day() == 31,
+		              "Date must round trip");
+
+		// Adds months the same way boost::gregorian::months does. The last day of
+		// a month stays the last day of the month, other days are clamped to it.
+		constexpr Date add_months(const Date& date, int32_t months) {
+			int32_t year = date.year();
+			int32_t month = date.month();
+			int32_t day = date.day();
+			bool end_of_month = (day == days_in_month(year, static_cast<uint32_t>(month)));
+
+			int32_t total = year * 12 + (month - 1) + months;
+			int32_t new_year = total / 12;
+			auto new_month = static_cast<uint32_t>(total % 12 + 1);
+
+			int32_t last_day = days_in_month(new_year, new_month);
+			int32_t new_day = (end_of_month || day > last_day) ? last_day : day;
+
+			return Date{new_year, new_month, static_cast<uint32_t>(new_day)};
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+
+#include "vacationdb.hpp"
+
+// Set to 0 to compile all metrics out of the library
+#ifndef LIBVACATIONDB_METRICS
+	#define LIBVACATIONDB_METRICS 1
+#endif
+
+namespace Vacationdb {
+	namespace _detail {
+		constexpr bool metrics_compiled = LIBVACATIONDB_METRICS != 0;
+
+		// Counters of a single database. Nothing is recorded until they are
+		// enabled, and the storage for the per operation stats is only
+		// allocated then.
+		class VACATIONDB_SHARED Metrics {
+		  public:
+			static constexpr size_t max_operations = 128;
+			static constexpr size_t latency_buckets = 40;
+
+			// Ids are shared between all databases, one per operation name
+			static size_t operation_id(const char* name);
+
+			Metrics() = default;
+			Metrics(const Metrics&) = delete;
+			Metrics& operator=(const Metrics&) = delete;
+			~Metrics();
+
+			bool enabled() const {
+				return metrics_compiled && on.load(std::memory_order_relaxed);
+			}
+			void enable(bool value);
+			void reset();
+
+			void record_operation(size_t id, uint64_t nanoseconds, bool failed);
+			void record_lock_wait(uint64_t nanoseconds);
+			void record_load(uint64_t bytes, uint64_t nanoseconds);
+			void record_save(uint64_t bytes, uint64_t nanoseconds);
+			void record_query(uint64_t events);
+
+			Database_Stats_t snapshot() const;
+			size_t heap_bytes() const;
+
+		  private:
+			struct Operation_Counters {
+				std::atomic<uint64_t> calls{0};
+				std::atomic<uint64_t> errors{0};
+				std::atomic<uint64_t> nanoseconds{0};
+				std::atomic<uint64_t> buckets[latency_buckets] = {};
+			};
+
+			std::atomic<bool> on{false};
+			std::atomic<Operation_Counters*> operations{nullptr};
+
+			std::atomic<uint64_t> lock_waits{0};
+			std::atomic<uint64_t> lock_wait_nanoseconds{0};
+			std::atomic<uint64_t> loads{0};
+			std::atomic<uint64_t> bytes_loaded{0};
+			std::atomic<uint64_t> load_nanoseconds{0};
+			std::atomic<uint64_t> saves{0};
+			std::atomic<uint64_t> bytes_saved{0};
+			std::atomic<uint64_t> save_nanoseconds{0};
+			std::atomic<uint64_t> queries{0};
+			std::atomic<uint64_t> query_events{0};
+			std::atomic<uint64_t> max_query_events{0};
+		};
+
+		inline uint64_t nanoseconds_since(std::chrono::steady_clock::time_point start) {
+			auto elapsed = std::chrono::steady_clock::now() - start;
+			return static_cast<uint64_t>(
+			    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+		}
+
+		// Times a public call and counts it as an error if it leaves by exception
+		class Operation_Scope {
+		  public:
+			Operation_Scope(Metrics& m, size_t operation_id)
+			    : metrics(m.enabled() ? &m : nullptr), id(operation_id) {
+				if (metrics) {
+					exceptions = std::uncaught_exceptions();
+					start = std::chrono::steady_clock::now();
+				}
+			}
+			Operation_Scope(const Operation_Scope&) = delete;
+			Operation_Scope& operator=(const Operation_Scope&) = delete;
+
+			~Operation_Scope() {
+				if (metrics) {
+					bool failed = std::uncaught_exceptions() > exceptions;
+					metrics->record_operation(id, nanoseconds_since(start), failed);
+				}
+			}
+
+		  private:
+			Metrics* metrics;
+			size_t id;
+			int exceptions = 0;
+			std::chrono::steady_clock::time_point start;
+		};
+	}
+}
+
+// Put at the top of a public method to time it under name
+#if LIBVACATIONDB_METRICS
+	#define LIBVACATIONDB_METRIC_SCOPE(metrics, name)                                       \
+		static const size_t metric_operation_id_ =                                          \
+		    ::Vacationdb::_detail::Metrics::operation_id(name);                             \
+		::Vacationdb::_detail::Operation_Scope metric_scope_(metrics, metric_operation_id_)
+#else
+	#define LIBVACATIONDB_METRIC_SCOPE(metrics, name)
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cinttypes>
+#include <fstream>
+#include <map>
+#include <string>
+
+namespace Vacationdb {
+	namespace _detail {
+		// Records kept in a file of fixed size pages. Each record takes a run of
+		// whole pages, freed runs are reused by later records that fit in them.
+		// The file only lives as long as the store.
+		class Page_Store {
+		  public:
+			static constexpr uint32_t page_size = 4096;
+
+			struct Extent_t {
+				uint32_t first_page = 0;
+				uint32_t page_count = 0;
+				uint32_t bytes = 0;
+			};
+
+			// Creates or truncates the file, throws Invalid_File if it can't
+			explicit Page_Store(std::string path);
+			Page_Store(const Page_Store&) = delete;
+			Page_Store& operator=(const Page_Store&) = delete;
+			// Closes and removes the file
+			~Page_Store();
+
+			Extent_t write(const std::string& record);
+			std::string read(const Extent_t& extent);
+			void release(const Extent_t& extent);
+			// Forgets every record
+			void clear();
+
+			uint64_t file_bytes() const;
+
+		  private:
+			std::string path;
+			std::fstream file;
+			uint32_t page_count = 0;
+			// Free runs by their length in pages
+			std::multimap<uint32_t, uint32_t> free_runs;
+		};
+	}
+}
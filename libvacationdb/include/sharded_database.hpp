@@ -0,0 +1,147 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "vacationdb.hpp"
+
+// clang-format off
+
+namespace Vacationdb {
+	namespace _detail {
+		class sharded_impl;
+
+		struct VACATIONDB_SHARED sharded_impl_deleter {
+			void operator()(sharded_impl* value);
+		};
+	}
+
+	// An employee of a sharded database: the shard they are in and their id there
+	struct Shard_PersonID_t {
+		size_t shard;
+		PersonID_t employee;
+	};
+
+	struct Shard_Employee_Days_t {
+		Shard_PersonID_t employee;
+		std::string days;
+	};
+
+	struct Shard_Employee_Days_Value_t {
+		Shard_PersonID_t employee;
+		Rational_t days;
+	};
+
+	// Picks the shard of a new employee from their name. Has to give the same
+	// shard for the same name every time, or employees won't be found again.
+	using Shard_Key_t = std::function<size_t(std::string_view name, size_t shard_count)>;
+
+	// Several databases used as one, such as one per division. Each shard is a
+	// Database of its own with its own file. Calls about one employee go to their
+	// shard, loads, saves and reports run on every shard at once.
+	//
+	// Day types are matched by name between shards, a DayID_t of the sharded
+	// database is the same day type in every shard that has it. Day types are
+	// added to and edited in every shard.
+	class VACATIONDB_SHARED Sharded_Database {
+	  public:
+		// A key of nullptr spreads employees by a hash of their name. A thread count
+		// of 0 uses the amount of hardware threads, split between the shards.
+		explicit Sharded_Database(size_t shard_count, Shard_Key_t key = nullptr, size_t thread_count = 0);
+		Sharded_Database(const Sharded_Database&) = delete;
+		Sharded_Database(Sharded_Database&&) = default;
+		Sharded_Database& operator=(const Sharded_Database&) = delete;
+		Sharded_Database& operator=(Sharded_Database&&) = default;
+		~Sharded_Database() = default;
+
+		size_t    get_shard_count();
+		// For anything only one shard is asked about
+		Database& get_shard      (size_t shard);
+		// The shard's id of a day type, throws Day_Not_Found if the shard doesn't have it
+		DayID_t   get_shard_day  (size_t shard, const DayID_t d);
+
+		// The same name always hashes to the same shard
+		static size_t hash_name(std::string_view name, size_t shard_count);
+
+		////////////////////////////////////////
+		// Operations on individual employees //
+		////////////////////////////////////////
+
+		// Into the shard picked by the key, or into the given one such as a department's
+		Shard_PersonID_t add_employee    (const char * name, uint16_t start_year, uint16_t start_month, uint16_t start_day, const char * work_time);
+		Shard_PersonID_t add_employee    (size_t shard, const char * name, uint16_t start_year, uint16_t start_month, uint16_t start_day, const char * work_time);
+		void             edit_employee_name      (const Shard_PersonID_t employee, const char * name);
+		void             edit_employee_start_date(const Shard_PersonID_t employee, uint16_t start_year, uint16_t start_month, uint16_t start_day);
+		void             edit_employee_work_time (const Shard_PersonID_t employee, const char * work_time);
+		void             delete_employee (const Shard_PersonID_t employee);
+		// Looks through every shard, the first shard that has the name wins
+		Shard_PersonID_t find_employee   (const char * name);
+
+		std::string   get_employee_name (const Shard_PersonID_t employee);
+		Person_Info_t get_employee_info (const Shard_PersonID_t employee);
+		size_t        get_employee_count();
+
+		// In order of shard, then of employee
+		std::vector<Shard_PersonID_t> list_employee_ids();
+
+		/////////////////////////////
+		// Operations on day types //
+		/////////////////////////////
+
+		// Added to every shard that doesn't have a day type of that name yet
+		DayID_t add_day              (const char * name, const char * rollover, const char * yearly_bonus);
+		void    edit_day_rollover    (const DayID_t, const char * rollover);
+		void    edit_day_yearly_bonus(const DayID_t, const char * yearly_bonus);
+		// Rule ids can differ between shards, so they are only had through get_shard
+		void    edit_day_add_rule    (const DayID_t, uint32_t month_start, const char * days_per_year);
+		DayID_t find_day             (const char * name);
+
+		size_t                   get_day_count ();
+		std::vector<std::string> list_day_names();
+
+		//////////////////////////////////////////////////////
+		// Querying the amounts of days that employees have //
+		//////////////////////////////////////////////////////
+
+		void add_day_off   (const Shard_PersonID_t, const DayID_t, uint16_t year, uint16_t month, uint16_t day, const char * value);
+		void add_days_off  (const Shard_PersonID_t, const DayID_t, const std::vector<Date_t>& days);
+		void remove_day_off(const Shard_PersonID_t, const DayID_t, uint16_t year, uint16_t month, uint16_t day);
+
+		std::vector<Date_t>        list_days_off      (const Shard_PersonID_t, const DayID_t);
+
+		std::string                query_vacation_days      (const Shard_PersonID_t p, const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+		std::vector<Person_Days_t> query_vacation_days      (const Shard_PersonID_t p, uint16_t year, uint16_t month, uint16_t day);
+		Rational_t                 query_vacation_days_value(const Shard_PersonID_t p, const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+
+		// Every shard at once, in order of shard and then of employee. Shards
+		// without the day type have nothing to report.
+		std::vector<Shard_Employee_Days_t>       report_vacation_days      (const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+		std::vector<Shard_Employee_Days_Value_t> report_vacation_days_value(const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+		std::vector<Shard_Employee_Days_Value_t> scan_vacation_days        (const DayID_t d, uint16_t year, uint16_t month, uint16_t day, Balance_Scan_t scan);
+		// The count best of every shard merged, ties in order of shard and then of employee
+		std::vector<Shard_Employee_Days_Value_t> top_vacation_days         (const DayID_t d, uint16_t year, uint16_t month, uint16_t day, size_t count, bool highest);
+
+		/////////////////////////////////
+		// Loading/Saving the Database //
+		/////////////////////////////////
+
+		// One file per shard, all read at once, at least one file. There are as many
+		// shards as files afterwards. If any file fails to load, every shard is left
+		// as it was.
+		void load (const std::vector<std::string>& filenames);
+		// One file per shard, all written at once
+		void save (const std::vector<std::string>& filenames);
+		// Back to the files each shard was last loaded from or saved to
+		void save ();
+		void clear_db();
+		std::vector<std::string> get_current_filenames();
+
+	  private:
+#pragma warning( push )
+#pragma warning( disable: 4251 )
+		std::unique_ptr<_detail::sharded_impl, _detail::sharded_impl_deleter> impl;
+#pragma warning( pop )
+	};
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cinttypes>
+#include <deque>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Vacationdb {
+	namespace _detail {
+		using Name_ID = uint32_t;
+
+		// Every distinct employee and day type name, stored once. Ids and views
+		// stay valid until the table is cleared, strings are never removed. A
+		// renamed record leaves its old name behind until the next load builds a
+		// new table out of the names the file still uses.
+		class String_Table {
+		  public:
+			static constexpr Name_ID npos = std::numeric_limits<Name_ID>::max();
+
+			explicit String_Table(std::pmr::memory_resource* resource)
+			    : strings(resource), index(resource) {}
+
+			Name_ID intern(std::string_view value);
+			// npos if the string was never interned
+			Name_ID find(std::string_view value) const;
+			std::string_view view(Name_ID id) const {
+				return strings[id];
+			}
+
+			size_t size() const {
+				return strings.size();
+			}
+			size_t heap_bytes() const;
+			// What dropping the string would free
+			size_t heap_bytes(Name_ID id) const;
+			// Both tables have to use the same memory resource
+			void swap(String_Table& other);
+			void clear();
+
+		  private:
+			// A deque never moves its elements, so views into them stay valid
+			std::pmr::deque<std::pmr::string> strings;
+			std::pmr::unordered_map<std::string_view, Name_ID> index;
+		};
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "vacationdb.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		// A work stealing pool. Every worker owns a queue, it takes work from the
+		// back of its own queue and steals from the front of the others' when it
+		// runs dry. Work submitted from outside the pool is spread round robin.
+		class VACATIONDB_SHARED Thread_Pool {
+		  public:
+			using Task = std::function<void()>;
+
+			// A thread count of 0 uses the amount of hardware threads.
+			explicit Thread_Pool(size_t thread_count = 0);
+			Thread_Pool(const Thread_Pool&) = delete;
+			Thread_Pool& operator=(const Thread_Pool&) = delete;
+			// Finishes all queued work before joining the workers.
+			~Thread_Pool();
+
+			template <class F>
+			auto submit(F&& f) -> std::future<typename std::result_of<F()>::type> {
+				using result_type = typename std::result_of<F()>::type;
+
+				auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(f));
+				auto future = task->get_future();
+				push([task] { (*task)(); });
+
+				return future;
+			}
+
+			// Calls body(begin, end) for chunks of at most grain indices covering
+			// [0, count). The calling thread helps until every chunk is done, so
+			// this may be used from inside the pool. The first exception thrown
+			// by a chunk is rethrown here.
+			template <class F>
+			void parallel_for(size_t count, size_t grain, F&& body) {
+				if (count == 0) {
+					return;
+				}
+				grain = std::max(grain, size_t{1});
+				size_t chunks = (count + grain - 1) / grain;
+
+				std::atomic<size_t> remaining{chunks};
+				std::exception_ptr error;
+				std::mutex error_lock;
+
+				for (size_t c = 0; c < chunks; ++c) {
+					push([&, c] {
+						try {
+							body(c * grain, std::min(count, (c + 1) * grain));
+						}
+						catch (...) {
+							std::lock_guard<std::mutex> l(error_lock);
+							if (!error) {
+								error = std::current_exception();
+							}
+						}
+						remaining.fetch_sub(1);
+					});
+				}
+
+				while (remaining.load() != 0) {
+					if (!run_one()) {
+						std::this_thread::yield();
+					}
+				}
+
+				if (error) {
+					std::rethrow_exception(error);
+				}
+			}
+
+			// Waits for the future while running queued work on this thread.
+			template <class T>
+			void wait(std::future<T>& future) {
+				while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+					if (!run_one()) {
+						future.wait_for(std::chrono::microseconds(100));
+					}
+				}
+			}
+
+			size_t size() const;
+			Thread_Pool_Stats_t stats() const;
+
+		  private:
+			struct Worker_Queue {
+				std::mutex lock;
+				std::deque<Task> tasks;
+			};
+
+			void push(Task task);
+			bool pop(size_t index, Task& task);
+			bool steal(size_t thief, Task& task);
+			bool run_one();
+			void run(Task& task);
+			void worker_loop(size_t index);
+
+			std::vector<std::unique_ptr<Worker_Queue>> queues;
+			std::vector<std::thread> threads;
+
+			std::mutex sleep_lock;
+			std::condition_variable wake;
+			bool stopping = false;
+
+			std::atomic<size_t> queued{0};
+			std::atomic<size_t> next_queue{0};
+			std::atomic<uint64_t> executed{0};
+			std::atomic<uint64_t> steals{0};
+			std::atomic<uint64_t> busy_nanoseconds{0};
+		};
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+
+#include "vacationdb.hpp"
+
+// Set to 0 to compile all trace spans out of the library
+#ifndef LIBVACATIONDB_TRACING
+	#define LIBVACATIONDB_TRACING 1
+#endif
+
+namespace Vacationdb {
+	namespace _detail {
+		constexpr bool tracing_compiled = LIBVACATIONDB_TRACING != 0;
+
+		// Tracing is process wide. Each thread records into its own buffer
+		// without locking, the buffers are only gathered when tracing stops.
+		struct Tracing {
+			static std::atomic<bool> enabled;
+
+			static bool active() {
+				return tracing_compiled && enabled.load(std::memory_order_relaxed);
+			}
+			static void start();
+			// Throws Invalid_File if the trace can't be written
+			static void stop(const char* filename);
+			// name must outlive the trace, in practice it is a string literal
+			static void record(const char* name, std::chrono::steady_clock::time_point begin,
+			                   std::chrono::steady_clock::time_point end);
+		};
+
+		// Records the time from its creation until finish() or destruction
+		class Trace_Span {
+		  public:
+			explicit Trace_Span(const char* span_name)
+			    : name(Tracing::active() ? span_name : nullptr) {
+				if (name) {
+					begin = std::chrono::steady_clock::now();
+				}
+			}
+			Trace_Span(const Trace_Span&) = delete;
+			Trace_Span& operator=(const Trace_Span&) = delete;
+
+			~Trace_Span() {
+				finish();
+			}
+
+			void finish() {
+				if (name) {
+					Tracing::record(name, begin, std::chrono::steady_clock::now());
+					name = nullptr;
+				}
+			}
+
+		  private:
+			const char* name;
+			std::chrono::steady_clock::time_point begin;
+		};
+	}
+}
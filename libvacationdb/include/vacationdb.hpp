@@ -1,8 +1,11 @@
 #pragma once
 
 #include <cinttypes>
+#include <future>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -78,6 +81,12 @@ namespace Vacationdb {
 		}
 	};
 
+	struct Number_Out_Of_Range : public std::exception {
+		virtual const char * what () const noexcept {
+			return "The number does not fit in a Rational_t";
+		}
+	};
+
 	struct Invalid_Index : public std::exception {
 		virtual const char * what () const noexcept {
 			return "The index supplied was invalid";
@@ -96,6 +105,24 @@ namespace Vacationdb {
 		}
 	};
 
+	struct Invalid_File : public std::exception {
+		virtual const char * what () const noexcept {
+			return "The file could not be read or written";
+		}
+	};
+
+	// An exact number for callers that do arithmetic on the results.
+	// Values coming out of the database are in lowest terms with a
+	// positive denominator.
+	struct Rational_t {
+		int64_t numerator;
+		int64_t denominator;
+
+		double to_double() const {
+			return static_cast<double>(numerator) / static_cast<double>(denominator);
+		}
+	};
+
 	// Types to represent an employee
 	VACATIONDB_strong_typedef(size_t, PersonID_t);
 	VACATIONDB_strong_typedef(size_t, Extra_TimeID_t);
@@ -144,6 +171,44 @@ namespace Vacationdb {
 		std::string days;
 	};
 
+	// A type to pass the amount of vacation days of a
+	// particular type for one of many employees
+	struct Employee_Days_t {
+		PersonID_t employee;
+		std::string days;
+	};
+
+	struct Employee_Days_Value_t {
+		PersonID_t employee;
+		Rational_t days;
+	};
+
+	// How a balance query gets answered. CLOSED_FORM needs no sweep at all,
+	// CHECKPOINT resumes from a balance cached at a year start and SWEEP
+	// walks the whole employment.
+	struct Query_Plan_t {
+		enum Strategy_t : uint8_t {
+			CLOSED_FORM = 0,
+			CHECKPOINT = 1,
+			SWEEP = 2
+		};
+		// Kept up to date for every employee and day type as they are edited
+		Strategy_t classification;
+		// What a query on the given date uses right now
+		Strategy_t strategy;
+		// The year a CHECKPOINT strategy resumes from
+		uint16_t checkpoint_year;
+	};
+
+	// A condition on balances for scan_vacation_days
+	struct Balance_Scan_t {
+		enum Op_t : uint8_t {
+			AT_LEAST = 0,
+			AT_MOST = 1
+		} op;
+		Rational_t threshold;
+	};
+
 	// A type to pass the current status of loading/saving
 	struct IO_Status_t {
 		enum Op_t : uint8_t {
@@ -154,6 +219,97 @@ namespace Vacationdb {
 		float percentage;
 	};
 
+	// A type to pass the state of the database's worker threads
+	struct Thread_Pool_Stats_t {
+		size_t thread_count;
+		size_t queue_depth;
+		uint64_t tasks_executed;
+		uint64_t steals;
+		uint64_t busy_nanoseconds;
+	};
+
+	struct Operation_Stats_t {
+		std::string name;
+		uint64_t calls;
+		uint64_t errors;
+		uint64_t total_nanoseconds;
+		// Entry i counts the calls that took [2^i, 2^(i+1)) nanoseconds
+		std::vector<uint64_t> latency_histogram;
+	};
+
+	struct Database_Stats_t {
+		bool enabled;
+		// Only operations that have been called
+		std::vector<Operation_Stats_t> operations;
+		uint64_t lock_waits;
+		uint64_t lock_wait_nanoseconds;
+		uint64_t loads;
+		uint64_t bytes_loaded;
+		uint64_t load_nanoseconds;
+		uint64_t saves;
+		uint64_t bytes_saved;
+		uint64_t save_nanoseconds;
+		uint64_t queries;
+		uint64_t query_events;
+		uint64_t max_query_events;
+	};
+
+	// Bytes held by the database, by what they are used for. Vector slack is
+	// counted with the records. Names are stored once and shared, everything
+	// else held by a deleted record is only counted under tombstoned. Names no
+	// record uses any more, left behind by renames, are only counted under
+	// unused_names until the next load drops them.
+	struct Memory_Usage_t {
+		size_t employees;
+		size_t names;
+		size_t extra_time;
+		size_t days_off;
+		size_t day_types;
+		size_t rules;
+		// Numbers too large to be stored inside the number itself
+		size_t rational_heap;
+		size_t tombstoned;
+		size_t unused_names;
+		// Data derived from the rest, such as work time spans and metrics
+		size_t caches;
+		size_t total;
+	};
+
+	// Out of core mode keeps employees' extra work times and days off in a paged
+	// file and only the most recently used of them in memory
+	struct Out_Of_Core_Config_t {
+		// Created or truncated, and removed again once the mode is turned off
+		std::string page_file;
+		// Bytes of extra work times and days off kept in memory, employees that
+		// queries are using right now stay in memory past it
+		size_t memory_limit;
+	};
+
+	struct Out_Of_Core_Stats_t {
+		bool enabled;
+		size_t resident_employees;
+		size_t resident_bytes;
+		size_t memory_limit;
+		uint64_t page_file_bytes;
+		uint64_t faults;
+		uint64_t evictions;
+	};
+
+	// Lazy loads read the day types and employees' names, start dates and work
+	// percentages up front. An employee's extra work times and days off are
+	// read from the loaded file by the first edit or query that needs them.
+	struct Lazy_Load_Config_t {
+		bool enabled;
+		// Reads in everyone else on the worker threads, until the first edit
+		bool warm_in_background;
+	};
+
+	struct Lazy_Load_Stats_t {
+		bool enabled;
+		// Employees whose extra work times and days off are still only in the file
+		size_t pending_employees;
+	};
+
 	struct Date_t {
 		uint16_t year;
 		uint16_t month;
@@ -164,6 +320,11 @@ namespace Vacationdb {
 	class VACATIONDB_SHARED Database {
 	  public:
 		Database();
+		explicit Database(size_t thread_count);
+		// Records are allocated from resource, which has to outlive the database. Lazy loads
+		// read several employees in at once, so it has to be safe to use from several threads.
+		explicit Database(std::pmr::memory_resource* resource);
+		Database(size_t thread_count, std::pmr::memory_resource* resource);
 		Database(const Database&) = delete;
 		Database(Database&&) = default;
 		Database& operator=(const Database&) = delete;
@@ -175,38 +336,60 @@ namespace Vacationdb {
 		////////////////////////////////////////
 
 		PersonID_t     add_employee                        (const char * name, uint16_t start_year, uint16_t start_month, uint16_t start_day, const char * work_time);
+		PersonID_t     add_employee                        (const char * name, uint16_t start_year, uint16_t start_month, uint16_t start_day, Rational_t work_time);
 		void           edit_employee_name                  (const PersonID_t employee, const char * name);
 		void           edit_employee_start_date            (const PersonID_t employee, uint16_t start_year, uint16_t start_month, uint16_t start_day);
 		void           edit_employee_work_time             (const PersonID_t employee, const char * work_time);
+		void           edit_employee_work_time             (const PersonID_t employee, Rational_t work_time);
+		// The end has to come after the start, Invalid_Date otherwise
 		Extra_TimeID_t edit_employee_add_extra_work_time   (const PersonID_t employee, uint16_t start_year, uint16_t start_month, uint16_t start_day, 
 		                                                    uint16_t end_year, uint16_t end_month, uint16_t end_day, const char * time);
+		Extra_TimeID_t edit_employee_add_extra_work_time   (const PersonID_t employee, uint16_t start_year, uint16_t start_month, uint16_t start_day, 
+		                                                    uint16_t end_year, uint16_t end_month, uint16_t end_day, Rational_t time);
 		void           edit_employee_remove_extra_work_time(const PersonID_t, const Extra_TimeID_t);
 		PersonID_t     find_employee   (const char * name);
 		void           delete_employee (const PersonID_t employee);
 
-		std::string    get_employee_name(const PersonID_t employee);
-		Person_Info_t  get_employee_info(const PersonID_t employee);
-		size_t         get_employee_count();
+		// Name views point into the database's name table. They stay valid until
+		// the database is cleared, loaded or destroyed.
+		std::string      get_employee_name     (const PersonID_t employee);
+		std::string_view get_employee_name_view(const PersonID_t employee);
+		Person_Info_t    get_employee_info     (const PersonID_t employee);
+		size_t           get_employee_count    ();
 
 		std::vector<std::string>   list_employee_names();
 		std::vector<Person_Info_t> list_employee_info();
 
+		// Ids of the valid employees, without building anything else. The name
+		// order comes from an index the database keeps until a name changes.
+		std::vector<PersonID_t>    list_employee_ids        ();
+		std::vector<PersonID_t>    list_employee_ids_by_name();
+		// Employees whose name contains text, in order of name
+		std::vector<PersonID_t>    find_employees_containing(const char * text);
+
+		std::future<std::vector<Person_Info_t>> list_employee_info_async();
+
 		/////////////////////////////
 		// Operations on day types //
 		/////////////////////////////
 
 		DayID_t  add_day               (const char * name, const char * rollover, const char * yearly_bonus);
+		DayID_t  add_day               (const char * name, Rational_t rollover, Rational_t yearly_bonus);
 		void     edit_day_name         (const DayID_t, const char * name);
 		void     edit_day_rollover     (const DayID_t, const char * rollover);
+		void     edit_day_rollover     (const DayID_t, Rational_t rollover);
 		void     edit_day_yearly_bonus (const DayID_t, const char * yearly_bonus);
+		void     edit_day_yearly_bonus (const DayID_t, Rational_t yearly_bonus);
 		RuleID_t edit_day_add_rule     (const DayID_t, uint32_t month_start, const char * days_per_year);
+		RuleID_t edit_day_add_rule     (const DayID_t, uint32_t month_start, Rational_t days_per_year);
 		void     edit_day_remove_rule  (const DayID_t, const RuleID_t);
 		DayID_t  find_day              (const char * name);
 		void     delete_day            (const DayID_t);
 
-		std::string get_day_name(const DayID_t);
-		Day_Info_t  get_day_info(const DayID_t);
-		size_t      get_day_count();
+		std::string      get_day_name     (const DayID_t);
+		std::string_view get_day_name_view(const DayID_t);
+		Day_Info_t       get_day_info     (const DayID_t);
+		size_t           get_day_count    ();
 
 		std::vector<std::string>   list_day_names();
 		std::vector<Day_Info_t>    list_day_info();
@@ -216,13 +399,52 @@ namespace Vacationdb {
 		//////////////////////////////////////////////////////
 
 		void add_day_off   (const PersonID_t, const DayID_t, uint16_t year, uint16_t month, uint16_t day, const char * value);
+		void add_day_off   (const PersonID_t, const DayID_t, uint16_t year, uint16_t month, uint16_t day, Rational_t value);
+		// Same as add_day_off for each of them, but merged in at once. Nothing is
+		// added if any of them is invalid.
+		void add_days_off  (const PersonID_t, const DayID_t, const std::vector<Date_t>& days);
 		void remove_day_off(const PersonID_t, const DayID_t, uint16_t year, uint16_t month, uint16_t day);
 
 		std::vector<Date_t> list_days_off(const PersonID_t, const DayID_t);
+		// Only the days off between the two dates, both inclusive
+		std::vector<Date_t> list_days_off(const PersonID_t, const DayID_t, uint16_t from_year, uint16_t from_month, uint16_t from_day,
+		                                  uint16_t to_year, uint16_t to_month, uint16_t to_day);
 
 		std::string                query_vacation_days(const PersonID_t p, const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
 		std::vector<Person_Days_t> query_vacation_days(const PersonID_t p, uint16_t year, uint16_t month, uint16_t day); 
 
+		std::string                query_work_time    (const PersonID_t p, uint16_t year, uint16_t month, uint16_t day);
+
+		// Total of the days off taken between the two dates, both inclusive
+		std::string                query_days_used    (const PersonID_t p, const DayID_t d, uint16_t from_year, uint16_t from_month, uint16_t from_day,
+		                                               uint16_t to_year, uint16_t to_month, uint16_t to_day);
+
+		std::vector<Employee_Days_t> report_vacation_days(const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+
+		// How query_vacation_days would answer on that date, without running the query
+		Query_Plan_t               explain_query      (const PersonID_t p, const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+
+		// Exact values without going through strings. These throw Number_Out_Of_Range
+		// if the result does not fit in a Rational_t.
+		Rational_t                         query_vacation_days_value (const PersonID_t p, const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+		Rational_t                         query_work_time_value     (const PersonID_t p, uint16_t year, uint16_t month, uint16_t day);
+		Rational_t                         query_days_used_value     (const PersonID_t p, const DayID_t d, uint16_t from_year, uint16_t from_month, uint16_t from_day,
+		                                                              uint16_t to_year, uint16_t to_month, uint16_t to_day);
+		std::vector<Employee_Days_Value_t> report_vacation_days_value(const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+
+		// Only the employees whose balance passes the scan, in order of employee. Scans run on
+		// the worker threads and skip everyone that cheap bounds on their balance rule out.
+		std::vector<Employee_Days_Value_t> scan_vacation_days        (const DayID_t d, uint16_t year, uint16_t month, uint16_t day, Balance_Scan_t scan);
+		// The count highest or lowest balances, best first and ties in order of employee
+		std::vector<Employee_Days_Value_t> top_vacation_days         (const DayID_t d, uint16_t year, uint16_t month, uint16_t day, size_t count, bool highest);
+
+		// Asynchronous versions run on the worker threads. Balance queries issued
+		// together are answered together, sharing work where they can. Edits
+		// wait until every outstanding asynchronous query has finished.
+		std::future<std::string>                  query_vacation_days_async (const PersonID_t p, const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+		std::future<std::vector<Person_Days_t>>   query_vacation_days_async (const PersonID_t p, uint16_t year, uint16_t month, uint16_t day);
+		std::future<std::vector<Employee_Days_t>> report_vacation_days_async(const DayID_t d, uint16_t year, uint16_t month, uint16_t day);
+
 		/////////////////////////////////
 		// Loading/Saving the Database //
 		/////////////////////////////////
@@ -232,10 +454,58 @@ namespace Vacationdb {
 		void        save       (const char * filename);
 		void        save_async (const char * filename);
 		void        clear_db   ();
+		// The file last loaded or saved, a load or save that fails leaves it alone
 		std::string get_current_filename();
 
+		// NOOP once the last load or save has finished, whether it worked or not
 		IO_Status_t get_load_status();
 
+		// Used by the loads after it. A lazy load still reads the whole file, and
+		// keeps it in memory until everyone's extra work times and days off are
+		// parsed out of it.
+		void              set_lazy_load      (const Lazy_Load_Config_t& config);
+		Lazy_Load_Stats_t get_lazy_load_stats();
+
+		////////////////////
+		// Worker threads //
+		////////////////////
+
+		// A thread count of 0 uses the amount of hardware threads
+		void                set_thread_count     (size_t thread_count);
+		Thread_Pool_Stats_t get_thread_pool_stats();
+
+		/////////////
+		// Metrics //
+		/////////////
+
+		// Metrics are off by default and cost next to nothing until enabled.
+		// Building with LIBVACATIONDB_METRICS=0 removes them entirely.
+		void             enable_metrics(bool enabled);
+		Database_Stats_t get_stats     ();
+		void             reset_stats   ();
+		Memory_Usage_t   memory_usage  ();
+
+		/////////////////
+		// Out of core //
+		/////////////////
+
+		// Names, start dates and work percentages stay in memory. Everything else
+		// about an employee is read back from the page file when first needed.
+		// Loads still read the whole file, the limit applies once it is read.
+		void                enable_out_of_core    (const Out_Of_Core_Config_t& config);
+		void                disable_out_of_core   ();
+		Out_Of_Core_Stats_t get_out_of_core_stats ();
+
+		/////////////
+		// Tracing //
+		/////////////
+
+		// Records the phases of loads, saves and queries of every database in the
+		// process. stop_tracing writes them as a Chrome trace event file, which
+		// chrome://tracing and Perfetto can open.
+		static void start_tracing();
+		static void stop_tracing (const char * filename);
+
 	  private:
 #pragma warning( push )
 #pragma warning( disable: 4251 )
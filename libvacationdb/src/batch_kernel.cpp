@@ -0,0 +1,150 @@
+#include <algorithm>
+
+#include "batch_kernel.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define LIBVACATIONDB_BATCH_AVX2 1
+	#include <immintrin.h>
+#else
+	#define LIBVACATIONDB_BATCH_AVX2 0
+#endif
+
+namespace Vacationdb {
+	namespace _detail {
+		void Batch_Columns_t::resize(size_t lane_count, int64_t first, int64_t query) {
+			lanes = lane_count;
+			first_year = first;
+			query_year = query;
+
+			for (auto* column : {&start_year, &accrual_year, &first_gain, &year_gain, &final_gain,
+			                     &bonus, &cap, &final_days_off, &balance}) {
+				column->assign(lanes, 0);
+			}
+			days_off.assign(static_cast<size_t>(std::max<int64_t>(query - first, 0)) * lanes, 0);
+		}
+
+		namespace {
+			template <Rollover_Policy Policy>
+			void run_scalar(Batch_Columns_t& c, size_t from) {
+				for (int64_t year = c.first_year; year < c.query_year; ++year) {
+					auto* off = &c.days_off[static_cast<size_t>(year - c.first_year) * c.lanes];
+
+					for (size_t e = from; e < c.lanes; ++e) {
+						int64_t gain = c.year_gain[e];
+						gain = (year == c.accrual_year[e]) ? c.first_gain[e] : gain;
+						gain = (year < c.accrual_year[e]) ? 0 : gain;
+
+						int64_t next = c.balance[e] + gain - off[e];
+						if (Policy == Rollover_Policy::None) {
+							next = std::min<int64_t>(next, 0);
+						}
+						else if (Policy == Rollover_Policy::Capped) {
+							next = std::min(next, c.cap[e]);
+						}
+						next += c.bonus[e];
+
+						// Years before someone started don't touch their balance
+						c.balance[e] = (c.start_year[e] <= year) ? next : c.balance[e];
+					}
+				}
+
+				for (size_t e = from; e < c.lanes; ++e) {
+					c.balance[e] += c.final_gain[e] - c.final_days_off[e];
+				}
+			}
+
+#if LIBVACATIONDB_BATCH_AVX2
+			__attribute__((target("avx2"))) inline __m256i load4(const int64_t* values) {
+				return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+			}
+
+			// Four lanes at a time, the lanes left over go through the scalar kernel
+			template <Rollover_Policy Policy>
+			__attribute__((target("avx2"))) void run_avx2(Batch_Columns_t& c) {
+				size_t vector_lanes = c.lanes - c.lanes % 4;
+
+				for (int64_t year = c.first_year; year < c.query_year; ++year) {
+					auto* off = &c.days_off[static_cast<size_t>(year - c.first_year) * c.lanes];
+					auto this_year = _mm256_set1_epi64x(year);
+					auto zero = _mm256_setzero_si256();
+
+					for (size_t e = 0; e < vector_lanes; e += 4) {
+						auto accrual_year = load4(&c.accrual_year[e]);
+						auto first = _mm256_cmpeq_epi64(accrual_year, this_year);
+						auto before = _mm256_cmpgt_epi64(accrual_year, this_year);
+						auto gain = _mm256_blendv_epi8(load4(&c.year_gain[e]),
+						                               load4(&c.first_gain[e]), first);
+						gain = _mm256_andnot_si256(before, gain);
+
+						auto balance = load4(&c.balance[e]);
+						auto next = _mm256_add_epi64(balance, gain);
+						next = _mm256_sub_epi64(next, load4(off + e));
+						if (Policy == Rollover_Policy::None) {
+							next = _mm256_andnot_si256(_mm256_cmpgt_epi64(next, zero), next);
+						}
+						else if (Policy == Rollover_Policy::Capped) {
+							auto cap = load4(&c.cap[e]);
+							next = _mm256_blendv_epi8(next, cap, _mm256_cmpgt_epi64(next, cap));
+						}
+						next = _mm256_add_epi64(next, load4(&c.bonus[e]));
+
+						auto not_started = _mm256_cmpgt_epi64(load4(&c.start_year[e]), this_year);
+						balance = _mm256_blendv_epi8(next, balance, not_started);
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(c.balance.data() + e),
+						                    balance);
+					}
+				}
+
+				for (size_t e = 0; e < vector_lanes; ++e) {
+					c.balance[e] += c.final_gain[e] - c.final_days_off[e];
+				}
+				run_scalar<Policy>(c, vector_lanes);
+			}
+#endif
+		}
+
+		void run_batch_scalar(Batch_Columns_t& columns, Rollover_Policy policy) {
+			switch (policy) {
+				case Rollover_Policy::None:
+					return run_scalar<Rollover_Policy::None>(columns, 0);
+				case Rollover_Policy::Capped:
+					return run_scalar<Rollover_Policy::Capped>(columns, 0);
+				default:
+					return run_scalar<Rollover_Policy::Full>(columns, 0);
+			}
+		}
+
+		bool batch_avx2_supported() {
+#if LIBVACATIONDB_BATCH_AVX2
+			static const bool supported = __builtin_cpu_supports("avx2");
+			return supported;
+#else
+			return false;
+#endif
+		}
+
+		void run_batch_avx2(Batch_Columns_t& columns, Rollover_Policy policy) {
+#if LIBVACATIONDB_BATCH_AVX2
+			switch (policy) {
+				case Rollover_Policy::None:
+					return run_avx2<Rollover_Policy::None>(columns);
+				case Rollover_Policy::Capped:
+					return run_avx2<Rollover_Policy::Capped>(columns);
+				default:
+					return run_avx2<Rollover_Policy::Full>(columns);
+			}
+#else
+			run_batch_scalar(columns, policy);
+#endif
+		}
+
+		void run_batch(Batch_Columns_t& columns, Rollover_Policy policy) {
+			if (batch_avx2_supported()) {
+				run_batch_avx2(columns, policy);
+			}
+			else {
+				run_batch_scalar(columns, policy);
+			}
+		}
+	}
+}
@@ -0,0 +1,368 @@
+#include <cstring>
+#include <limits>
+
+#include "database_impl.hpp"
+#include "trace.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		namespace {
+			//////////////////////////////
+			// Records in the page file //
+			//////////////////////////////
+
+			void put_u32(std::string& out, uint32_t value) {
+				char bytes[sizeof(value)];
+				std::memcpy(bytes, &value, sizeof(value));
+				out.append(bytes, sizeof(value));
+			}
+
+			void put_date(std::string& out, const Date& date) {
+				int32_t days = date.days();
+				char bytes[sizeof(days)];
+				std::memcpy(bytes, &days, sizeof(days));
+				out.append(bytes, sizeof(days));
+			}
+
+			void put_number(std::string& out, const Number& value) {
+				auto text = value.convert_to<std::string>();
+				put_u32(out, static_cast<uint32_t>(text.size()));
+				out += text;
+			}
+
+			struct Record_Reader {
+				const std::string& record;
+				size_t offset = 0;
+
+				void take(void* into, size_t size) {
+					if (record.size() - offset < size) {
+						throw Invalid_File();
+					}
+					std::memcpy(into, record.data() + offset, size);
+					offset += size;
+				}
+
+				uint32_t u32() {
+					uint32_t value;
+					take(&value, sizeof(value));
+					return value;
+				}
+
+				Date date() {
+					int32_t days;
+					take(&days, sizeof(days));
+					return Date{days};
+				}
+
+				bool flag() {
+					char value;
+					take(&value, sizeof(value));
+					return value != 0;
+				}
+
+				Number number() {
+					auto size = u32();
+					if (record.size() - offset < size) {
+						throw Invalid_File();
+					}
+					auto text = record.substr(offset, size);
+					offset += size;
+					try {
+						return create_number_safe(text.c_str());
+					}
+					catch (Invalid_Number&) {
+						throw Invalid_File();
+					}
+				}
+			};
+
+			std::string write_record(const Person& person) {
+				std::string out;
+				put_u32(out, static_cast<uint32_t>(person.extra_time.size()));
+				for (auto&& et : person.extra_time) {
+					put_date(out, et.begin);
+					put_date(out, et.end);
+					out += et.valid ? '\1' : '\0';
+					put_number(out, et.percent_time);
+				}
+				put_u32(out, static_cast<uint32_t>(person.work_time.size()));
+				for (auto&& span : person.work_time) {
+					put_date(out, span.begin);
+					put_date(out, span.end);
+					put_number(out, span.percent_time);
+				}
+				put_u32(out, static_cast<uint32_t>(person.days_taken.size()));
+				for (auto&& taken : person.days_taken) {
+					put_u32(out, taken.day_type);
+					put_date(out, taken.day);
+					put_number(out, taken.value);
+					put_number(out, taken.running_total);
+				}
+				return out;
+			}
+
+			void read_record(const std::string& record, Person& person) {
+				Record_Reader r{record};
+
+				auto count = r.u32();
+				person.extra_time.reserve(count);
+				for (uint32_t i = 0; i < count; ++i) {
+					Person::Extra_Time_t et;
+					et.begin = r.date();
+					et.end = r.date();
+					et.valid = r.flag();
+					et.percent_time = r.number();
+					person.extra_time.push_back(std::move(et));
+				}
+
+				count = r.u32();
+				person.work_time.reserve(count);
+				for (uint32_t i = 0; i < count; ++i) {
+					auto begin = r.date();
+					auto end = r.date();
+					person.work_time.push_back(Person::Work_Time_Span_t{begin, end, r.number()});
+				}
+
+				count = r.u32();
+				person.days_taken.reserve(count);
+				for (uint32_t i = 0; i < count; ++i) {
+					auto type = r.u32();
+					auto day = r.date();
+					auto value = r.number();
+					person.days_taken.push_back(
+					    Person::Day_Taken_t{type, day, std::move(value), r.number()});
+				}
+			}
+
+			template <class T>
+			void drop(std::pmr::vector<T>& values) {
+				values.clear();
+				values.shrink_to_fit();
+			}
+
+			size_t detail_bytes(const Person& person) {
+				return person.extra_time.capacity() * sizeof(Person::Extra_Time_t) +
+				       person.work_time.capacity() * sizeof(Person::Work_Time_Span_t) +
+				       person.days_taken.capacity() * sizeof(Person::Day_Taken_t);
+			}
+		}
+
+		Detail_Cache::Detail_Cache(std::string page_file, size_t limit,
+		                           std::pmr::vector<Person>& records)
+		    : people(records), memory_limit(limit), pages(new Page_Store(std::move(page_file))) {}
+
+		Detail_Cache::Detail_Cache(std::pmr::vector<Person>& records)
+		    : people(records), memory_limit(std::numeric_limits<size_t>::max()) {}
+
+		Detail_Pin Detail_Cache::pin(size_t person, bool write) {
+			std::unique_lock<std::mutex> l(lock);
+			// Left for validation to turn down
+			if (person >= people.size()) {
+				return Detail_Pin{};
+			}
+			if (slots.size() <= person) {
+				slots.resize(person + 1);
+			}
+
+			// If that read in fails, this one tries again and throws the same
+			loaded.wait(l, [&] { return !slots[person].loading; });
+			if (!slots[person].resident) {
+				fault(person, l);
+			}
+			auto& slot = slots[person];
+			if (slot.in_lru) {
+				lru.erase(slot.lru_position);
+				slot.in_lru = false;
+			}
+			slot.pins++;
+			slot.dirty = slot.dirty || write;
+			return Detail_Pin{this, person};
+		}
+
+		void Detail_Cache::unpin(size_t person) noexcept {
+			std::lock_guard<std::mutex> l(lock);
+			auto& slot = slots[person];
+			if (--slot.pins != 0) {
+				return;
+			}
+
+			// Edits change the size of what is held
+			auto bytes = detail_bytes(people[person]);
+			resident_bytes = resident_bytes - slot.bytes + bytes;
+			slot.bytes = bytes;
+
+			lru.push_front(person);
+			slot.lru_position = lru.begin();
+			slot.in_lru = true;
+			evict_over_limit();
+		}
+
+		void Detail_Cache::fault(size_t person, std::unique_lock<std::mutex>& l) {
+			Trace_Span span{"out of core: fault"};
+			// Nobody else touches the record until it is resident
+			auto&& record = people[person];
+			auto from = slots[person].in_source ? source : nullptr;
+			auto extent = slots[person].extent;
+			slots[person].loading = true;
+			loading++;
+			l.unlock();
+
+			try {
+				if (from) {
+					// Left in source if it throws, so the next pin throws the same
+					(*from)(person);
+				}
+				else {
+					std::string bytes;
+					{
+						std::lock_guard<std::mutex> p(pages_lock);
+						bytes = pages->read(extent);
+					}
+					read_record(bytes, record);
+				}
+			}
+			catch (...) {
+				l.lock();
+				slots[person].loading = false;
+				loading--;
+				loaded.notify_all();
+				throw;
+			}
+
+			l.lock();
+			auto& slot = slots[person];
+			slot.loading = false;
+			loading--;
+			loaded.notify_all();
+			if (from) {
+				slot.in_source = false;
+				if (--in_source == 0) {
+					source = nullptr;
+					source_bytes = 0;
+				}
+			}
+
+			slot.resident = true;
+			slot.bytes = detail_bytes(record);
+			resident_bytes += slot.bytes;
+			faults++;
+		}
+
+		bool Detail_Cache::evict(size_t person, Slot_t& slot) {
+			auto&& record = people[person];
+
+			// Only written again if it changed since it was last read in
+			if (slot.dirty || !slot.on_disk) {
+				Trace_Span span{"out of core: write back"};
+				std::lock_guard<std::mutex> p(pages_lock);
+				try {
+					auto extent = pages->write(write_record(record));
+					if (slot.on_disk) {
+						pages->release(slot.extent);
+					}
+					slot.extent = extent;
+				}
+				catch (std::exception&) {
+					// Kept in memory, the page file is out of space
+					return false;
+				}
+				slot.on_disk = true;
+				slot.dirty = false;
+			}
+
+			drop(record.extra_time);
+			drop(record.work_time);
+			drop(record.days_taken);
+
+			lru.erase(slot.lru_position);
+			slot.in_lru = false;
+			slot.resident = false;
+			resident_bytes -= slot.bytes;
+			slot.bytes = 0;
+			evictions++;
+			return true;
+		}
+
+		void Detail_Cache::evict_over_limit() {
+			while (pages && resident_bytes > memory_limit && !lru.empty()) {
+				auto person = lru.back();
+				if (!evict(person, slots[person])) {
+					break;
+				}
+			}
+		}
+
+		void Detail_Cache::reset() {
+			std::unique_lock<std::mutex> l(lock);
+			loaded.wait(l, [this] { return loading == 0; });
+			slots.clear();
+			lru.clear();
+			resident_bytes = 0;
+			source = nullptr;
+			source_bytes = 0;
+			in_source = 0;
+			if (pages) {
+				std::lock_guard<std::mutex> p(pages_lock);
+				pages->clear();
+			}
+		}
+
+		void Detail_Cache::reset(Source_t from, size_t bytes) {
+			reset();
+			std::lock_guard<std::mutex> l(lock);
+			if (people.empty()) {
+				return;
+			}
+			source = std::make_shared<const Source_t>(std::move(from));
+			source_bytes = bytes;
+			in_source = people.size();
+
+			Slot_t slot;
+			slot.resident = false;
+			slot.in_source = true;
+			slots.assign(people.size(), slot);
+		}
+
+		void Detail_Cache::fault_all() {
+			std::unique_lock<std::mutex> l(lock);
+			memory_limit = std::numeric_limits<size_t>::max();
+			for (size_t person = 0; person < slots.size() && person < people.size(); ++person) {
+				loaded.wait(l, [&] { return !slots[person].loading; });
+				if (!slots[person].resident) {
+					fault(person, l);
+				}
+			}
+		}
+
+		std::unique_lock<std::mutex> Detail_Cache::hold() const {
+			std::unique_lock<std::mutex> l(lock);
+			loaded.wait(l, [this] { return loading == 0; });
+			return l;
+		}
+
+		size_t Detail_Cache::pending() const {
+			std::lock_guard<std::mutex> l(lock);
+			return in_source;
+		}
+
+		Out_Of_Core_Stats_t Detail_Cache::stats() const {
+			std::lock_guard<std::mutex> l(lock);
+
+			// People never pinned since the last reset are still in memory
+			size_t resident = people.size() > slots.size() ? people.size() - slots.size() : 0;
+			for (auto&& slot : slots) {
+				resident += slot.resident;
+			}
+			uint64_t file_bytes = pages ? pages->file_bytes() : 0;
+			return Out_Of_Core_Stats_t{paged(),    resident, resident_bytes, memory_limit,
+			                           file_bytes, faults,   evictions};
+		}
+
+		size_t Detail_Cache::heap_bytes() const {
+			std::lock_guard<std::mutex> l(lock);
+			// A list node holds the index and two links
+			return slots.capacity() * sizeof(Slot_t) +
+			       lru.size() * (sizeof(size_t) + 2 * sizeof(void*)) + source_bytes;
+		}
+	}
+}
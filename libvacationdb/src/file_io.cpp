@@ -0,0 +1,722 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+#include <rapidjson/reader.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "database_impl.hpp"
+#include "trace.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		namespace {
+			// Version of the file layout written by save_file
+			constexpr uint64_t file_version = 1;
+
+			// However a load or save ends, get_load_status stops reporting it
+			struct Io_Done {
+				std::atomic<IO_Status_t::Op_t>& op;
+				~Io_Done() {
+					op.store(IO_Status_t::NOOP);
+				}
+			};
+
+			///////////////////////////
+			// Writing the JSON file //
+			///////////////////////////
+
+			using Json_Writer = rapidjson::Writer<rapidjson::StringBuffer>;
+
+			void write_string(Json_Writer& w, std::string_view value) {
+				w.String(value.data(), static_cast<rapidjson::SizeType>(value.size()));
+			}
+
+			void write_date(Json_Writer& w, const Date& date) {
+				char buffer[24];
+				int length = std::snprintf(buffer, sizeof(buffer), "%04u-%02u-%02u",
+				                           static_cast<unsigned>(date.year()),
+				                           static_cast<unsigned>(date.month()),
+				                           static_cast<unsigned>(date.day()));
+				w.String(buffer, static_cast<rapidjson::SizeType>(length));
+			}
+
+			void write_number(Json_Writer& w, const Number& value) {
+				write_string(w, value.convert_to<std::string>());
+			}
+
+			void write_day_type(Json_Writer& w, const Day& day_type, const String_Table& names) {
+				w.StartObject();
+				w.Key("name");
+				write_string(w, names.view(day_type.name));
+				w.Key("rollover");
+				write_number(w, day_type.rollover);
+				w.Key("yearly_bonus");
+				write_number(w, day_type.yearly_bonus);
+				w.Key("valid");
+				w.Bool(day_type.valid);
+				w.Key("rules");
+				w.StartArray();
+				for (auto&& rule : day_type.rules) {
+					w.StartObject();
+					w.Key("month_begin");
+					w.Uint(rule.month_begin);
+					w.Key("days_per_year");
+					write_number(w, rule.days_per_year);
+					w.Key("valid");
+					w.Bool(rule.valid);
+					w.EndObject();
+				}
+				w.EndArray();
+				w.EndObject();
+			}
+
+			void write_person(Json_Writer& w, const Person& person, const String_Table& names) {
+				w.StartObject();
+				w.Key("name");
+				write_string(w, names.view(person.name));
+				w.Key("start_date");
+				write_date(w, person.start_date);
+				w.Key("work_time");
+				write_number(w, person.percent_time);
+				w.Key("valid");
+				w.Bool(person.valid);
+				w.Key("extra_time");
+				w.StartArray();
+				for (auto&& et : person.extra_time) {
+					w.StartObject();
+					w.Key("begin");
+					write_date(w, et.begin);
+					w.Key("end");
+					write_date(w, et.end);
+					w.Key("work_time");
+					write_number(w, et.percent_time);
+					w.Key("valid");
+					w.Bool(et.valid);
+					w.EndObject();
+				}
+				w.EndArray();
+				w.Key("days_off");
+				w.StartArray();
+				for (auto&& taken : person.days_taken) {
+					w.StartObject();
+					w.Key("type");
+					w.Uint(taken.day_type);
+					w.Key("date");
+					write_date(w, taken.day);
+					w.Key("amount");
+					write_number(w, taken.value);
+					w.EndObject();
+				}
+				w.EndArray();
+				w.EndObject();
+			}
+
+			///////////////////////////
+			// Reading the JSON file //
+			///////////////////////////
+
+			bool read_date(std::string_view value, Date& date) {
+				std::string text{value};
+				unsigned year, month, day;
+				char tail;
+				if (std::sscanf(text.c_str(), "%u-%u-%u%c", &year, &month, &day, &tail) != 3 ||
+				    !is_valid_date(static_cast<int32_t>(year), month, day)) {
+					return false;
+				}
+				date = Date{static_cast<int32_t>(year), month, day};
+				return true;
+			}
+
+			bool read_number(std::string_view value, Number& number) {
+				try {
+					number = create_number_safe(std::string{value}.c_str());
+					return true;
+				}
+				catch (Invalid_Number&) {
+					return false;
+				}
+			}
+
+			// Handler for rapidjson's Reader that fills in records as their values
+			// come by. Each scope is a record or a list of records of the file
+			// layout. Unknown keys are skipped whatever they hold, a known key
+			// holding the wrong kind of value fails the parse.
+			class Json_Handler {
+			  public:
+				// A whole file. Without history the extra times and days off are only
+				// skipped over and where each person starts goes into offsets, for a
+				// lazy load to come back to.
+				Json_Handler(const rapidjson::StringStream& in,
+				             std::pmr::vector<Person>& people_out,
+				             std::pmr::vector<Day>& day_types_out, String_Table& names_out,
+				             bool read_history)
+				    : stream(in),
+				      people(&people_out),
+				      day_types(&day_types_out),
+				      names(&names_out),
+				      history(read_history) {}
+
+				// Only the extra times and days off of a person a lazy load skipped over
+				Json_Handler(const rapidjson::StringStream& in, Person& person)
+				    : stream(in), history_of(&person), history(true) {}
+
+				uint64_t version = 0;
+				std::vector<size_t> offsets;
+
+				// Sets progress to how far into total bytes the stream is after every person
+				void report_progress(std::atomic<float>& progress, size_t total) {
+					progress_out = &progress;
+					total_bytes = static_cast<float>(total);
+				}
+
+				bool StartObject() {
+					return begin(true);
+				}
+				bool StartArray() {
+					return begin(false);
+				}
+				bool EndObject(rapidjson::SizeType) {
+					return end();
+				}
+				bool EndArray(rapidjson::SizeType) {
+					return end();
+				}
+
+				bool Key(const char* str, rapidjson::SizeType length, bool) {
+					if (skipping == 0) {
+						key.assign(str, length);
+					}
+					return true;
+				}
+
+				bool String(const char* str, rapidjson::SizeType length, bool) {
+					return skipping > 0 || string(std::string_view{str, length});
+				}
+				bool Uint(unsigned value) {
+					return skipping > 0 || uint(value);
+				}
+				bool Bool(bool value) {
+					return skipping > 0 || boolean(value);
+				}
+
+				// Nothing in the file is null, negative, fractional or this large
+				bool Null() {
+					return other();
+				}
+				bool Int(int) {
+					return other();
+				}
+				bool Int64(int64_t) {
+					return other();
+				}
+				bool Uint64(uint64_t) {
+					return other();
+				}
+				bool Double(double) {
+					return other();
+				}
+				bool RawNumber(const char*, rapidjson::SizeType, bool) {
+					return other();
+				}
+
+			  private:
+				enum class Scope {
+					NONE,
+					FILE,
+					DAY_TYPES,
+					DAY_TYPE,
+					RULES,
+					RULE,
+					EMPLOYEES,
+					PERSON,
+					EXTRA_TIMES,
+					EXTRA_TIME,
+					DAYS_OFF,
+					DAY_OFF,
+					// Not scopes, what begin does with an object or array
+					SKIP,
+					INVALID
+				};
+
+				const rapidjson::StringStream& stream;
+				std::pmr::vector<Person>* people = nullptr;
+				std::pmr::vector<Day>* day_types = nullptr;
+				String_Table* names = nullptr;
+				Person* history_of = nullptr;
+				bool history;
+
+				std::vector<Scope> scopes;
+				std::string key;
+				// How deep into a value under an unknown key the parse is
+				size_t skipping = 0;
+
+				std::atomic<float>* progress_out = nullptr;
+				float total_bytes = 0;
+
+				Scope scope() const {
+					return scopes.empty() ? Scope::NONE : scopes.back();
+				}
+
+				Day& day_type() {
+					return day_types->back();
+				}
+
+				Person& person() {
+					return history_of ? *history_of : people->back();
+				}
+
+				// Whether the current key is part of the layout, every element of a list
+				// of records has to be one
+				bool known() const {
+					switch (scope()) {
+						case Scope::FILE:
+							return key == "version" || key == "day_types" || key == "employees";
+						case Scope::DAY_TYPE:
+							return key == "name" || key == "rollover" || key == "yearly_bonus" ||
+							       key == "valid" || key == "rules";
+						case Scope::RULE:
+							return key == "month_begin" || key == "days_per_year" || key == "valid";
+						case Scope::PERSON:
+							if (history_of) {
+								return key == "extra_time" || key == "days_off";
+							}
+							return key == "name" || key == "start_date" || key == "work_time" ||
+							       key == "valid" || key == "extra_time" || key == "days_off";
+						case Scope::EXTRA_TIME:
+							return key == "begin" || key == "end" || key == "work_time" ||
+							       key == "valid";
+						case Scope::DAY_OFF:
+							return key == "type" || key == "date" || key == "amount";
+						default:
+							return true;
+					}
+				}
+
+				// The scope an object or array opens in the current one
+				Scope child(bool object) const {
+					switch (scope()) {
+						case Scope::FILE:
+							if (!object && key == "day_types") {
+								return Scope::DAY_TYPES;
+							}
+							if (!object && key == "employees") {
+								return Scope::EMPLOYEES;
+							}
+							break;
+						case Scope::DAY_TYPES:
+							return object ? Scope::DAY_TYPE : Scope::INVALID;
+						case Scope::DAY_TYPE:
+							if (!object && key == "rules") {
+								return Scope::RULES;
+							}
+							break;
+						case Scope::RULES:
+							return object ? Scope::RULE : Scope::INVALID;
+						case Scope::EMPLOYEES:
+							return object ? Scope::PERSON : Scope::INVALID;
+						case Scope::PERSON:
+							if (!object && key == "extra_time") {
+								return history ? Scope::EXTRA_TIMES : Scope::SKIP;
+							}
+							if (!object && key == "days_off") {
+								return history ? Scope::DAYS_OFF : Scope::SKIP;
+							}
+							break;
+						case Scope::EXTRA_TIMES:
+							return object ? Scope::EXTRA_TIME : Scope::INVALID;
+						case Scope::DAYS_OFF:
+							return object ? Scope::DAY_OFF : Scope::INVALID;
+						default:
+							break;
+					}
+					return known() ? Scope::INVALID : Scope::SKIP;
+				}
+
+				bool begin(bool object) {
+					if (skipping > 0) {
+						++skipping;
+						return true;
+					}
+					if (scopes.empty()) {
+						scopes.push_back(history_of ? Scope::PERSON : Scope::FILE);
+						return object;
+					}
+
+					auto next = child(object);
+					switch (next) {
+						case Scope::SKIP:
+							skipping = 1;
+							return true;
+						case Scope::INVALID:
+							return false;
+						case Scope::DAY_TYPE:
+							day_types->emplace_back();
+							break;
+						case Scope::RULE:
+							day_type().rules.emplace_back();
+							break;
+						case Scope::PERSON:
+							if (!history) {
+								// The reader is just past the brace
+								offsets.push_back(stream.Tell() - 1);
+							}
+							people->emplace_back();
+							break;
+						case Scope::EXTRA_TIME:
+							person().extra_time.emplace_back();
+							break;
+						case Scope::DAY_OFF:
+							person().days_taken.emplace_back();
+							break;
+						default:
+							break;
+					}
+					scopes.push_back(next);
+					return true;
+				}
+
+				bool end() {
+					if (skipping > 0) {
+						--skipping;
+						return true;
+					}
+					if (scope() == Scope::PERSON && progress_out) {
+						progress_out->store(100.0f * static_cast<float>(stream.Tell()) /
+						                    total_bytes);
+					}
+					scopes.pop_back();
+					return true;
+				}
+
+				bool string(std::string_view value) {
+					switch (scope()) {
+						case Scope::DAY_TYPE:
+							if (key == "name") {
+								day_type().name = names->intern(value);
+								return true;
+							}
+							if (key == "rollover") {
+								return read_number(value, day_type().rollover);
+							}
+							if (key == "yearly_bonus") {
+								return read_number(value, day_type().yearly_bonus);
+							}
+							break;
+						case Scope::RULE:
+							if (key == "days_per_year") {
+								return read_number(value, day_type().rules.back().days_per_year);
+							}
+							break;
+						case Scope::PERSON:
+							if (history_of) {
+								break;
+							}
+							if (key == "name") {
+								person().name = names->intern(value);
+								return true;
+							}
+							if (key == "start_date") {
+								return read_date(value, person().start_date);
+							}
+							if (key == "work_time") {
+								return read_number(value, person().percent_time);
+							}
+							break;
+						case Scope::EXTRA_TIME:
+							if (key == "begin") {
+								return read_date(value, person().extra_time.back().begin);
+							}
+							if (key == "end") {
+								return read_date(value, person().extra_time.back().end);
+							}
+							if (key == "work_time") {
+								return read_number(value, person().extra_time.back().percent_time);
+							}
+							break;
+						case Scope::DAY_OFF:
+							if (key == "date") {
+								return read_date(value, person().days_taken.back().day);
+							}
+							if (key == "amount") {
+								return read_number(value, person().days_taken.back().value);
+							}
+							break;
+						default:
+							break;
+					}
+					return !known();
+				}
+
+				bool uint(unsigned value) {
+					switch (scope()) {
+						case Scope::FILE:
+							if (key == "version") {
+								version = value;
+								return true;
+							}
+							break;
+						case Scope::RULE:
+							if (key == "month_begin") {
+								day_type().rules.back().month_begin = value;
+								return true;
+							}
+							break;
+						case Scope::DAY_OFF:
+							if (key == "type") {
+								person().days_taken.back().day_type = value;
+								return true;
+							}
+							break;
+						default:
+							break;
+					}
+					return !known();
+				}
+
+				bool boolean(bool value) {
+					switch (scope()) {
+						case Scope::DAY_TYPE:
+							if (key == "valid") {
+								day_type().valid = value;
+								return true;
+							}
+							break;
+						case Scope::RULE:
+							if (key == "valid") {
+								day_type().rules.back().valid = value;
+								return true;
+							}
+							break;
+						case Scope::PERSON:
+							if (key == "valid" && !history_of) {
+								person().valid = value;
+								return true;
+							}
+							break;
+						case Scope::EXTRA_TIME:
+							if (key == "valid") {
+								person().extra_time.back().valid = value;
+								return true;
+							}
+							break;
+						default:
+							break;
+					}
+					return !known();
+				}
+
+				bool other() {
+					return skipping > 0 || !known();
+				}
+			};
+
+			// Puts days off read from a file into ledger order and fills in the
+			// running totals. Days off on the same date keep their file order.
+			void build_ledger(Person& person) {
+				auto& ledger = person.days_taken;
+				std::stable_sort(ledger.begin(), ledger.end(),
+				                 [](const Person::Day_Taken_t& left,
+				                    const Person::Day_Taken_t& right) {
+					                 if (left.day_type != right.day_type) {
+						                 return left.day_type < right.day_type;
+					                 }
+					                 return left.day < right.day;
+					             });
+
+				for (size_t i = 0; i < ledger.size(); ++i) {
+					ledger[i].running_total = ledger[i].value;
+					if (i > 0 && ledger[i - 1].day_type == ledger[i].day_type) {
+						ledger[i].running_total += ledger[i - 1].running_total;
+					}
+				}
+			}
+		}
+
+		void db_impl::load_file() {
+			Io_Done done{io_curop};
+			auto start = std::chrono::steady_clock::now();
+			Trace_Span span{"load"};
+
+			Trace_Span read_span{"load: read file"};
+			std::ifstream file(io_file_name, std::ios::binary);
+			if (!file) {
+				throw Invalid_File();
+			}
+			std::string contents{std::istreambuf_iterator<char>(file),
+			                     std::istreambuf_iterator<char>()};
+			read_span.finish();
+
+			// Read straight into the database's memory resource
+			std::pmr::vector<Person> new_people{people.get_allocator()};
+			std::pmr::vector<Day> new_day_types{day_types.get_allocator()};
+			String_Table new_names{people.get_allocator().resource()};
+
+			Trace_Span parse_span{"load: parse"};
+			rapidjson::StringStream stream(contents.c_str());
+			Json_Handler handler(stream, new_people, new_day_types, new_names, !lazy_load);
+			handler.report_progress(io_percentage, contents.size());
+			rapidjson::Reader reader;
+			if (reader.Parse(stream, handler).IsError()) {
+				throw Invalid_File();
+			}
+			parse_span.finish();
+
+			if (handler.version != file_version) {
+				throw Invalid_File();
+			}
+			Trace_Span ledger_span{"load: build ledgers"};
+			for (auto& person : new_people) {
+				for (auto&& taken : person.days_taken) {
+					if (taken.day_type >= new_day_types.size()) {
+						throw Invalid_File();
+					}
+				}
+				build_ledger(person);
+			}
+
+			ledger_span.finish();
+
+			// Nothing is replaced unless the whole file was read
+			people = std::move(new_people);
+			day_types = std::move(new_day_types);
+			names.swap(new_names);
+			current_file_name = io_file_name;
+			invalidate_name_index();
+			planner.clear();
+			for (size_t i = 0; i < day_types.size(); ++i) {
+				replan_day(i);
+			}
+
+			auto file_bytes = contents.size();
+			if (lazy_load) {
+				if (!detail_cache) {
+					detail_cache.reset(new Detail_Cache(people));
+				}
+				// Work time and plans are built once a person is read in. Until then
+				// nothing looks at them without pinning them first.
+				auto source = std::make_shared<std::string>(std::move(contents));
+				size_t source_bytes =
+				    source->capacity() + handler.offsets.capacity() * sizeof(size_t);
+				size_t day_count = day_types.size();
+				detail_cache->reset(
+				    [this, source, offsets = std::move(handler.offsets), day_count](size_t p) {
+					    read_lazy_person(*source, offsets[p], day_count, p);
+				    },
+				    source_bytes);
+				for (size_t i = 0; i < people.size(); ++i) {
+					planner.update_person(i, people[i]);
+				}
+
+				warm_stop.store(!warm_lazy_load || detail_cache->paged());
+				if (!warm_stop.load()) {
+					start_warming();
+				}
+			}
+			else {
+				// Every person is paged out again as their work time is rebuilt
+				if (detail_cache && !detail_cache->paged()) {
+					detail_cache.reset();
+				}
+				if (detail_cache) {
+					detail_cache->reset();
+				}
+				for (size_t i = 0; i < people.size(); ++i) {
+					rebuild_work_time(i);
+				}
+			}
+
+			if (metrics.enabled()) {
+				metrics.record_load(file_bytes, nanoseconds_since(start));
+			}
+			io_percentage.store(100);
+		}
+
+		void db_impl::read_lazy_person(const std::string& contents, size_t offset,
+		                               size_t day_count, size_t p) {
+			Trace_Span span{"lazy load: read employee"};
+			Person history{people.get_allocator()};
+			rapidjson::StringStream stream(contents.c_str() + offset);
+			Json_Handler handler(stream, history);
+			rapidjson::Reader reader;
+			if (reader.Parse<rapidjson::kParseStopWhenDoneFlag>(stream, handler).IsError()) {
+				throw Invalid_File();
+			}
+			for (auto&& taken : history.days_taken) {
+				if (taken.day_type >= day_count) {
+					throw Invalid_File();
+				}
+			}
+			build_ledger(history);
+
+			auto& person = people[p];
+			person.extra_time = std::move(history.extra_time);
+			person.days_taken = std::move(history.days_taken);
+			build_work_time(person);
+			planner.update_person(p, person);
+			planner.forget_person(p);
+		}
+
+		void db_impl::save_file() {
+			Io_Done done{io_curop};
+			auto start = std::chrono::steady_clock::now();
+			Trace_Span span{"save"};
+
+			Trace_Span serialize_span{"save: serialize"};
+			rapidjson::StringBuffer out;
+			Json_Writer w(out);
+			w.StartObject();
+			w.Key("version");
+			w.Uint64(file_version);
+
+			w.Key("day_types");
+			w.StartArray();
+			for (auto&& day_type : day_types) {
+				write_day_type(w, day_type, names);
+			}
+			w.EndArray();
+
+			w.Key("employees");
+			w.StartArray();
+			for (size_t i = 0; i < people.size(); ++i) {
+				auto detail = pin(i);
+				write_person(w, people[i], names);
+				io_percentage.store(90.0f * static_cast<float>(i + 1) /
+				                    static_cast<float>(people.size()));
+			}
+			w.EndArray();
+			w.EndObject();
+			serialize_span.finish();
+
+			// Written next to the file and moved over it once complete, so a failed
+			// save leaves the old file as it was
+			Trace_Span write_span{"save: write"};
+			std::string temp_name = io_file_name + ".tmp";
+			std::ofstream file(temp_name, std::ios::binary | std::ios::trunc);
+			file.write(out.GetString(), static_cast<std::streamsize>(out.GetSize()));
+			file.close();
+			if (!file) {
+				std::remove(temp_name.c_str());
+				throw Invalid_File();
+			}
+#if defined(_WIN32)
+			// Windows won't rename over a file that exists
+			std::remove(io_file_name.c_str());
+#endif
+			if (std::rename(temp_name.c_str(), io_file_name.c_str()) != 0) {
+				std::remove(temp_name.c_str());
+				throw Invalid_File();
+			}
+			write_span.finish();
+			current_file_name = io_file_name;
+
+			if (metrics.enabled()) {
+				metrics.record_save(out.GetSize(), nanoseconds_since(start));
+			}
+			io_percentage.store(100);
+		}
+	}
+}
@@ -0,0 +1,153 @@
+#include "database_impl.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		namespace {
+			template <class Backend>
+			size_t limb_heap(const boost::multiprecision::number<Backend>& value) {
+				auto&& backend = value.backend();
+				if (backend.size() <= Backend::internal_limb_count) {
+					return 0;
+				}
+				return backend.size() * sizeof(boost::multiprecision::limb_type);
+			}
+
+			// Based on the limbs in use, capacity isn't visible through the
+			// rational type
+			size_t number_heap(const Number& value) {
+				return limb_heap(boost::multiprecision::numerator(value)) +
+				       limb_heap(boost::multiprecision::denominator(value));
+			}
+
+			template <class T>
+			size_t vector_bytes(const std::pmr::vector<T>& values) {
+				return values.capacity() * sizeof(T);
+			}
+
+			// Everything held by a single person, split into usage categories
+			void count_person(Memory_Usage_t& usage, const Person& person) {
+				usage.rational_heap += number_heap(person.percent_time);
+
+				usage.extra_time += vector_bytes(person.extra_time);
+				for (auto&& extra : person.extra_time) {
+					usage.rational_heap += number_heap(extra.percent_time);
+				}
+
+				usage.caches += vector_bytes(person.work_time);
+				for (auto&& span : person.work_time) {
+					usage.rational_heap += number_heap(span.percent_time);
+				}
+
+				usage.days_off += vector_bytes(person.days_taken);
+				for (auto&& taken : person.days_taken) {
+					usage.rational_heap += number_heap(taken.value);
+					usage.rational_heap += number_heap(taken.running_total);
+				}
+			}
+
+			void count_day(Memory_Usage_t& usage, const Day& day) {
+				usage.rational_heap += number_heap(day.rollover);
+				usage.rational_heap += number_heap(day.yearly_bonus);
+
+				usage.rules += vector_bytes(day.rules);
+				for (auto&& rule : day.rules) {
+					usage.rational_heap += number_heap(rule.days_per_year);
+				}
+			}
+
+			size_t sum(const Memory_Usage_t& usage) {
+				return usage.employees + usage.names + usage.extra_time + usage.days_off +
+				       usage.day_types + usage.rules + usage.rational_heap + usage.tombstoned +
+				       usage.unused_names + usage.caches;
+			}
+		}
+
+		Memory_Usage_t db_impl::memory_usage() const {
+			// Only what is in memory counts, and it can't change while it is counted
+			std::unique_lock<std::mutex> hold;
+			if (detail_cache) {
+				hold = detail_cache->hold();
+			}
+
+			Memory_Usage_t usage{};
+			usage.employees = vector_bytes(people);
+			usage.day_types = vector_bytes(day_types);
+
+			for (auto&& person : people) {
+				if (person.valid) {
+					count_person(usage, person);
+				}
+				else {
+					Memory_Usage_t deleted{};
+					count_person(deleted, person);
+					usage.employees -= sizeof(Person);
+					usage.tombstoned += sizeof(Person) + sum(deleted);
+				}
+
+				// Removed extra times stay in their person's list
+				for (auto&& extra : person.extra_time) {
+					if (!extra.valid && person.valid) {
+						usage.extra_time -= sizeof(Person::Extra_Time_t);
+						usage.rational_heap -= number_heap(extra.percent_time);
+						usage.tombstoned +=
+						    sizeof(Person::Extra_Time_t) + number_heap(extra.percent_time);
+					}
+				}
+			}
+
+			for (auto&& day : day_types) {
+				if (day.valid) {
+					count_day(usage, day);
+				}
+				else {
+					Memory_Usage_t deleted{};
+					count_day(deleted, day);
+					usage.day_types -= sizeof(Day);
+					usage.tombstoned += sizeof(Day) + sum(deleted);
+				}
+
+				for (auto&& rule : day.rules) {
+					if (!rule.valid && day.valid) {
+						usage.rules -= sizeof(Day::Day_Rules_Data);
+						usage.rational_heap -= number_heap(rule.days_per_year);
+						usage.tombstoned +=
+						    sizeof(Day::Day_Rules_Data) + number_heap(rule.days_per_year);
+					}
+				}
+			}
+
+			// Names are shared, so they stay with the names even once deleted
+			usage.names = names.heap_bytes();
+			// Renames leave the old name behind, nothing points at it any more
+			std::vector<bool> used(names.size(), false);
+			for (auto&& person : people) {
+				if (person.name < used.size()) {
+					used[person.name] = true;
+				}
+			}
+			for (auto&& day : day_types) {
+				if (day.name < used.size()) {
+					used[day.name] = true;
+				}
+			}
+			for (Name_ID id = 0; id < names.size(); ++id) {
+				if (!used[id]) {
+					usage.names -= names.heap_bytes(id);
+					usage.unused_names += names.heap_bytes(id);
+				}
+			}
+			usage.caches += metrics.heap_bytes();
+			usage.caches += planner.heap_bytes();
+			{
+				std::lock_guard<std::mutex> l(name_index_lock);
+				usage.caches += name_index.capacity() * sizeof(size_t);
+			}
+			if (detail_cache) {
+				hold.unlock();
+				usage.caches += detail_cache->heap_bytes();
+			}
+			usage.total = sum(usage);
+			return usage;
+		}
+	}
+}
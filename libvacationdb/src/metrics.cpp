@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "metrics.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		namespace {
+			std::mutex names_lock;
+
+			std::vector<std::string>& operation_names() {
+				static std::vector<std::string> names;
+				return names;
+			}
+
+			// Calls taking [2^i, 2^(i+1)) nanoseconds go into bucket i
+			size_t latency_bucket(uint64_t nanoseconds) {
+				size_t bucket = 0;
+				while (nanoseconds > 1) {
+					nanoseconds >>= 1;
+					++bucket;
+				}
+				return std::min(bucket, Metrics::latency_buckets - 1);
+			}
+
+			void store_max(std::atomic<uint64_t>& target, uint64_t value) {
+				auto current = target.load(std::memory_order_relaxed);
+				while (current < value &&
+				       !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+				}
+			}
+		}
+
+		size_t Metrics::operation_id(const char* name) {
+			std::lock_guard<std::mutex> l(names_lock);
+			auto& names = operation_names();
+
+			for (size_t i = 0; i < names.size(); ++i) {
+				if (names[i] == name) {
+					return i;
+				}
+			}
+			// Overflowing operations share the last slot
+			if (names.size() == max_operations - 1) {
+				names.emplace_back("other");
+			}
+			if (names.size() >= max_operations) {
+				return max_operations - 1;
+			}
+			names.emplace_back(name);
+			return names.size() - 1;
+		}
+
+		Metrics::~Metrics() {
+			delete[] operations.load();
+		}
+
+		void Metrics::enable(bool value) {
+			if (!metrics_compiled) {
+				return;
+			}
+
+			if (value && operations.load() == nullptr) {
+				auto* fresh = new Operation_Counters[max_operations];
+				Operation_Counters* expected = nullptr;
+				if (!operations.compare_exchange_strong(expected, fresh)) {
+					delete[] fresh;
+				}
+			}
+			on.store(value);
+		}
+
+		void Metrics::reset() {
+			auto* ops = operations.load();
+			if (ops != nullptr) {
+				for (size_t i = 0; i < max_operations; ++i) {
+					ops[i].calls.store(0);
+					ops[i].errors.store(0);
+					ops[i].nanoseconds.store(0);
+					for (auto& b : ops[i].buckets) {
+						b.store(0);
+					}
+				}
+			}
+
+			for (auto* counter : {&lock_waits, &lock_wait_nanoseconds, &loads, &bytes_loaded,
+			                      &load_nanoseconds, &saves, &bytes_saved, &save_nanoseconds,
+			                      &queries, &query_events, &max_query_events}) {
+				counter->store(0);
+			}
+		}
+
+		void Metrics::record_operation(size_t id, uint64_t nanoseconds, bool failed) {
+			auto* ops = operations.load(std::memory_order_acquire);
+			if (ops == nullptr) {
+				return;
+			}
+
+			auto& op = ops[id];
+			op.calls.fetch_add(1, std::memory_order_relaxed);
+			if (failed) {
+				op.errors.fetch_add(1, std::memory_order_relaxed);
+			}
+			op.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+			op.buckets[latency_bucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void Metrics::record_lock_wait(uint64_t nanoseconds) {
+			lock_waits.fetch_add(1, std::memory_order_relaxed);
+			lock_wait_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+		}
+
+		void Metrics::record_load(uint64_t bytes, uint64_t nanoseconds) {
+			loads.fetch_add(1, std::memory_order_relaxed);
+			bytes_loaded.fetch_add(bytes, std::memory_order_relaxed);
+			load_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+		}
+
+		void Metrics::record_save(uint64_t bytes, uint64_t nanoseconds) {
+			saves.fetch_add(1, std::memory_order_relaxed);
+			bytes_saved.fetch_add(bytes, std::memory_order_relaxed);
+			save_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+		}
+
+		void Metrics::record_query(uint64_t events) {
+			queries.fetch_add(1, std::memory_order_relaxed);
+			query_events.fetch_add(events, std::memory_order_relaxed);
+			store_max(max_query_events, events);
+		}
+
+		size_t Metrics::heap_bytes() const {
+			return operations.load() != nullptr ? sizeof(Operation_Counters) * max_operations : 0;
+		}
+
+		Database_Stats_t Metrics::snapshot() const {
+			Database_Stats_t ret{};
+			ret.enabled = enabled();
+
+			auto* ops = operations.load(std::memory_order_acquire);
+			if (ops != nullptr) {
+				std::vector<std::string> names;
+				{
+					std::lock_guard<std::mutex> l(names_lock);
+					names = operation_names();
+				}
+
+				for (size_t i = 0; i < names.size(); ++i) {
+					auto calls = ops[i].calls.load(std::memory_order_relaxed);
+					if (calls == 0) {
+						continue;
+					}
+
+					Operation_Stats_t op;
+					op.name = names[i];
+					op.calls = calls;
+					op.errors = ops[i].errors.load(std::memory_order_relaxed);
+					op.total_nanoseconds = ops[i].nanoseconds.load(std::memory_order_relaxed);
+					op.latency_histogram.reserve(latency_buckets);
+					for (auto& b : ops[i].buckets) {
+						op.latency_histogram.push_back(b.load(std::memory_order_relaxed));
+					}
+					ret.operations.push_back(std::move(op));
+				}
+			}
+
+			ret.lock_waits = lock_waits.load(std::memory_order_relaxed);
+			ret.lock_wait_nanoseconds = lock_wait_nanoseconds.load(std::memory_order_relaxed);
+			ret.loads = loads.load(std::memory_order_relaxed);
+			ret.bytes_loaded = bytes_loaded.load(std::memory_order_relaxed);
+			ret.load_nanoseconds = load_nanoseconds.load(std::memory_order_relaxed);
+			ret.saves = saves.load(std::memory_order_relaxed);
+			ret.bytes_saved = bytes_saved.load(std::memory_order_relaxed);
+			ret.save_nanoseconds = save_nanoseconds.load(std::memory_order_relaxed);
+			ret.queries = queries.load(std::memory_order_relaxed);
+			ret.query_events = query_events.load(std::memory_order_relaxed);
+			ret.max_query_events = max_query_events.load(std::memory_order_relaxed);
+
+			return ret;
+		}
+	}
+}
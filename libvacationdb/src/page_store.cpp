@@ -0,0 +1,83 @@
+#include <cstdio>
+
+#include "page_store.hpp"
+#include "vacationdb.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		Page_Store::Page_Store(std::string file_path) : path(std::move(file_path)) {
+			file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file) {
+				throw Invalid_File();
+			}
+		}
+
+		Page_Store::~Page_Store() {
+			file.close();
+			std::remove(path.c_str());
+		}
+
+		Page_Store::Extent_t Page_Store::write(const std::string& record) {
+			auto pages = static_cast<uint32_t>((record.size() + page_size - 1) / page_size);
+			pages = pages ? pages : 1;
+
+			// The shortest free run that fits, what is left of it stays free
+			Extent_t extent{page_count, pages, static_cast<uint32_t>(record.size())};
+			auto run = free_runs.lower_bound(pages);
+			if (run != free_runs.end()) {
+				extent.first_page = run->second;
+				if (run->first > pages) {
+					free_runs.emplace(run->first - pages, run->second + pages);
+				}
+				free_runs.erase(run);
+			}
+			else {
+				page_count += pages;
+			}
+
+			file.clear();
+			file.seekp(static_cast<std::streamoff>(extent.first_page) * page_size);
+			file.write(record.data(), static_cast<std::streamsize>(record.size()));
+			// The last page is written out in full so the file always covers it
+			std::string padding(size_t{pages} * page_size - record.size(), '\0');
+			file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+			if (!file) {
+				release(extent);
+				throw Invalid_File();
+			}
+			return extent;
+		}
+
+		std::string Page_Store::read(const Extent_t& extent) {
+			std::string record(extent.bytes, '\0');
+			file.clear();
+			file.flush();
+			file.seekg(static_cast<std::streamoff>(extent.first_page) * page_size);
+			file.read(&record[0], static_cast<std::streamsize>(record.size()));
+			if (!file) {
+				throw Invalid_File();
+			}
+			return record;
+		}
+
+		void Page_Store::release(const Extent_t& extent) {
+			if (extent.page_count != 0) {
+				free_runs.emplace(extent.page_count, extent.first_page);
+			}
+		}
+
+		void Page_Store::clear() {
+			free_runs.clear();
+			page_count = 0;
+			file.close();
+			file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file) {
+				throw Invalid_File();
+			}
+		}
+
+		uint64_t Page_Store::file_bytes() const {
+			return uint64_t{page_count} * page_size;
+		}
+	}
+}
@@ -0,0 +1,955 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+#include "batch_kernel.hpp"
+#include "database_impl.hpp"
+#include "trace.hpp"
+
+#define LIBVACATIONDB_QUERY_DEBUG 0
+
+namespace Vacationdb {
+	namespace _detail {
+		namespace {
+			struct Event_t {
+				Date date;
+				enum Tag_t : uint8_t {
+					Work_Time_Event = 0,
+					Day_Rules_Event = 1,
+					Year_Start_Event = 2,
+					End_of_Query_Event = 3
+				} tag;
+				// Index into the list of requested day types, only meaningful
+				// for day rule events.
+				uint32_t slot;
+				// Points into the person or day type the event came from.
+				const Number* value;
+			};
+
+			// Walks the days off of one day type alongside the sweep. Days off only
+			// ever subtract, so the balance only needs them where it is capped at
+			// a year start and at the end of the query. Everything in between is
+			// taken off in one go using the running totals.
+			struct Days_Off_Cursor {
+				const Person* person;
+				db_impl::Days_Taken_Range remaining;
+
+				// Drops the days off before date without counting them
+				void skip_before(const Date& date) {
+					remaining.first = std::lower_bound(remaining.first, remaining.second, date,
+					                                   [](const Person::Day_Taken_t& e,
+					                                      const Date& d) { return e.day < d; });
+				}
+
+				// Subtracts the days off before date
+				void subtract_before(const Date& date, Number& accrued) {
+					auto cut = std::lower_bound(remaining.first, remaining.second, date,
+					                            [](const Person::Day_Taken_t& e, const Date& d) {
+						                            return e.day < d;
+						                        });
+					subtract(cut, accrued);
+				}
+
+				// Subtracts the days off up to and including date
+				void subtract_through(const Date& date, Number& accrued) {
+					auto cut = std::upper_bound(remaining.first, remaining.second, date,
+					                            [](const Date& d, const Person::Day_Taken_t& e) {
+						                            return d < e.day;
+						                        });
+					subtract(cut, accrued);
+				}
+
+				void subtract(Person::Ledger::const_iterator cut, Number& accrued) {
+					// A single day off is cheaper to take off directly
+					if (cut - remaining.first == 1) {
+						accrued -= remaining.first->value;
+					}
+					else if (cut != remaining.first) {
+						accrued -= (cut - 1)->running_total;
+						if (remaining.first != person->days_taken.begin()) {
+							auto&& before = *(remaining.first - 1);
+							if (before.day_type == remaining.first->day_type) {
+								accrued += before.running_total;
+							}
+						}
+					}
+					remaining.first = cut;
+				}
+			};
+
+			// The state of a single day type during the sweep. The shared work-years
+			// integral is only folded into the balance when something needs it.
+			struct Accumulator_t {
+				const Day* day_type;
+				Days_Off_Cursor days_off;
+				Number accrued{0};
+				Number rate{0};
+				Number work_years_mark{0};
+				void (*roll_over)(Number& accrued, const Day& day_type) = nullptr;
+			};
+
+			bool event_order(const Event_t& left, const Event_t& right) {
+				if (left.date != right.date) {
+					return left.date < right.date;
+				}
+				else {
+					return left.tag < right.tag;
+				}
+			}
+
+			Rollover_Policy rollover_policy(const Day& day_type) {
+				if (day_type.rollover == 0) {
+					return Rollover_Policy::None;
+				}
+				return (day_type.rollover > 0) ? Rollover_Policy::Capped : Rollover_Policy::Full;
+			}
+
+			template <Rollover_Policy Policy>
+			void roll_over(Number& accrued, const Day& day_type) {
+				if (Policy == Rollover_Policy::None) {
+					if (accrued > 0) {
+						accrued = 0;
+					}
+				}
+				else if (Policy == Rollover_Policy::Capped) {
+					if (accrued > day_type.rollover) {
+						accrued = day_type.rollover;
+					}
+				}
+				accrued += day_type.yearly_bonus;
+			}
+
+			void (*select_roll_over(const Day& day_type))(Number&, const Day&) {
+				switch (rollover_policy(day_type)) {
+					case Rollover_Policy::None:
+						return &roll_over<Rollover_Policy::None>;
+					case Rollover_Policy::Capped:
+						return &roll_over<Rollover_Policy::Capped>;
+					default:
+						return &roll_over<Rollover_Policy::Full>;
+				}
+			}
+
+			// A year start on first and on every Jan 1 after it up to the query date.
+			// The one on first is left out when resuming from a checkpoint there.
+			void add_year_starts(std::vector<Event_t>& events, const Date& start_date,
+			                     const Date& query_date, bool include_first) {
+				auto e_t = Event_t::Year_Start_Event;
+				if (include_first) {
+					events.push_back(Event_t{start_date, e_t, 0, nullptr});
+				}
+
+				int32_t start_year = start_date.year();
+				Date working_date;
+				for (int32_t i = 1; (working_date = Date(start_year + i, 1, 1)) <= query_date;
+				     ++i) {
+					events.push_back(Event_t{working_date, e_t, 0, nullptr});
+				}
+			}
+
+			// Where a sweep starts: the start date with nothing accrued, or a
+			// checkpoint right after the rollover of a year start. The sweep hands
+			// back the balance after the last year start it passed.
+			struct Sweep_t {
+				Date from;
+				Number accrued{0};
+				size_t event_count = 0;
+				bool passed_year_start = false;
+				Date year_start;
+				Number year_start_balance;
+			};
+
+			// The sweep for a single day type, specialized on everything about the
+			// person and day type that stays fixed during the query. Between two
+			// events that change the rate, the percentage or the year length only
+			// a day count is kept, so the rational math happens once per segment.
+			template <Rollover_Policy Policy, bool Has_Work_Time, bool Multi_Rule>
+			Number accrue_kernel(const Person& person, const Day& day_type,
+			                     const db_impl::Days_Taken_Range& taken,
+			                     const Date& query_date, Sweep_t& sweep) {
+				bool resumed = sweep.from > person.start_date;
+				size_t num_yse = 2;
+				if (query_date > sweep.from) {
+					num_yse += static_cast<size_t>(query_date.year() - sweep.from.year());
+				}
+				size_t num_wte = Has_Work_Time ? person.work_time.size() * 2 : 0;
+				size_t num_dre = Multi_Rule ? day_type.rules.size() : 0;
+
+				Trace_Span build_span{"query: build events"};
+				std::vector<Event_t> events;
+				events.reserve(num_wte + num_yse + num_dre + 1);
+
+				if (Has_Work_Time) {
+					for (size_t i = 0; i < person.work_time.size(); ++i) {
+						auto&& span = person.work_time[i];
+						events.push_back(
+						    Event_t{span.begin, Event_t::Work_Time_Event, 0, &span.percent_time});
+
+						bool followed = (i + 1 < person.work_time.size()) &&
+						                (person.work_time[i + 1].begin == span.end);
+						if (!followed) {
+							events.push_back(Event_t{span.end, Event_t::Work_Time_Event, 0,
+							                         &person.percent_time});
+						}
+					}
+				}
+
+				// With a single rule the rate is known up front, days only count
+				// once the rule has started. Without any rule nothing accrues.
+				Number rate{0};
+				Date rate_begin{std::numeric_limits<int32_t>::max()};
+				for (auto&& data : day_type.rules) {
+					if (data.valid) {
+						auto date = add_months(person.start_date,
+						                       static_cast<int32_t>(data.month_begin) - 1);
+						if (Multi_Rule) {
+							events.push_back(
+							    Event_t{date, Event_t::Day_Rules_Event, 0, &data.days_per_year});
+						}
+						else {
+							rate = data.days_per_year;
+							rate_begin = date;
+							break;
+						}
+					}
+				}
+
+				add_year_starts(events, sweep.from, query_date, !resumed);
+
+				events.push_back(Event_t{query_date, Event_t::End_of_Query_Event, 0, nullptr});
+				build_span.finish();
+
+				Trace_Span sort_span{"query: sort"};
+				// Rules that start on the same date apply in the order they were added
+				std::stable_sort(events.begin(), events.end(), event_order);
+				sweep.event_count = events.size();
+				sort_span.finish();
+
+				Trace_Span sweep_span{"query: sweep"};
+
+				// Events before a checkpoint only set the rate and the percentage,
+				// nothing accrues before the date the sweep starts from
+				const Number* percent = &person.percent_time;
+				Number accrued = std::move(sweep.accrued);
+				Date current_date = sweep.from;
+				int32_t pending_days = 0;
+				int32_t year_length = resumed ? days_in_year(sweep.from.year()) : 365;
+				Date last_year_start{query_date.year(), 1, 1};
+
+				// Days off before the start of employment do not count, those before
+				// a checkpoint are already in its balance
+				Days_Off_Cursor days_off{&person, taken};
+				days_off.skip_before(sweep.from);
+
+				auto advance = [&](const Date& date) {
+					if (Multi_Rule) {
+						if (date > current_date) {
+							pending_days += date - current_date;
+							current_date = date;
+						}
+					}
+					else {
+						auto from = std::max(current_date, rate_begin);
+						if (date > from) {
+							pending_days += date - from;
+						}
+						current_date = std::max(current_date, date);
+					}
+				};
+
+				auto fold = [&] {
+					if (pending_days != 0) {
+						accrued += rate * *percent * Number{pending_days, year_length};
+						pending_days = 0;
+					}
+				};
+
+				for (auto&& event : events) {
+					switch (event.tag) {
+						case Event_t::Work_Time_Event:
+							advance(event.date);
+							fold();
+							percent = event.value;
+							break;
+
+						case Event_t::Day_Rules_Event:
+							advance(event.date);
+							fold();
+							rate = *event.value;
+							break;
+
+						case Event_t::Year_Start_Event:
+							advance(event.date);
+							fold();
+							days_off.subtract_before(event.date, accrued);
+							roll_over<Policy>(accrued, day_type);
+							year_length = days_in_year(event.date.year());
+							if (event.date == last_year_start && event.date > person.start_date) {
+								sweep.passed_year_start = true;
+								sweep.year_start = event.date;
+								sweep.year_start_balance = accrued;
+							}
+							break;
+
+						case Event_t::End_of_Query_Event:
+							advance(event.date);
+							fold();
+							days_off.subtract_through(event.date, accrued);
+							return accrued;
+
+						default:
+							break;
+					}
+				}
+
+				return accrued;
+			}
+
+			// With full rollover and a single constant rate nothing is ever capped,
+			// so the balance is every bonus and everything accrued less the days off
+			Number accrue_closed_form(const Person& person, const Day& day_type,
+			                          const Number& days_off, const Date& query_date) {
+				if (query_date < person.start_date) {
+					return Number{0};
+				}
+
+				// The start date counts as a year start too
+				int32_t query_year = query_date.year();
+				int32_t start_year = person.start_date.year();
+				Number accrued = day_type.yearly_bonus * (query_year - start_year + 1);
+				accrued -= days_off;
+
+				for (auto&& data : day_type.rules) {
+					if (!data.valid) {
+						continue;
+					}
+
+					auto begin = std::max(person.start_date,
+					                      add_months(person.start_date,
+					                                 static_cast<int32_t>(data.month_begin) - 1));
+					accrued += data.days_per_year * person.percent_time *
+					           years_between(begin, query_date);
+					break;
+				}
+
+				return accrued;
+			}
+
+			using Kernel_t = Number (*)(const Person&, const Day&, const db_impl::Days_Taken_Range&,
+			                            const Date&, Sweep_t&);
+
+			template <Rollover_Policy Policy>
+			Kernel_t select_kernel(bool has_work_time, bool multi_rule) {
+				if (has_work_time) {
+					return multi_rule ? &accrue_kernel<Policy, true, true>
+					                  : &accrue_kernel<Policy, true, false>;
+				}
+				return multi_rule ? &accrue_kernel<Policy, false, true>
+				                  : &accrue_kernel<Policy, false, false>;
+			}
+
+			Kernel_t select_kernel(const Person& person, const Day& day_type) {
+				bool has_work_time = !person.work_time.empty();
+				auto rule_count =
+				    std::count_if(day_type.rules.begin(), day_type.rules.end(),
+				                  [](const Day::Day_Rules_Data& r) { return r.valid; });
+				bool multi_rule = rule_count > 1;
+
+				switch (rollover_policy(day_type)) {
+					case Rollover_Policy::None:
+						return select_kernel<Rollover_Policy::None>(has_work_time, multi_rule);
+					case Rollover_Policy::Capped:
+						return select_kernel<Rollover_Policy::Capped>(has_work_time, multi_rule);
+					default:
+						return select_kernel<Rollover_Policy::Full>(has_work_time, multi_rule);
+				}
+			}
+		}
+
+		void db_impl::replan_person(size_t p) {
+			auto detail = pin(p);
+			planner.update_person(p, people[p]);
+			planner.forget_person(p);
+		}
+
+		void db_impl::replan_day(size_t d) {
+			planner.update_day(d, day_types[d]);
+			planner.forget_day(d);
+		}
+
+		Query_Plan_t db_impl::explain_query(size_t p, size_t d, const Date& query_date) const {
+			// A person a lazy load hasn't read in yet isn't planned yet
+			auto detail = pin(p);
+			Query_Plan_t plan{};
+			plan.classification = planner.classify(p, d);
+			plan.strategy = plan.classification;
+
+			if (plan.classification == Query_Plan_t::CHECKPOINT) {
+				Query_Planner::Checkpoint_t checkpoint;
+				if (planner.find_checkpoint(p, d, query_date, checkpoint)) {
+					plan.checkpoint_year = checkpoint.date.year();
+				}
+				else {
+					plan.strategy = Query_Plan_t::SWEEP;
+				}
+			}
+			return plan;
+		}
+
+		Number years_between(const Date& from, const Date& to) {
+			if (!(from < to)) {
+				return Number{0};
+			}
+
+			int32_t from_year = from.year();
+			int32_t to_year = to.year();
+			if (from_year == to_year) {
+				return Number{to - from, days_in_year(from_year)};
+			}
+
+			Date to_year_start{to_year, 1, 1};
+			return Number{Date(from_year + 1, 1, 1) - from, days_in_year(from_year)} +
+			       (to_year - from_year - 1) +
+			       Number{to - to_year_start, days_in_year(to_year)};
+		}
+
+		Number db_impl::accrue_day(size_t p, size_t d, const Date& query_date) const {
+			auto detail = pin(p);
+			auto&& person = people[p];
+			auto&& day_type = day_types[d];
+			auto strategy = planner.classify(p, d);
+
+			if (strategy == Query_Plan_t::CLOSED_FORM) {
+				auto taken = days_taken(p, d, person.start_date, query_date);
+				auto days_off = days_taken_total(person, taken);
+				auto accrued = accrue_closed_form(person, day_type, days_off, query_date);
+				if (metrics.enabled()) {
+					metrics.record_query(0);
+				}
+				return accrued;
+			}
+
+			Sweep_t sweep;
+			sweep.from = person.start_date;
+			if (strategy == Query_Plan_t::CHECKPOINT) {
+				Query_Planner::Checkpoint_t checkpoint;
+				if (planner.find_checkpoint(p, d, query_date, checkpoint)) {
+					sweep.from = checkpoint.date;
+					sweep.accrued = std::move(checkpoint.balance);
+				}
+			}
+
+			auto kernel = select_kernel(person, day_type);
+			auto accrued = kernel(person, day_type, days_taken(p, d), query_date, sweep);
+
+			if (strategy == Query_Plan_t::CHECKPOINT && sweep.passed_year_start) {
+				Query_Planner::Checkpoint_t checkpoint{sweep.year_start,
+				                                       std::move(sweep.year_start_balance)};
+				planner.store_checkpoint(p, d, std::move(checkpoint));
+			}
+			if (metrics.enabled()) {
+				metrics.record_query(sweep.event_count);
+			}
+			return accrued;
+		}
+
+		std::vector<Number> db_impl::accrue_days(size_t p, const std::vector<size_t>& days,
+		                                         const Date& query_date) const {
+			auto detail = pin(p);
+			if (days.size() == 1) {
+				return std::vector<Number>{accrue_day(p, days[0], query_date)};
+			}
+
+			auto&& person = people[p];
+
+			// Sum up the total amount of events to expect
+			// May overallocate due to invalid events
+			size_t num_wte = person.work_time.size() * 2; // Work time events
+			size_t num_yse = 2;                           // Year start events
+			size_t num_eqe = 1;                           // End of query event
+			if (query_date > person.start_date) {
+				num_yse += static_cast<size_t>(query_date.year() - person.start_date.year());
+			}
+			size_t num_per_day = 0; // Day rule events
+			for (auto&& d : days) {
+				num_per_day += day_types[d].rules.size();
+			}
+
+			Trace_Span build_span{"query: build events"};
+			std::vector<Event_t> events;
+			events.reserve(num_wte + num_yse + num_eqe + num_per_day);
+
+			///////////////////////////////////////////////
+			// Events shared between all the day types   //
+			///////////////////////////////////////////////
+
+			// Add the work time events. The spans never overlap, so a span only
+			// needs an event back to the default if the next one does not follow
+			// directly after it.
+			for (size_t i = 0; i < person.work_time.size(); ++i) {
+				auto&& span = person.work_time[i];
+				events.push_back(
+				    Event_t{span.begin, Event_t::Work_Time_Event, 0, &span.percent_time});
+
+				bool followed = (i + 1 < person.work_time.size()) &&
+				                (person.work_time[i + 1].begin == span.end);
+				if (!followed) {
+					events.push_back(
+					    Event_t{span.end, Event_t::Work_Time_Event, 0, &person.percent_time});
+				}
+			}
+
+			// Add all year start events
+			// Including the one at the beginning of their employment
+			add_year_starts(events, person.start_date, query_date, true);
+
+			// Add the single end of query event
+			events.push_back(Event_t{query_date, Event_t::End_of_Query_Event, 0, nullptr});
+
+			///////////////////////////////////////
+			// Events specific to each day type //
+			///////////////////////////////////////
+
+			std::vector<Accumulator_t> accumulators;
+			accumulators.reserve(days.size());
+
+			for (uint32_t slot = 0; slot < days.size(); ++slot) {
+				auto&& day_type = day_types[days[slot]];
+				accumulators.push_back(
+				    Accumulator_t{&day_type, Days_Off_Cursor{&person, days_taken(p, days[slot])}});
+				accumulators.back().roll_over = select_roll_over(day_type);
+				// Days off before the start of employment do not count
+				accumulators.back().days_off.skip_before(person.start_date);
+
+				// Add all Day Rule Events
+				for (auto&& data : day_type.rules) {
+					if (data.valid) {
+						auto date = add_months(person.start_date,
+						                       static_cast<int32_t>(data.month_begin) - 1);
+
+						events.push_back(
+						    Event_t{date, Event_t::Day_Rules_Event, slot, &data.days_per_year});
+					}
+				}
+			}
+
+			build_span.finish();
+
+			// Sort the structures into chronological order, rules that start on the
+			// same date apply in the order they were added
+			Trace_Span sort_span{"query: sort"};
+			std::stable_sort(events.begin(), events.end(), event_order);
+			sort_span.finish();
+
+			Trace_Span sweep_span{"query: sweep"};
+
+			// Use a state machine to calculate the amount of days accrued.
+			// Everything that scales with the work percentage is tracked once in
+			// work_years, the sum of (days / year length * percent) since the start.
+			// Each day type only multiplies in its own rate when it has to.
+			const Number& default_percent = person.percent_time;
+			Number current_percent = default_percent;
+			Number work_years{0};
+			Date current_date = person.start_date;
+
+			// Length of a year in days
+			const Number year_val{365};
+			const Number leap_year_val{366};
+			const Number* current_year_length = &year_val;
+
+			auto advance = [&](const Date& date) {
+				auto diff_days = date - current_date;
+				if (diff_days > 0) {
+					work_years += Number{diff_days} / *current_year_length * current_percent;
+					current_date = date;
+				}
+			};
+
+			auto sync = [&](Accumulator_t& acc) {
+				if (acc.rate != 0) {
+					acc.accrued += acc.rate * (work_years - acc.work_years_mark);
+				}
+				acc.work_years_mark = work_years;
+			};
+
+			for (auto&& event : events) {
+#if LIBVACATIONDB_QUERY_DEBUG
+				std::cout << "\n----------------------\n"
+				          << event.date.year() << '-' << event.date.month() << '-'
+				          << event.date.day() << " - " << int(event.tag) << " - " << event.slot
+				          << '\n';
+#endif
+
+				switch (event.tag) {
+					case Event_t::Work_Time_Event: {
+						advance(event.date);
+						current_percent = *event.value;
+						break;
+					}
+
+					case Event_t::Day_Rules_Event: {
+						advance(event.date);
+						auto& acc = accumulators[event.slot];
+						sync(acc);
+						acc.rate = *event.value;
+						break;
+					}
+
+					case Event_t::Year_Start_Event: {
+						advance(event.date);
+						for (auto& acc : accumulators) {
+							sync(acc);
+							acc.days_off.subtract_before(event.date, acc.accrued);
+							acc.roll_over(acc.accrued, *acc.day_type);
+						}
+						current_year_length =
+						    is_leap_year(event.date.year()) ? &leap_year_val : &year_val;
+						break;
+					}
+
+					case Event_t::End_of_Query_Event: {
+						advance(event.date);
+						for (auto& acc : accumulators) {
+							sync(acc);
+							acc.days_off.subtract_through(event.date, acc.accrued);
+						}
+						break;
+					}
+					default:
+						break;
+				}
+
+				if (event.tag == Event_t::End_of_Query_Event) {
+					break;
+				}
+			}
+
+			sweep_span.finish();
+			if (metrics.enabled()) {
+				metrics.record_query(events.size());
+			}
+
+			std::vector<Number> ret;
+			ret.reserve(accumulators.size());
+			for (auto& acc : accumulators) {
+				ret.push_back(std::move(acc.accrued));
+			}
+
+			return ret;
+		}
+
+		namespace {
+			// Limits that keep every sum in the batch kernel inside 64 bits
+			constexpr int64_t max_fixed_term = int64_t{1} << 52;
+			constexpr int64_t max_fixed_sum = int64_t{1} << 62;
+			constexpr int64_t max_scale = int64_t{1} << 40;
+			// Every whole year and day count divides evenly with this in the scale
+			constexpr int64_t year_lengths = int64_t{365} * 366;
+
+			// Grows scale into a multiple of value's denominator
+			bool scale_for(const Number& value, int64_t& scale) {
+				auto&& den = boost::multiprecision::denominator(value);
+				if (den > max_scale) {
+					return false;
+				}
+				auto d = den.convert_to<int64_t>();
+				auto factor = d / std::gcd(scale, d);
+				if (factor > max_scale / scale) {
+					return false;
+				}
+				scale *= factor;
+				return true;
+			}
+
+			// value * scale, which has to be a multiple of value's denominator
+			bool to_fixed(const Number& value, int64_t scale, int64_t& out) {
+				auto&& num = boost::multiprecision::numerator(value);
+				if (num >= max_fixed_term || num <= -max_fixed_term) {
+					return false;
+				}
+				auto n = num.convert_to<int64_t>();
+				auto den = boost::multiprecision::denominator(value).convert_to<int64_t>();
+				auto factor = scale / den;
+				if (n != 0 && (n < 0 ? -n : n) > max_fixed_term / factor) {
+					return false;
+				}
+				out = n * factor;
+				return true;
+			}
+
+			// Everything about one lane that doesn't go into the columns
+			struct Batch_Lane_t {
+				size_t position;
+				int64_t scale;
+				db_impl::Days_Taken_Range days_off;
+			};
+		}
+
+		std::vector<size_t> db_impl::accrue_batch(size_t d, const Date& query_date,
+		                                          const size_t* employees, size_t count,
+		                                          Number* balances) const {
+			auto&& day_type = day_types[d];
+			std::vector<size_t> rest;
+
+			std::vector<Detail_Pin> pins;
+			if (detail_cache) {
+				pins.reserve(count);
+				for (size_t i = 0; i < count; ++i) {
+					pins.push_back(pin(employees[i]));
+				}
+			}
+
+			const Day::Day_Rules_Data* rule = nullptr;
+			for (auto&& data : day_type.rules) {
+				if (data.valid) {
+					rule = rule ? nullptr : &data;
+					if (!rule) {
+						break;
+					}
+				}
+			}
+			if (!rule || count == 0) {
+				for (size_t i = 0; i < count; ++i) {
+					rest.push_back(i);
+				}
+				return rest;
+			}
+
+			// Only a constant rate and work percentage for the whole time
+			std::vector<Batch_Lane_t> lanes;
+			lanes.reserve(count);
+			int64_t first_year = query_date.year();
+			for (size_t i = 0; i < count; ++i) {
+				auto&& person = people[employees[i]];
+				if (!person.work_time.empty() || query_date < person.start_date) {
+					rest.push_back(i);
+					continue;
+				}
+
+				auto range = days_taken(employees[i], d, person.start_date, query_date);
+				auto denominator = boost::multiprecision::denominator(person.percent_time) *
+				                   boost::multiprecision::denominator(rule->days_per_year);
+				bool fits = denominator <= max_scale / year_lengths;
+				int64_t scale = fits ? denominator.convert_to<int64_t>() * year_lengths : 1;
+				fits = fits && scale_for(day_type.yearly_bonus, scale) &&
+				       scale_for(day_type.rollover, scale);
+				for (auto it = range.first; fits && it != range.second; ++it) {
+					fits = scale_for(it->value, scale);
+				}
+
+				if (!fits) {
+					rest.push_back(i);
+					continue;
+				}
+				lanes.push_back(Batch_Lane_t{i, scale, range});
+				first_year = std::min<int64_t>(first_year, person.start_date.year());
+			}
+
+			Batch_Columns_t columns;
+			int64_t query_year = query_date.year();
+			columns.resize(lanes.size(), first_year, query_year);
+			std::vector<bool> fits(lanes.size(), true);
+
+			for (size_t l = 0; l < lanes.size(); ++l) {
+				auto&& lane = lanes[l];
+				auto&& person = people[employees[lane.position]];
+
+				auto accrual = std::max(person.start_date,
+				                        add_months(person.start_date,
+				                                   static_cast<int32_t>(rule->month_begin) - 1));
+				int64_t accrual_year = accrual.year();
+				columns.start_year[l] = person.start_date.year();
+				columns.accrual_year[l] = accrual_year;
+
+				int64_t gain = 0;
+				bool ok = to_fixed(rule->days_per_year * person.percent_time, lane.scale, gain) &&
+				          to_fixed(day_type.yearly_bonus, lane.scale, columns.bonus[l]) &&
+				          to_fixed(day_type.rollover, lane.scale, columns.cap[l]);
+				columns.year_gain[l] = gain;
+
+				if (accrual_year < query_year) {
+					auto days = Date(static_cast<int32_t>(accrual_year) + 1, 1, 1) - accrual;
+					columns.first_gain[l] = gain / days_in_year(accrual.year()) * days;
+				}
+				if (accrual <= query_date) {
+					auto from = std::max(accrual, Date(query_date.year(), 1, 1));
+					columns.final_gain[l] =
+					    gain / days_in_year(query_date.year()) * (query_date - from);
+				}
+				// The bonus of the first day, the kernel takes care of the rest
+				columns.balance[l] = columns.bonus[l];
+
+				// Bound every partial sum the kernel can reach
+				auto years = query_year - columns.start_year[l] + 1;
+				int64_t per_year = std::abs(gain) + std::abs(columns.bonus[l]);
+				ok = ok && per_year < max_fixed_sum / years;
+				int64_t total = ok ? per_year * years + std::abs(columns.cap[l]) : 0;
+				for (auto it = lane.days_off.first; ok && it != lane.days_off.second; ++it) {
+					int64_t value = 0;
+					ok = to_fixed(it->value, lane.scale, value);
+					total += std::abs(value);
+					ok = ok && total < max_fixed_sum;
+
+					int64_t year = it->day.year();
+					if (year < query_year) {
+						auto row = static_cast<size_t>(year - first_year);
+						columns.days_off[row * columns.lanes + l] += value;
+					}
+					else {
+						columns.final_days_off[l] += value;
+					}
+				}
+				fits[l] = ok && total < max_fixed_sum;
+			}
+
+			{
+				Trace_Span span{"report: batch kernel"};
+				run_batch(columns, rollover_policy(day_type));
+			}
+
+			for (size_t l = 0; l < lanes.size(); ++l) {
+				if (fits[l]) {
+					balances[lanes[l].position] = Number{columns.balance[l], lanes[l].scale};
+				}
+				else {
+					rest.push_back(lanes[l].position);
+				}
+			}
+			return rest;
+		}
+
+		void db_impl::report_balances(size_t d, const Date& query_date,
+		                              std::vector<size_t>& employees,
+		                              std::vector<Number>& balances) {
+			employees.clear();
+			employees.reserve(people.size());
+			for (size_t i = 0; i < people.size(); ++i) {
+				if (people[i].valid) {
+					employees.push_back(i);
+				}
+			}
+
+			Trace_Span span{"report: balances"};
+			balances_of(d, query_date, employees, balances);
+		}
+
+		void db_impl::balances_of(size_t d, const Date& query_date,
+		                          const std::vector<size_t>& employees,
+		                          std::vector<Number>& balances) {
+			balances.resize(employees.size());
+
+			// Employees are independent, so they are split between the workers
+			workers().parallel_for(employees.size(), 64, [&](size_t begin, size_t end) {
+				Trace_Span chunk_span{"report: chunk"};
+				// Plain employees are answered together, the rest are swept one by one
+				auto rest = accrue_batch(d, query_date, &employees[begin], end - begin,
+				                         &balances[begin]);
+				for (auto i : rest) {
+					balances[begin + i] = accrue_day(employees[begin + i], d, query_date);
+				}
+			});
+		}
+
+		std::vector<Employee_Days_t> db_impl::report_days(size_t d, const Date& query_date) {
+			std::vector<size_t> employees;
+			std::vector<Number> balances;
+			report_balances(d, query_date, employees, balances);
+
+			Trace_Span span{"report: to string"};
+			std::vector<Employee_Days_t> ret(employees.size());
+			workers().parallel_for(ret.size(), 256, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					ret[i].employee = PersonID_t{employees[i]};
+					ret[i].days = balances[i].convert_to<std::string>();
+				}
+			});
+
+			return ret;
+		}
+
+		Number db_impl::days_used(size_t p, size_t d, const Date& from, const Date& to) const {
+			auto detail = pin(p);
+			return days_taken_total(people[p], days_taken(p, d, from, to));
+		}
+
+		void db_impl::submit_query(Batched_Query_t query) {
+			begin_read();
+
+			std::lock_guard<std::mutex> l(batch_lock);
+			batch.push_back(std::move(query));
+			if (!batch_scheduled) {
+				batch_scheduled = true;
+				workers().submit([this] { run_query_batch(); });
+			}
+		}
+
+		void db_impl::run_query_batch() {
+			Trace_Span span{"query batch"};
+			std::vector<Batched_Query_t> queries;
+			{
+				std::lock_guard<std::mutex> l(batch_lock);
+				queries.swap(batch);
+				batch_scheduled = false;
+			}
+
+			std::vector<size_t> order(queries.size());
+			for (size_t i = 0; i < order.size(); ++i) {
+				order[i] = i;
+			}
+			std::sort(order.begin(), order.end(), [&queries](size_t left, size_t right) {
+				if (queries[left].person != queries[right].person) {
+					return queries[left].person < queries[right].person;
+				}
+				return queries[left].date < queries[right].date;
+			});
+
+			for (size_t first = 0; first < order.size();) {
+				auto&& lead = queries[order[first]];
+				size_t last = first;
+				while (last < order.size() && queries[order[last]].person == lead.person &&
+				       queries[order[last]].date == lead.date) {
+					++last;
+				}
+
+				// Every day type asked for by someone in the group
+				std::vector<size_t> days;
+				for (size_t i = first; i < last; ++i) {
+					auto&& q = queries[order[i]];
+					days.insert(days.end(), q.days.begin(), q.days.end());
+				}
+				std::sort(days.begin(), days.end());
+				days.erase(std::unique(days.begin(), days.end()), days.end());
+
+				std::vector<Number> accrued;
+				std::exception_ptr error;
+				try {
+					accrued = accrue_days(lead.person, days, lead.date);
+				}
+				catch (...) {
+					error = std::current_exception();
+				}
+
+				for (size_t i = first; i < last; ++i) {
+					auto&& q = queries[order[i]];
+
+					if (error) {
+						q.fail(error);
+					}
+					else {
+						std::vector<Number> values;
+						values.reserve(q.days.size());
+						for (auto&& d : q.days) {
+							auto pos = std::lower_bound(days.begin(), days.end(), d) - days.begin();
+							values.push_back(accrued[static_cast<size_t>(pos)]);
+						}
+						q.deliver(values);
+					}
+					end_read();
+				}
+
+				first = last;
+			}
+		}
+	}
+}
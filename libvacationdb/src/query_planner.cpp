@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <mutex>
+
+#include "database_impl.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		namespace {
+			uint64_t checkpoint_key(size_t person, size_t day) {
+				return (static_cast<uint64_t>(person) << 32) | static_cast<uint64_t>(day);
+			}
+
+			void set_trait(std::vector<uint8_t>& traits, size_t index, uint8_t value) {
+				if (traits.size() <= index) {
+					traits.resize(index + 1, 0);
+				}
+				traits[index] = value;
+			}
+		}
+
+		void Query_Planner::update_person(size_t person, const Person& record) {
+			set_trait(person_traits, person,
+			          static_cast<uint8_t>(record.work_time.empty() ? 0 : Work_Time));
+		}
+
+		void Query_Planner::update_day(size_t day, const Day& record) {
+			auto rules = std::count_if(record.rules.begin(), record.rules.end(),
+			                           [](const Day::Day_Rules_Data& r) { return r.valid; });
+
+			uint8_t traits = 0;
+			if (rules > 1) {
+				traits |= Several_Rules;
+			}
+			if (record.rollover < 0) {
+				traits |= Full_Rollover;
+			}
+			set_trait(day_traits, day, traits);
+		}
+
+		Query_Planner::Strategy_t Query_Planner::classify(size_t person, size_t day) const {
+			if (person >= person_traits.size() || day >= day_traits.size()) {
+				return Query_Plan_t::SWEEP;
+			}
+
+			// Work time or several rules make for many events to sort and fold,
+			// otherwise a sweep only passes the year starts
+			if ((person_traits[person] & Work_Time) || (day_traits[day] & Several_Rules)) {
+				return Query_Plan_t::CHECKPOINT;
+			}
+			// Nothing is ever capped, so the balance is a sum
+			if (day_traits[day] & Full_Rollover) {
+				return Query_Plan_t::CLOSED_FORM;
+			}
+			return Query_Plan_t::SWEEP;
+		}
+
+		bool Query_Planner::find_checkpoint(size_t person, size_t day, const Date& date,
+		                                    Checkpoint_t& checkpoint) {
+			std::lock_guard<std::mutex> l(checkpoints_lock);
+			auto found = checkpoints.find(checkpoint_key(person, day));
+			if (found == checkpoints.end() || date < found->second.date) {
+				return false;
+			}
+			checkpoint = found->second;
+			return true;
+		}
+
+		void Query_Planner::store_checkpoint(size_t person, size_t day, Checkpoint_t checkpoint) {
+			std::lock_guard<std::mutex> l(checkpoints_lock);
+			auto key = checkpoint_key(person, day);
+			auto found = checkpoints.find(key);
+			if (found == checkpoints.end()) {
+				checkpoints.emplace(key, std::move(checkpoint));
+			}
+			else if (found->second.date < checkpoint.date) {
+				found->second = std::move(checkpoint);
+			}
+		}
+
+		void Query_Planner::forget(size_t person, size_t day) {
+			std::lock_guard<std::mutex> l(checkpoints_lock);
+			if (!checkpoints.empty()) {
+				checkpoints.erase(checkpoint_key(person, day));
+			}
+		}
+
+		void Query_Planner::forget_person(size_t person) {
+			std::lock_guard<std::mutex> l(checkpoints_lock);
+			for (size_t day = 0; !checkpoints.empty() && day < day_traits.size(); ++day) {
+				checkpoints.erase(checkpoint_key(person, day));
+			}
+		}
+
+		void Query_Planner::forget_day(size_t day) {
+			std::lock_guard<std::mutex> l(checkpoints_lock);
+			for (size_t person = 0; !checkpoints.empty() && person < person_traits.size();
+			     ++person) {
+				checkpoints.erase(checkpoint_key(person, day));
+			}
+		}
+
+		void Query_Planner::clear() {
+			std::lock_guard<std::mutex> l(checkpoints_lock);
+			person_traits.clear();
+			day_traits.clear();
+			checkpoints.clear();
+		}
+
+		size_t Query_Planner::heap_bytes() const {
+			std::lock_guard<std::mutex> l(checkpoints_lock);
+
+			// Each checkpoint is a node holding the pair, a next pointer and its hash
+			using Entry = std::pair<const uint64_t, Checkpoint_t>;
+			size_t bytes = person_traits.capacity() + day_traits.capacity() +
+			               checkpoints.size() * (sizeof(Entry) + sizeof(void*) + sizeof(size_t));
+			if (!checkpoints.empty()) {
+				bytes += checkpoints.bucket_count() * sizeof(void*);
+			}
+			return bytes;
+		}
+	}
+}
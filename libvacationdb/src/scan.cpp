@@ -0,0 +1,222 @@
+#include <algorithm>
+
+#include "database_impl.hpp"
+#include "trace.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		namespace {
+			// Employees whose bounds are looked at together before any of them are swept
+			constexpr size_t min_round = 256;
+
+			Number magnitude(const Number& value) {
+				return value < 0 ? Number{-value} : value;
+			}
+		}
+
+		db_impl::Balance_Bounds_t db_impl::balance_bounds(size_t p, size_t d,
+		                                                  const Date& query_date) const {
+			auto detail = pin(p);
+			auto&& person = people[p];
+			auto&& day_type = day_types[d];
+
+			Balance_Bounds_t bounds{Number{0}, Number{0}, true};
+			if (query_date < person.start_date) {
+				return bounds;
+			}
+
+			// Whatever accrues in a year is at most the fastest rule at the highest
+			// work percentage
+			Number rate{0};
+			for (auto&& data : day_type.rules) {
+				if (data.valid) {
+					rate = std::max(rate, magnitude(data.days_per_year));
+				}
+			}
+			Number percent = magnitude(person.percent_time);
+			for (auto&& span : person.work_time) {
+				percent = std::max(percent, magnitude(span.percent_time));
+			}
+
+			// Before the year of the query only the rollover is left of the balance,
+			// unless it is carried over in full
+			int32_t query_year = query_date.year();
+			int32_t start_year = person.start_date.year();
+			bool full = day_type.rollover < 0;
+			Date from = person.start_date;
+			Number carried{0};
+			if (start_year == query_year || full) {
+				carried = day_type.yearly_bonus * (query_year - start_year + 1);
+			}
+			else {
+				from = Date{query_year, 1, 1};
+				carried = day_type.yearly_bonus;
+				if (day_type.rollover > 0) {
+					carried += day_type.rollover;
+				}
+				// Anything left over can be negative without limit
+				bounds.has_lower = false;
+			}
+
+			auto days_off = days_taken_total(person, days_taken(p, d, from, query_date));
+			Number gain = rate * percent * years_between(from, query_date);
+			bounds.upper = carried + gain - days_off;
+			if (bounds.has_lower) {
+				bounds.lower = carried - gain - days_off;
+			}
+			return bounds;
+		}
+
+		void db_impl::scan_balances(size_t d, const Date& query_date, const Number& threshold,
+		                            Balance_Scan_t::Op_t op, std::vector<size_t>& employees,
+		                            std::vector<Number>& balances) {
+			std::vector<size_t> valid;
+			valid.reserve(people.size());
+			for (size_t i = 0; i < people.size(); ++i) {
+				if (people[i].valid) {
+					valid.push_back(i);
+				}
+			}
+
+			// Only the employees the bounds don't rule out are swept
+			std::vector<uint8_t> possible(valid.size(), 0);
+			{
+				Trace_Span span{"scan: bounds"};
+				workers().parallel_for(valid.size(), 256, [&](size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						auto bounds = balance_bounds(valid[i], d, query_date);
+						bool pass = (op == Balance_Scan_t::AT_LEAST)
+						                ? bounds.upper >= threshold
+						                : !bounds.has_lower || bounds.lower <= threshold;
+						possible[i] = pass ? 1 : 0;
+					}
+				});
+			}
+
+			std::vector<size_t> candidates;
+			for (size_t i = 0; i < valid.size(); ++i) {
+				if (possible[i]) {
+					candidates.push_back(valid[i]);
+				}
+			}
+
+			std::vector<Number> values;
+			{
+				Trace_Span span{"scan: balances"};
+				balances_of(d, query_date, candidates, values);
+			}
+
+			employees.clear();
+			balances.clear();
+			for (size_t i = 0; i < candidates.size(); ++i) {
+				bool pass = (op == Balance_Scan_t::AT_LEAST) ? values[i] >= threshold
+				                                             : values[i] <= threshold;
+				if (pass) {
+					employees.push_back(candidates[i]);
+					balances.push_back(std::move(values[i]));
+				}
+			}
+		}
+
+		void db_impl::top_balances(size_t d, const Date& query_date, size_t count, bool highest,
+		                           std::vector<size_t>& employees, std::vector<Number>& balances) {
+			employees.clear();
+			balances.clear();
+
+			std::vector<size_t> valid;
+			valid.reserve(people.size());
+			for (size_t i = 0; i < people.size(); ++i) {
+				if (people[i].valid) {
+					valid.push_back(i);
+				}
+			}
+			if (count == 0 || valid.empty()) {
+				return;
+			}
+
+			// The best balance each employee could have, those without a lower bound
+			// could have any balance at all
+			std::vector<Balance_Bounds_t> bounds(valid.size());
+			{
+				Trace_Span span{"scan: bounds"};
+				workers().parallel_for(valid.size(), 256, [&](size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						bounds[i] = balance_bounds(valid[i], d, query_date);
+					}
+				});
+			}
+
+			// Best bound first, ties in order of employee
+			auto better_bound = [&](size_t left, size_t right) {
+				auto&& l = bounds[left];
+				auto&& r = bounds[right];
+				if (highest) {
+					return l.upper > r.upper;
+				}
+				if (l.has_lower != r.has_lower) {
+					return !l.has_lower;
+				}
+				return l.has_lower && l.lower < r.lower;
+			};
+			std::vector<size_t> order(valid.size());
+			for (size_t i = 0; i < order.size(); ++i) {
+				order[i] = i;
+			}
+			std::stable_sort(order.begin(), order.end(), better_bound);
+
+			// Sweeps in rounds until no bound left could beat the worst of the best
+			// count balances found so far
+			struct Found_t {
+				size_t employee;
+				Number balance;
+			};
+			auto better = [highest](const Found_t& left, const Found_t& right) {
+				if (left.balance != right.balance) {
+					return highest ? left.balance > right.balance : left.balance < right.balance;
+				}
+				return left.employee < right.employee;
+			};
+			auto could_beat = [&](const Balance_Bounds_t& b, const Number& worst) {
+				if (highest) {
+					return b.upper >= worst;
+				}
+				return !b.has_lower || b.lower <= worst;
+			};
+
+			Trace_Span span{"scan: balances"};
+			std::vector<Found_t> found;
+			std::vector<size_t> round;
+			std::vector<Number> values;
+			size_t next = 0;
+			while (next < order.size()) {
+				if (found.size() >= count &&
+				    !could_beat(bounds[order[next]], found.back().balance)) {
+					break;
+				}
+
+				size_t round_size = std::min(std::max(count, min_round), order.size() - next);
+				round.clear();
+				for (size_t i = next; i < next + round_size; ++i) {
+					round.push_back(valid[order[i]]);
+				}
+				next += round_size;
+
+				balances_of(d, query_date, round, values);
+				for (size_t i = 0; i < round.size(); ++i) {
+					found.push_back(Found_t{round[i], std::move(values[i])});
+				}
+				std::sort(found.begin(), found.end(), better);
+				if (found.size() > count) {
+					found.resize(count);
+				}
+			}
+
+			employees.reserve(found.size());
+			balances.reserve(found.size());
+			for (auto& f : found) {
+				employees.push_back(f.employee);
+				balances.push_back(std::move(f.balance));
+			}
+		}
+	}
+}
@@ -0,0 +1,518 @@
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "database_impl.hpp"
+#include "sharded_database.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		class sharded_impl {
+		  public:
+			static constexpr size_t no_day = std::numeric_limits<size_t>::max();
+
+			sharded_impl(size_t shard_count, Shard_Key_t shard_key, size_t threads)
+			    : key(std::move(shard_key)), thread_count(threads), pool(threads) {
+				if (!key) {
+					key = &Sharded_Database::hash_name;
+				}
+				shards = make_shards(shard_count);
+				shard_days.resize(shard_count);
+			}
+
+			Shard_Key_t key;
+			size_t thread_count;
+			Thread_Pool pool;
+			std::vector<Database> shards;
+
+			// Day types by name, shard_days[shard][day] is the shard's id of day or
+			// no_day if the shard doesn't have it
+			std::vector<std::string> day_names;
+			std::vector<std::vector<size_t>> shard_days;
+
+			// Every shard gets an even part of the threads
+			std::vector<Database> make_shards(size_t count) const {
+				size_t threads = thread_count ? thread_count : std::thread::hardware_concurrency();
+				size_t per_shard = std::max<size_t>(1, threads / std::max<size_t>(1, count));
+
+				std::vector<Database> ret;
+				ret.reserve(count);
+				for (size_t i = 0; i < count; ++i) {
+					ret.emplace_back(per_shard);
+				}
+				return ret;
+			}
+
+			Database& shard(size_t index) {
+				if (index >= shards.size()) {
+					throw Invalid_Index();
+				}
+				return shards[index];
+			}
+
+			DayID_t shard_day(size_t index, size_t day) const {
+				if (index >= shard_days.size() || day >= day_names.size() ||
+				    day >= shard_days[index].size() || shard_days[index][day] == no_day) {
+					throw Day_Not_Found();
+				}
+				return DayID_t{shard_days[index][day]};
+			}
+
+			// Matches up the day types of every shard by name, in order of first appearance
+			void rebuild_days() {
+				day_names.clear();
+				shard_days.assign(shards.size(), {});
+				for (size_t s = 0; s < shards.size(); ++s) {
+					for (auto&& info : shards[s].list_day_info()) {
+						auto found = std::find(day_names.begin(), day_names.end(), info.name);
+						auto day = static_cast<size_t>(found - day_names.begin());
+						if (found == day_names.end()) {
+							day_names.push_back(info.name);
+						}
+						if (shard_days[s].size() <= day) {
+							shard_days[s].resize(day + 1, no_day);
+						}
+						shard_days[s][day] = info.id;
+					}
+				}
+				for (auto&& days : shard_days) {
+					days.resize(day_names.size(), no_day);
+				}
+			}
+
+			void validate(size_t day) const {
+				if (day >= day_names.size()) {
+					throw Day_Not_Found();
+				}
+			}
+
+			// Calls f(shard, shard's day id) for every shard that has the day type
+			template <class F>
+			void for_each_day(size_t day, F&& f) {
+				validate(day);
+				for (size_t s = 0; s < shards.size(); ++s) {
+					if (shard_days[s][day] != no_day) {
+						f(shards[s], DayID_t{shard_days[s][day]});
+					}
+				}
+			}
+
+			// Calls f(shard index) for every shard on the pool
+			template <class F>
+			void for_each_shard(F&& f) {
+				pool.parallel_for(shards.size(), 1, [&](size_t begin, size_t end) {
+					for (size_t s = begin; s < end; ++s) {
+						f(s);
+					}
+				});
+			}
+
+			// Runs report on every shard that has the day type and puts the results
+			// one shard after the other
+			template <class Entry, class Report>
+			std::vector<Entry> gather(size_t day, Report&& report) {
+				std::vector<std::vector<Entry>> parts(shards.size());
+				for_each_shard([&](size_t s) {
+					if (shard_days[s][day] == no_day) {
+						return;
+					}
+					for (auto&& entry : report(shards[s], DayID_t{shard_days[s][day]})) {
+						parts[s].push_back(
+						    Entry{Shard_PersonID_t{s, entry.employee}, std::move(entry.days)});
+					}
+				});
+
+				size_t total = 0;
+				for (auto&& part : parts) {
+					total += part.size();
+				}
+				std::vector<Entry> ret;
+				ret.reserve(total);
+				for (auto&& part : parts) {
+					std::move(part.begin(), part.end(), std::back_inserter(ret));
+				}
+				return ret;
+			}
+		};
+
+		void sharded_impl_deleter::operator()(sharded_impl* value) {
+			delete value;
+		}
+	}
+
+	Sharded_Database::Sharded_Database(size_t shard_count, Shard_Key_t key, size_t thread_count) {
+		std::unique_ptr<_detail::sharded_impl, _detail::sharded_impl_deleter> n(
+		    new _detail::sharded_impl(std::max<size_t>(1, shard_count), std::move(key),
+		                              thread_count));
+		impl = std::move(n);
+	}
+
+	size_t Sharded_Database::get_shard_count() {
+		return impl->shards.size();
+	}
+
+	Database& Sharded_Database::get_shard(size_t shard) {
+		if (shard >= impl->shards.size()) {
+			throw Invalid_Index();
+		}
+		return impl->shards[shard];
+	}
+
+	DayID_t Sharded_Database::get_shard_day(size_t shard, const DayID_t d) {
+		return impl->shard_day(shard, d);
+	}
+
+	size_t Sharded_Database::hash_name(std::string_view name, size_t shard_count) {
+		// FNV-1a, which unlike std::hash is the same everywhere and every run
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : name) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 1099511628211ull;
+		}
+		return static_cast<size_t>(hash % std::max<size_t>(1, shard_count));
+	}
+
+	////////////////////////////////////////
+	// Operations on individual employees //
+	////////////////////////////////////////
+
+	Shard_PersonID_t Sharded_Database::add_employee(const char* name, uint16_t start_year,
+	                                                uint16_t start_month, uint16_t start_day,
+	                                                const char* work_time) {
+		auto shard = impl->key(name, impl->shards.size());
+		if (shard >= impl->shards.size()) {
+			throw Invalid_Index();
+		}
+		return add_employee(shard, name, start_year, start_month, start_day, work_time);
+	}
+
+	Shard_PersonID_t Sharded_Database::add_employee(size_t shard, const char* name,
+	                                                uint16_t start_year, uint16_t start_month,
+	                                                uint16_t start_day, const char* work_time) {
+		if (shard >= impl->shards.size()) {
+			throw Invalid_Index();
+		}
+		auto id = impl->shards[shard].add_employee(name, start_year, start_month, start_day,
+		                                           work_time);
+		return Shard_PersonID_t{shard, id};
+	}
+
+	void Sharded_Database::edit_employee_name(const Shard_PersonID_t employee, const char* name) {
+		impl->shard(employee.shard).edit_employee_name(employee.employee, name);
+	}
+
+	void Sharded_Database::edit_employee_start_date(const Shard_PersonID_t employee,
+	                                                uint16_t start_year, uint16_t start_month,
+	                                                uint16_t start_day) {
+		impl->shard(employee.shard)
+		    .edit_employee_start_date(employee.employee, start_year, start_month, start_day);
+	}
+
+	void Sharded_Database::edit_employee_work_time(const Shard_PersonID_t employee,
+	                                               const char* work_time) {
+		impl->shard(employee.shard).edit_employee_work_time(employee.employee, work_time);
+	}
+
+	void Sharded_Database::delete_employee(const Shard_PersonID_t employee) {
+		impl->shard(employee.shard).delete_employee(employee.employee);
+	}
+
+	Shard_PersonID_t Sharded_Database::find_employee(const char* name) {
+		std::vector<PersonID_t> found(impl->shards.size());
+		std::vector<char> has(impl->shards.size(), 0);
+		impl->for_each_shard([&](size_t s) {
+			try {
+				found[s] = impl->shards[s].find_employee(name);
+				has[s] = 1;
+			}
+			catch (Employee_Not_Found&) {
+			}
+		});
+
+		for (size_t s = 0; s < found.size(); ++s) {
+			if (has[s]) {
+				return Shard_PersonID_t{s, found[s]};
+			}
+		}
+		throw Employee_Not_Found();
+	}
+
+	std::string Sharded_Database::get_employee_name(const Shard_PersonID_t employee) {
+		return impl->shard(employee.shard).get_employee_name(employee.employee);
+	}
+
+	Person_Info_t Sharded_Database::get_employee_info(const Shard_PersonID_t employee) {
+		return impl->shard(employee.shard).get_employee_info(employee.employee);
+	}
+
+	size_t Sharded_Database::get_employee_count() {
+		size_t count = 0;
+		for (auto&& shard : impl->shards) {
+			count += shard.get_employee_count();
+		}
+		return count;
+	}
+
+	std::vector<Shard_PersonID_t> Sharded_Database::list_employee_ids() {
+		std::vector<Shard_PersonID_t> ret;
+		for (size_t s = 0; s < impl->shards.size(); ++s) {
+			for (auto id : impl->shards[s].list_employee_ids()) {
+				ret.push_back(Shard_PersonID_t{s, id});
+			}
+		}
+		return ret;
+	}
+
+	/////////////////////////////
+	// Operations on day types //
+	/////////////////////////////
+
+	DayID_t Sharded_Database::add_day(const char* name, const char* rollover,
+	                                  const char* yearly_bonus) {
+		// Checked once up front, so no shard turns them down after another took them
+		_detail::create_number_safe(rollover);
+		_detail::create_number_safe(yearly_bonus);
+
+		constexpr size_t no_day = _detail::sharded_impl::no_day;
+		auto found = std::find(impl->day_names.begin(), impl->day_names.end(), name);
+		auto day = static_cast<size_t>(found - impl->day_names.begin());
+		bool is_new = found == impl->day_names.end();
+
+		// Every shard has a row for the day before anyone can see its name
+		for (auto&& days : impl->shard_days) {
+			days.resize(day + 1, no_day);
+		}
+
+		std::vector<size_t> added;
+		try {
+			for (size_t s = 0; s < impl->shards.size(); ++s) {
+				auto& days = impl->shard_days[s];
+				if (days[day] == no_day) {
+					days[day] = impl->shards[s].add_day(name, rollover, yearly_bonus);
+					added.push_back(s);
+				}
+			}
+		}
+		catch (...) {
+			for (auto s : added) {
+				impl->shards[s].delete_day(DayID_t{impl->shard_days[s][day]});
+				impl->shard_days[s][day] = no_day;
+			}
+			if (is_new) {
+				for (auto&& days : impl->shard_days) {
+					days.resize(day);
+				}
+			}
+			throw;
+		}
+
+		if (is_new) {
+			impl->day_names.emplace_back(name);
+		}
+		return DayID_t{day};
+	}
+
+	void Sharded_Database::edit_day_rollover(const DayID_t d, const char* rollover) {
+		impl->for_each_day(d, [&](Database& shard, DayID_t day) {
+			shard.edit_day_rollover(day, rollover);
+		});
+	}
+
+	void Sharded_Database::edit_day_yearly_bonus(const DayID_t d, const char* yearly_bonus) {
+		impl->for_each_day(d, [&](Database& shard, DayID_t day) {
+			shard.edit_day_yearly_bonus(day, yearly_bonus);
+		});
+	}
+
+	void Sharded_Database::edit_day_add_rule(const DayID_t d, uint32_t month_start,
+	                                         const char* days_per_year) {
+		impl->for_each_day(d, [&](Database& shard, DayID_t day) {
+			shard.edit_day_add_rule(day, month_start, days_per_year);
+		});
+	}
+
+	DayID_t Sharded_Database::find_day(const char* name) {
+		auto found = std::find(impl->day_names.begin(), impl->day_names.end(), name);
+		if (found == impl->day_names.end()) {
+			throw Day_Not_Found();
+		}
+		return DayID_t{static_cast<size_t>(found - impl->day_names.begin())};
+	}
+
+	size_t Sharded_Database::get_day_count() {
+		return impl->day_names.size();
+	}
+
+	std::vector<std::string> Sharded_Database::list_day_names() {
+		return impl->day_names;
+	}
+
+	//////////////////////////////////////////////////////
+	// Querying the amounts of days that employees have //
+	//////////////////////////////////////////////////////
+
+	void Sharded_Database::add_day_off(const Shard_PersonID_t p, const DayID_t d, uint16_t year,
+	                                   uint16_t month, uint16_t day, const char* value) {
+		impl->shard(p.shard).add_day_off(p.employee, impl->shard_day(p.shard, d), year, month,
+		                                 day, value);
+	}
+
+	void Sharded_Database::add_days_off(const Shard_PersonID_t p, const DayID_t d,
+	                                    const std::vector<Date_t>& days) {
+		impl->shard(p.shard).add_days_off(p.employee, impl->shard_day(p.shard, d), days);
+	}
+
+	void Sharded_Database::remove_day_off(const Shard_PersonID_t p, const DayID_t d,
+	                                      uint16_t year, uint16_t month, uint16_t day) {
+		impl->shard(p.shard).remove_day_off(p.employee, impl->shard_day(p.shard, d), year, month,
+		                                    day);
+	}
+
+	std::vector<Date_t> Sharded_Database::list_days_off(const Shard_PersonID_t p,
+	                                                    const DayID_t d) {
+		return impl->shard(p.shard).list_days_off(p.employee, impl->shard_day(p.shard, d));
+	}
+
+	std::string Sharded_Database::query_vacation_days(const Shard_PersonID_t p, const DayID_t d,
+	                                                  uint16_t year, uint16_t month,
+	                                                  uint16_t day) {
+		return impl->shard(p.shard).query_vacation_days(p.employee, impl->shard_day(p.shard, d),
+		                                                year, month, day);
+	}
+
+	std::vector<Person_Days_t> Sharded_Database::query_vacation_days(const Shard_PersonID_t p,
+	                                                                 uint16_t year,
+	                                                                 uint16_t month,
+	                                                                 uint16_t day) {
+		return impl->shard(p.shard).query_vacation_days(p.employee, year, month, day);
+	}
+
+	Rational_t Sharded_Database::query_vacation_days_value(const Shard_PersonID_t p,
+	                                                       const DayID_t d, uint16_t year,
+	                                                       uint16_t month, uint16_t day) {
+		return impl->shard(p.shard).query_vacation_days_value(
+		    p.employee, impl->shard_day(p.shard, d), year, month, day);
+	}
+
+	std::vector<Shard_Employee_Days_t> Sharded_Database::report_vacation_days(const DayID_t d,
+	                                                                          uint16_t year,
+	                                                                          uint16_t month,
+	                                                                          uint16_t day) {
+		_detail::Trace_Span span{"sharded: report"};
+		impl->validate(d);
+		return impl->gather<Shard_Employee_Days_t>(d, [&](Database& shard, DayID_t shard_day) {
+			return shard.report_vacation_days(shard_day, year, month, day);
+		});
+	}
+
+	std::vector<Shard_Employee_Days_Value_t> Sharded_Database::report_vacation_days_value(
+	    const DayID_t d, uint16_t year, uint16_t month, uint16_t day) {
+		_detail::Trace_Span span{"sharded: report"};
+		impl->validate(d);
+		return impl->gather<Shard_Employee_Days_Value_t>(
+		    d, [&](Database& shard, DayID_t shard_day) {
+			    return shard.report_vacation_days_value(shard_day, year, month, day);
+			});
+	}
+
+	std::vector<Shard_Employee_Days_Value_t> Sharded_Database::scan_vacation_days(
+	    const DayID_t d, uint16_t year, uint16_t month, uint16_t day, Balance_Scan_t scan) {
+		_detail::Trace_Span span{"sharded: scan"};
+		impl->validate(d);
+		return impl->gather<Shard_Employee_Days_Value_t>(
+		    d, [&](Database& shard, DayID_t shard_day) {
+			    return shard.scan_vacation_days(shard_day, year, month, day, scan);
+			});
+	}
+
+	std::vector<Shard_Employee_Days_Value_t> Sharded_Database::top_vacation_days(
+	    const DayID_t d, uint16_t year, uint16_t month, uint16_t day, size_t count,
+	    bool highest) {
+		_detail::Trace_Span span{"sharded: top"};
+		impl->validate(d);
+
+		// The best of all shards is among the best of each shard
+		auto ret = impl->gather<Shard_Employee_Days_Value_t>(
+		    d, [&](Database& shard, DayID_t shard_day) {
+			    return shard.top_vacation_days(shard_day, year, month, day, count, highest);
+			});
+
+		// Shards come in order and are best first already, so a stable sort on the
+		// balance alone keeps ties in order of shard and employee
+		auto value = [](const Rational_t& r) { return _detail::create_number_safe(r); };
+		std::vector<_detail::Number> values;
+		values.reserve(ret.size());
+		for (auto&& entry : ret) {
+			values.push_back(value(entry.days));
+		}
+		std::vector<size_t> order(ret.size());
+		for (size_t i = 0; i < order.size(); ++i) {
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](size_t left, size_t right) {
+			return highest ? values[left] > values[right] : values[left] < values[right];
+		});
+
+		std::vector<Shard_Employee_Days_Value_t> best;
+		best.reserve(std::min(count, order.size()));
+		for (size_t i = 0; i < order.size() && i < count; ++i) {
+			best.push_back(ret[order[i]]);
+		}
+		return best;
+	}
+
+	/////////////////////////////////
+	// Loading/Saving the Database //
+	/////////////////////////////////
+
+	void Sharded_Database::load(const std::vector<std::string>& filenames) {
+		// There is always at least one shard
+		if (filenames.empty()) {
+			throw Invalid_Index();
+		}
+
+		_detail::Trace_Span span{"sharded: load"};
+
+		// Loaded into new shards, so a failure leaves the old ones alone
+		auto shards = impl->make_shards(filenames.size());
+		impl->pool.parallel_for(shards.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t s = begin; s < end; ++s) {
+				shards[s].load(filenames[s].c_str());
+			}
+		});
+
+		impl->shards = std::move(shards);
+		impl->rebuild_days();
+	}
+
+	void Sharded_Database::save(const std::vector<std::string>& filenames) {
+		if (filenames.size() != impl->shards.size()) {
+			throw Invalid_Index();
+		}
+
+		_detail::Trace_Span span{"sharded: save"};
+		impl->for_each_shard([&](size_t s) { impl->shards[s].save(filenames[s].c_str()); });
+	}
+
+	void Sharded_Database::save() {
+		save(get_current_filenames());
+	}
+
+	void Sharded_Database::clear_db() {
+		impl->for_each_shard([&](size_t s) { impl->shards[s].clear_db(); });
+		impl->rebuild_days();
+	}
+
+	std::vector<std::string> Sharded_Database::get_current_filenames() {
+		std::vector<std::string> ret;
+		ret.reserve(impl->shards.size());
+		for (auto&& shard : impl->shards) {
+			ret.push_back(shard.get_current_filename());
+		}
+		return ret;
+	}
+}
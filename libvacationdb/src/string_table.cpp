@@ -0,0 +1,56 @@
+#include "string_table.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		Name_ID String_Table::intern(std::string_view value) {
+			auto found = index.find(value);
+			if (found != index.end()) {
+				return found->second;
+			}
+
+			auto id = static_cast<Name_ID>(strings.size());
+			strings.emplace_back(value);
+			index.emplace(std::string_view(strings.back()), id);
+			return id;
+		}
+
+		Name_ID String_Table::find(std::string_view value) const {
+			auto found = index.find(value);
+			return found != index.end() ? found->second : npos;
+		}
+
+		size_t String_Table::heap_bytes() const {
+			size_t bytes = 0;
+			for (Name_ID id = 0; id < strings.size(); ++id) {
+				bytes += heap_bytes(id);
+			}
+			if (!index.empty()) {
+				bytes += index.bucket_count() * sizeof(void*);
+			}
+			return bytes;
+		}
+
+		size_t String_Table::heap_bytes(Name_ID id) const {
+			static const size_t inline_capacity = std::pmr::string().capacity();
+
+			size_t bytes = sizeof(std::pmr::string);
+			if (strings[id].capacity() > inline_capacity) {
+				bytes += strings[id].capacity() + 1;
+			}
+
+			// Each entry is a node holding the pair, a next pointer and its hash
+			using Entry = std::pair<const std::string_view, Name_ID>;
+			return bytes + sizeof(Entry) + sizeof(void*) + sizeof(size_t);
+		}
+
+		void String_Table::swap(String_Table& other) {
+			strings.swap(other.strings);
+			index.swap(other.index);
+		}
+
+		void String_Table::clear() {
+			index.clear();
+			strings.clear();
+		}
+	}
+}
@@ -0,0 +1,146 @@
+#include "thread_pool.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		namespace {
+			// Identifies the pool and queue of the worker running on this thread
+			thread_local const Thread_Pool* current_pool = nullptr;
+			thread_local size_t current_index = 0;
+		}
+
+		Thread_Pool::Thread_Pool(size_t thread_count) {
+			if (thread_count == 0) {
+				thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+			}
+
+			queues.reserve(thread_count);
+			for (size_t i = 0; i < thread_count; ++i) {
+				queues.emplace_back(new Worker_Queue);
+			}
+
+			threads.reserve(thread_count);
+			for (size_t i = 0; i < thread_count; ++i) {
+				threads.emplace_back([this, i] { worker_loop(i); });
+			}
+		}
+
+		Thread_Pool::~Thread_Pool() {
+			{
+				std::lock_guard<std::mutex> l(sleep_lock);
+				stopping = true;
+			}
+			wake.notify_all();
+
+			for (auto&& t : threads) {
+				t.join();
+			}
+		}
+
+		size_t Thread_Pool::size() const {
+			return threads.size();
+		}
+
+		Thread_Pool_Stats_t Thread_Pool::stats() const {
+			Thread_Pool_Stats_t ret;
+			ret.thread_count = threads.size();
+			ret.queue_depth = queued.load();
+			ret.tasks_executed = executed.load();
+			ret.steals = steals.load();
+			ret.busy_nanoseconds = busy_nanoseconds.load();
+			return ret;
+		}
+
+		void Thread_Pool::push(Task task) {
+			// Workers keep what they spawn close, everyone else spreads it out
+			size_t index = (current_pool == this) ? current_index
+			                                      : (next_queue.fetch_add(1) % queues.size());
+
+			// Counted before anyone can pop it, so the count never goes below zero
+			{
+				std::lock_guard<std::mutex> l(sleep_lock);
+				queued.fetch_add(1);
+			}
+
+			{
+				auto& q = *queues[index];
+				std::lock_guard<std::mutex> l(q.lock);
+				q.tasks.push_back(std::move(task));
+			}
+			wake.notify_one();
+		}
+
+		bool Thread_Pool::pop(size_t index, Task& task) {
+			auto& q = *queues[index];
+			std::lock_guard<std::mutex> l(q.lock);
+			if (q.tasks.empty()) {
+				return false;
+			}
+			task = std::move(q.tasks.back());
+			q.tasks.pop_back();
+			return true;
+		}
+
+		bool Thread_Pool::steal(size_t thief, Task& task) {
+			for (size_t i = 1; i <= queues.size(); ++i) {
+				size_t victim = (thief + i) % queues.size();
+				if (victim == thief && current_pool == this) {
+					continue;
+				}
+
+				auto& q = *queues[victim];
+				std::lock_guard<std::mutex> l(q.lock);
+				if (!q.tasks.empty()) {
+					task = std::move(q.tasks.front());
+					q.tasks.pop_front();
+					steals.fetch_add(1);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool Thread_Pool::run_one() {
+			Task task;
+			bool found;
+			if (current_pool == this) {
+				found = pop(current_index, task) || steal(current_index, task);
+			}
+			else {
+				found = steal(next_queue.load() % queues.size(), task);
+			}
+
+			if (found) {
+				queued.fetch_sub(1);
+				run(task);
+			}
+			return found;
+		}
+
+		void Thread_Pool::run(Task& task) {
+			auto start = std::chrono::steady_clock::now();
+			task();
+			auto end = std::chrono::steady_clock::now();
+
+			auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+			busy_nanoseconds.fetch_add(static_cast<uint64_t>(ns));
+			executed.fetch_add(1);
+		}
+
+		void Thread_Pool::worker_loop(size_t index) {
+			current_pool = this;
+			current_index = index;
+
+			while (true) {
+				if (run_one()) {
+					continue;
+				}
+
+				std::unique_lock<std::mutex> l(sleep_lock);
+				wake.wait(l, [this] { return stopping || queued.load() != 0; });
+				if (stopping && queued.load() == 0) {
+					break;
+				}
+			}
+		}
+	}
+}
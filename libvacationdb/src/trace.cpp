@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "trace.hpp"
+
+namespace Vacationdb {
+	namespace _detail {
+		std::atomic<bool> Tracing::enabled{false};
+
+		namespace {
+			struct Trace_Event_t {
+				const char* name;
+				std::chrono::steady_clock::time_point begin;
+				std::chrono::steady_clock::time_point end;
+			};
+
+			// Events are appended in fixed size chunks that never move, so the
+			// owning thread can keep writing while another thread reads what was
+			// published before it.
+			struct Trace_Chunk {
+				static constexpr size_t capacity = 4096;
+				Trace_Event_t events[capacity];
+				std::atomic<size_t> count{0};
+				std::atomic<Trace_Chunk*> next{nullptr};
+
+				Trace_Chunk() = default;
+				Trace_Chunk(const Trace_Chunk&) = delete;
+				Trace_Chunk& operator=(const Trace_Chunk&) = delete;
+				~Trace_Chunk() {
+					delete next.load();
+				}
+			};
+
+			struct Thread_Buffer {
+				uint64_t thread_id;
+				// The trace the events belong to, older events are dropped
+				std::atomic<uint64_t> generation{0};
+				Trace_Chunk head;
+				Trace_Chunk* tail = &head;
+			};
+
+			std::mutex trace_lock;
+			std::atomic<uint64_t> generation{0};
+			std::chrono::steady_clock::time_point trace_begin;
+
+			// Buffers outlive their threads so a trace can still be written
+			// after a worker has exited.
+			std::vector<std::unique_ptr<Thread_Buffer>>& buffers() {
+				static std::vector<std::unique_ptr<Thread_Buffer>> all;
+				return all;
+			}
+
+			Thread_Buffer& thread_buffer() {
+				thread_local Thread_Buffer* buffer = nullptr;
+				if (buffer == nullptr) {
+					std::unique_ptr<Thread_Buffer> fresh(new Thread_Buffer);
+					buffer = fresh.get();
+
+					std::lock_guard<std::mutex> l(trace_lock);
+					fresh->thread_id = buffers().size() + 1;
+					buffers().push_back(std::move(fresh));
+				}
+				return *buffer;
+			}
+
+			double microseconds(std::chrono::steady_clock::duration d) {
+				return std::chrono::duration<double, std::micro>(d).count();
+			}
+
+			void append_event(std::string& out, const Trace_Event_t& e, uint64_t thread_id) {
+				char numbers[96];
+				std::snprintf(numbers, sizeof(numbers), "\"ts\":%.3f,\"dur\":%.3f,\"tid\":%llu}",
+				              microseconds(e.begin - trace_begin), microseconds(e.end - e.begin),
+				              static_cast<unsigned long long>(thread_id));
+
+				// Names are internal literals that never need escaping
+				out += "{\"name\":\"";
+				out += e.name;
+				out += "\",\"cat\":\"vacationdb\",\"ph\":\"X\",\"pid\":1,";
+				out += numbers;
+			}
+		}
+
+		void Tracing::start() {
+			std::lock_guard<std::mutex> l(trace_lock);
+			trace_begin = std::chrono::steady_clock::now();
+			generation.fetch_add(1);
+			enabled.store(true);
+		}
+
+		void Tracing::stop(const char* filename) {
+			std::string out = "{\"traceEvents\":[";
+			{
+				std::lock_guard<std::mutex> l(trace_lock);
+				enabled.store(false);
+
+				bool first = true;
+				auto current = generation.load();
+				for (auto&& buffer : buffers()) {
+					if (buffer->generation.load(std::memory_order_acquire) != current) {
+						continue;
+					}
+					for (auto* chunk = &buffer->head; chunk != nullptr;
+					     chunk = chunk->next.load(std::memory_order_acquire)) {
+						auto count = chunk->count.load(std::memory_order_acquire);
+						for (size_t i = 0; i < count; ++i) {
+							out += first ? "\n" : ",\n";
+							append_event(out, chunk->events[i], buffer->thread_id);
+							first = false;
+						}
+					}
+				}
+			}
+			out += "]}\n";
+
+			std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+			if (!file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+				throw Invalid_File();
+			}
+		}
+
+		void Tracing::record(const char* name, std::chrono::steady_clock::time_point begin,
+		                     std::chrono::steady_clock::time_point end) {
+			auto& buffer = thread_buffer();
+
+			// The first event of a new trace drops what is left of the last one
+			auto current = generation.load(std::memory_order_relaxed);
+			if (buffer.generation.load(std::memory_order_relaxed) != current) {
+				for (auto* chunk = &buffer.head; chunk != nullptr; chunk = chunk->next.load()) {
+					chunk->count.store(0, std::memory_order_relaxed);
+				}
+				buffer.tail = &buffer.head;
+				buffer.generation.store(current, std::memory_order_release);
+			}
+
+			auto* chunk = buffer.tail;
+			auto count = chunk->count.load(std::memory_order_relaxed);
+			if (count == Trace_Chunk::capacity) {
+				if (chunk->next.load() == nullptr) {
+					chunk->next.store(new Trace_Chunk, std::memory_order_release);
+				}
+				chunk = chunk->next.load();
+				buffer.tail = chunk;
+				count = 0;
+			}
+
+			chunk->events[count] = Trace_Event_t{name, begin, end};
+			chunk->count.store(count + 1, std::memory_order_release);
+		}
+	}
+}
@@ -1,104 +1,288 @@
 #include "database_impl.hpp"
+#include "trace.hpp"
 
 #include <algorithm>
 #include <iterator>
+#include <limits>
+#include <set>
 
 namespace Vacationdb {
 	namespace _detail {
 		VACATIONDB_SHARED Date create_date_safe(uint16_t start_year, uint16_t start_month,
 			uint16_t start_day) {
-			Date ret;
-			try {
-				ret = Date{ start_year, start_month, start_day };
-			}
-			catch (boost::exception_detail::clone_impl<
-				boost::exception_detail::error_info_injector<boost::gregorian::bad_year>>&) {
+			if (!is_valid_date(start_year, start_month, start_day)) {
 				throw Vacationdb::Invalid_Date();
 			}
-			return ret;
+			return Date{start_year, start_month, start_day};
 		}
 
-		VACATIONDB_SHARED Number create_number_safe(const char* value) {
-			std::string source(value);
-			// Parse the number to transform decimals into forms that mpq_rational will
-			// take.
-			// The numbers need to have integer numerators and denominators.
+		namespace {
+			using Integer = boost::multiprecision::cpp_int;
 
-			std::string numerator;
-			std::string denominator;
+			// One side of a fraction: its digits with the decimal point taken out and
+			// how many of them came after the point.
+			struct Number_Part_t {
+				const char* begin;
+				const char* end;
+				bool negative;
+				// Set when the digits do not fit in mantissa
+				bool overflow;
+				uint64_t mantissa;
+				uint32_t decimals;
+			};
 
-			auto division_location = std::find(source.begin(), source.end(), '/');
+			const uint64_t powers_of_ten[20] = {1ull,
+			                                    10ull,
+			                                    100ull,
+			                                    1000ull,
+			                                    10000ull,
+			                                    100000ull,
+			                                    1000000ull,
+			                                    10000000ull,
+			                                    100000000ull,
+			                                    1000000000ull,
+			                                    10000000000ull,
+			                                    100000000000ull,
+			                                    1000000000000ull,
+			                                    10000000000000ull,
+			                                    100000000000000ull,
+			                                    1000000000000000ull,
+			                                    10000000000000000ull,
+			                                    100000000000000000ull,
+			                                    1000000000000000000ull,
+			                                    10000000000000000000ull};
 
-			// If it has a denominator
-			bool has_denom = division_location != source.end();
+			// Reads [sign] digits [. digits] up to a '/' or the end of the string.
+			// Returns where it stopped or nullptr if the part is malformed.
+			const char* parse_number_part(const char* it, Number_Part_t& part) {
+				part = Number_Part_t{nullptr, nullptr, false, false, 0, 0};
 
-			// Figures out how many decimal places each has in order to convert.
-			size_t num_decimal_places = 0;
-			size_t den_decimal_places = 0;
+				if (*it == '-' || *it == '+') {
+					part.negative = (*it == '-');
+					++it;
+				}
+				part.begin = it;
 
-			// The search will stop at the first . or /
-			auto num_decimal_loc = std::find_if(source.begin(), source.end(),
-				[](char c) { return (c == '.') || (c == '/'); });
+				bool seen_point = false;
+				size_t digits = 0;
+				for (; *it != '\0' && *it != '/'; ++it) {
+					if (*it >= '0' && *it <= '9') {
+						auto digit = static_cast<uint64_t>(*it - '0');
+						if (part.mantissa > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+							part.overflow = true;
+						}
+						else if (!part.overflow) {
+							part.mantissa = part.mantissa * 10 + digit;
+						}
+						digits++;
+						part.decimals += seen_point;
+					}
+					else if (*it == '.' && !seen_point) {
+						seen_point = true;
+					}
+					else {
+						return nullptr;
+					}
+				}
+				part.end = it;
 
-			// If it did not stop on the /
-			if (num_decimal_loc != division_location) {
-				// This works even if division_location == source.end()
-				size_t dist = std::abs(std::distance(num_decimal_loc, division_location));
-				num_decimal_places = dist - 1;
+				return (digits == 0) ? nullptr : it;
 			}
 
-			// If there is a denominator find the period
-			if (has_denom) {
-				auto den_decimal_loc = std::find(division_location, source.end(), '.');
-				if (den_decimal_loc != source.end()) {
-					size_t dist = std::abs(std::distance(den_decimal_loc, source.end()));
-					den_decimal_places = dist - 1;
+			// The digits of a part as an arbitrary size integer, ignoring the sign
+			Integer number_part_digits(const Number_Part_t& part) {
+				Integer ret{0};
+				for (auto it = part.begin; it != part.end; ++it) {
+					if (*it != '.') {
+						ret *= 10;
+						ret += *it - '0';
+					}
+				}
+				return ret;
+			}
+
+			bool checked_multiply(uint64_t a, uint64_t b, uint64_t& out) {
+				if (a != 0 && b > std::numeric_limits<uint64_t>::max() / a) {
+					return false;
 				}
+				out = a * b;
+				return true;
 			}
 
-			size_t total_offset = std::max(num_decimal_places, den_decimal_places);
+			uint64_t gcd(uint64_t a, uint64_t b) {
+				while (b != 0) {
+					uint64_t t = a % b;
+					a = b;
+					b = t;
+				}
+				return a;
+			}
+		}
 
-			// Back inserters
-			std::back_insert_iterator<std::string> num_back_insert(numerator);
-			std::back_insert_iterator<std::string> den_back_insert(denominator);
+		// Accepts integers, decimals and fractions of either, like "-3", "9.96"
+		// or "3.1/-12.532". Everything that fits in 64 bits is done without
+		// allocating, larger numbers fall back to arbitrary size integers.
+		VACATIONDB_SHARED Number create_number_safe(const char* value) {
+			Number_Part_t num;
+			Number_Part_t den{nullptr, nullptr, false, false, 1, 0};
 
-			// Copy numerator
-			std::copy_if(source.begin(), division_location, num_back_insert,
-				[](char c) { return !(c == '.'); });
+			const char* it = parse_number_part(value, num);
+			if (it == nullptr) {
+				throw Vacationdb::Invalid_Number();
+			}
 
-			// Fill in difference in zeros
-			std::fill_n(num_back_insert, total_offset - num_decimal_places, '0');
+			bool has_denom = (*it == '/');
 			if (has_denom) {
-				// Copy denom
-				std::copy_if(division_location + 1, source.end(), den_back_insert,
-					[](char c) { return !(c == '.'); });
-
-				std::fill_n(num_back_insert, total_offset - den_decimal_places, '0');
+				it = parse_number_part(it + 1, den);
+				if (it == nullptr || *it != '\0') {
+					throw Vacationdb::Invalid_Number();
+				}
 			}
-			else {
-				// Fill in proper denominator
-				denominator = "1";
-				std::fill_n(den_back_insert, total_offset, '0');
+
+			bool negative = (num.negative != den.negative);
+
+			// (n / 10^a) / (d / 10^b) == (n * 10^b) / (d * 10^a)
+			uint64_t n = 0;
+			uint64_t d = 0;
+			const uint64_t max = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+			bool fits = !num.overflow && !den.overflow && num.decimals < 20 &&
+			            den.decimals < 20 &&
+			            checked_multiply(num.mantissa, powers_of_ten[den.decimals], n) &&
+			            checked_multiply(den.mantissa, powers_of_ten[num.decimals], d) && n <= max &&
+			            d <= max;
+
+			if (fits) {
+				if (d == 0) {
+					throw Vacationdb::Invalid_Number();
+				}
+
+				auto signed_n = static_cast<int64_t>(n);
+				if (d == 1) {
+					return Number{negative ? -signed_n : signed_n};
+				}
+
+				uint64_t divisor = gcd(n, d);
+				signed_n = static_cast<int64_t>(n / divisor);
+				return Number{negative ? -signed_n : signed_n, static_cast<int64_t>(d / divisor)};
 			}
 
-			Number ret;
-			try {
-				ret = Number{ numerator } / Number{ denominator };
+			Integer big_n = number_part_digits(num);
+			Integer big_d = has_denom ? number_part_digits(den) : Integer{1};
+			big_n *= boost::multiprecision::pow(Integer{10}, den.decimals);
+			big_d *= boost::multiprecision::pow(Integer{10}, num.decimals);
+
+			if (big_d == 0) {
+				throw Vacationdb::Invalid_Number();
 			}
-			catch (boost::exception_detail::clone_impl<
-				boost::exception_detail::error_info_injector<std::runtime_error>>&) {
+
+			Number ret = Number{big_n} / Number{big_d};
+			return negative ? Number{-ret} : ret;
+		}
+
+		VACATIONDB_SHARED Number create_number_safe(const Rational_t& value) {
+			if (value.denominator == 0) {
 				throw Vacationdb::Invalid_Number();
 			}
-			return ret;
+			// The two argument constructor rejects negative denominators
+			return Number{value.numerator} / Number{value.denominator};
+		}
+
+		VACATIONDB_SHARED Rational_t create_rational_safe(const Number& value) {
+			using Integer = boost::multiprecision::cpp_int;
+
+			const Integer& num = boost::multiprecision::numerator(value);
+			const Integer& den = boost::multiprecision::denominator(value);
+
+			const Integer max = std::numeric_limits<int64_t>::max();
+			const Integer min = std::numeric_limits<int64_t>::min();
+			if (num > max || num < min || den > max) {
+				throw Vacationdb::Number_Out_Of_Range();
+			}
+
+			return Rational_t{num.convert_to<int64_t>(), den.convert_to<int64_t>()};
 		}
 
 		void db_impl::block_if_locked() {
 			if (io_lock.load()) {
-				io_future.wait();
+				if (metrics.enabled()) {
+					auto start = std::chrono::steady_clock::now();
+					io_future.wait();
+					metrics.record_lock_wait(nanoseconds_since(start));
+				}
+				else {
+					io_future.wait();
+				}
 			}
 			io_lock.store(false);
 		}
 
+		void db_impl::begin_read() {
+			std::lock_guard<std::mutex> l(reads_lock);
+			pending_reads++;
+		}
+
+		void db_impl::end_read() {
+			{
+				std::lock_guard<std::mutex> l(reads_lock);
+				pending_reads--;
+			}
+			reads_done.notify_all();
+		}
+
+		void db_impl::block_for_write() {
+			block_if_locked();
+			// Whoever is left is read in when an edit or query gets to them
+			warm_stop.store(true);
+
+			std::unique_lock<std::mutex> l(reads_lock);
+			if (pending_reads != 0 && metrics.enabled()) {
+				auto start = std::chrono::steady_clock::now();
+				reads_done.wait(l, [this] { return pending_reads == 0; });
+				metrics.record_lock_wait(nanoseconds_since(start));
+			}
+			reads_done.wait(l, [this] { return pending_reads == 0; });
+		}
+
+		void db_impl::stop_warming() {
+			warm_stop.store(true);
+			std::unique_lock<std::mutex> l(reads_lock);
+			reads_done.wait(l, [this] { return pending_reads == 0; });
+		}
+
+		void db_impl::start_warming() {
+			warm_next.store(0);
+			size_t chunks = (people.size() + warm_chunk - 1) / warm_chunk;
+			for (size_t i = std::min(chunks, workers().size()); i > 0; --i) {
+				submit_read([this] { warm_details(); });
+			}
+		}
+
+		void db_impl::warm_details() {
+			Trace_Span span{"lazy load: warm"};
+			size_t from = warm_next.fetch_add(warm_chunk);
+			size_t end = std::min(from + warm_chunk, people.size());
+			for (size_t p = from; p < end && !warm_stop.load(); ++p) {
+				try {
+					pin(p);
+				}
+				catch (Invalid_File&) {
+					// Left for whoever asks for them to see
+				}
+			}
+			// A chunk at a time so writers don't wait long for it to notice
+			if (from + warm_chunk < people.size() && !warm_stop.load()) {
+				submit_read([this] { warm_details(); });
+			}
+		}
+
+		Thread_Pool& db_impl::workers() {
+			std::lock_guard<std::mutex> l(pool_lock);
+			if (!pool) {
+				pool.reset(new Thread_Pool(thread_count));
+			}
+			return *pool;
+		}
+
 		void db_impl::validate(PersonID_t p) {
 			bool valid_index = p < people.size();
 			if (valid_index) {
@@ -114,6 +298,7 @@ namespace Vacationdb {
 			bool valid_index_p = p < people.size();
 			if (valid_index_p) {
 				bool valid_p = people[p].valid;
+				auto detail = pin(p);
 				bool valid_index_e = e < people[p].extra_time.size();
 				if (valid_p && valid_index_e) {
 					bool valid_e = people[p].extra_time[e].valid;
@@ -151,21 +336,391 @@ namespace Vacationdb {
 			throw Vacationdb::Invalid_Index();
 		}
 
-		void db_impl::add_day_to_people() {
-			for (auto& p : people) {
-				p.days_taken.emplace_back();
+		size_t db_impl::add_person(const char* name, Date start_date, Number percent_time) {
+			Person p{people.get_allocator()};
+			p.name = names.intern(name);
+			p.start_date = std::move(start_date);
+			p.percent_time = std::move(percent_time);
+
+			people.emplace_back(std::move(p));
+			replan_person(people.size() - 1);
+			invalidate_name_index();
+
+			return people.size() - 1;
+		}
+
+		size_t db_impl::add_extra_time(size_t person, Date begin, Date end, Number percent_time) {
+			// An empty or backwards range would never apply, so it's a mistake
+			if (!(begin < end)) {
+				throw Invalid_Date();
 			}
+
+			Person::Extra_Time_t ett;
+			ett.begin = std::move(begin);
+			ett.end = std::move(end);
+			ett.percent_time = std::move(percent_time);
+
+			auto detail = pin(person, true);
+			people[person].extra_time.push_back(std::move(ett));
+			rebuild_work_time(person);
+
+			return people[person].extra_time.size() - 1;
 		}
 
-		void db_impl::remove_day_from_people(size_t index) {
-			for (auto& p : people) {
-				p.days_taken[index].erase(p.days_taken[index].begin(), p.days_taken[index].end());
+		size_t db_impl::add_day_type(const char* name, Number rollover, Number yearly_bonus) {
+			Day d{day_types.get_allocator()};
+			d.name = names.intern(name);
+			d.rollover = std::move(rollover);
+			d.yearly_bonus = std::move(yearly_bonus);
+
+			day_types.emplace_back(std::move(d));
+			replan_day(day_types.size() - 1);
+
+			return day_types.size() - 1;
+		}
+
+		size_t db_impl::add_rule(size_t day, uint32_t month_begin, Number days_per_year) {
+			Day::Day_Rules_Data drd;
+			drd.month_begin = month_begin;
+			drd.days_per_year = std::move(days_per_year);
+
+			day_types[day].rules.push_back(std::move(drd));
+			replan_day(day);
+
+			return day_types[day].rules.size() - 1;
+		}
+
+		namespace {
+			struct Ledger_Order {
+				bool operator()(const Person::Day_Taken_t& entry,
+				                const std::pair<uint32_t, Date>& key) const {
+					return std::make_pair(entry.day_type, entry.day) < key;
+				}
+				bool operator()(const std::pair<uint32_t, Date>& key,
+				                const Person::Day_Taken_t& entry) const {
+					return key < std::make_pair(entry.day_type, entry.day);
+				}
+			};
+		}
+
+		void db_impl::add_day_taken(size_t person, size_t day, Date date, Number value) {
+			auto detail = pin(person, true);
+			auto& ledger = people[person].days_taken;
+			auto key = std::make_pair(static_cast<uint32_t>(day), date);
+
+			// Days off on the same date stay in the order they were added
+			auto it = std::upper_bound(ledger.begin(), ledger.end(), key, Ledger_Order{});
+
+			Number total = value;
+			if (it != ledger.begin() && (it - 1)->day_type == key.first) {
+				total += (it - 1)->running_total;
+			}
+
+			it = ledger.insert(it, Person::Day_Taken_t{key.first, std::move(date), value,
+			                                           std::move(total)});
+			for (++it; it != ledger.end() && it->day_type == key.first; ++it) {
+				it->running_total += value;
 			}
+			planner.forget(person, day);
 		}
 
-		void db_impl::load_file() {}
+		void db_impl::add_days_taken(size_t person, size_t day,
+		                             std::vector<std::pair<Date, Number>> days) {
+			auto detail = pin(person, true);
+			auto& ledger = people[person].days_taken;
+			auto type = static_cast<uint32_t>(day);
 
-		void db_impl::save_file() {}
+			std::stable_sort(days.begin(), days.end(),
+			                 [](const std::pair<Date, Number>& left,
+			                    const std::pair<Date, Number>& right) {
+				                 return left.first < right.first;
+				             });
+
+			auto range = days_taken(person, day);
+			auto first = static_cast<size_t>(range.first - ledger.cbegin());
+			auto last = static_cast<size_t>(range.second - ledger.cbegin());
+
+			Person::Ledger rebuilt{ledger.get_allocator()};
+			rebuilt.reserve(ledger.size() + days.size());
+			std::move(ledger.begin(), ledger.begin() + first, std::back_inserter(rebuilt));
+
+			// Merge with what is there, existing days off go first on the same date
+			size_t old_i = first;
+			size_t new_i = 0;
+			while (old_i < last || new_i < days.size()) {
+				bool take_old = (new_i == days.size()) ||
+				                (old_i < last && !(days[new_i].first < ledger[old_i].day));
+				if (take_old) {
+					rebuilt.push_back(std::move(ledger[old_i++]));
+				}
+				else {
+					auto& entry = days[new_i++];
+					rebuilt.push_back(
+					    Person::Day_Taken_t{type, entry.first, std::move(entry.second), Number{0}});
+				}
+
+				auto& added = rebuilt.back();
+				added.running_total = added.value;
+				if (rebuilt.size() > first + 1) {
+					added.running_total += rebuilt[rebuilt.size() - 2].running_total;
+				}
+			}
+
+			std::move(ledger.begin() + last, ledger.end(), std::back_inserter(rebuilt));
+			ledger.swap(rebuilt);
+			planner.forget(person, day);
+		}
+
+		db_impl::Days_Taken_Range db_impl::days_taken(size_t person, size_t day) const {
+			auto&& ledger = people[person].days_taken;
+			auto type = static_cast<uint32_t>(day);
+
+			auto first = std::lower_bound(
+			    ledger.begin(), ledger.end(), type,
+			    [](const Person::Day_Taken_t& entry, uint32_t t) { return entry.day_type < t; });
+			auto last = std::upper_bound(
+			    first, ledger.end(), type,
+			    [](uint32_t t, const Person::Day_Taken_t& entry) { return t < entry.day_type; });
+
+			return Days_Taken_Range{first, last};
+		}
+
+		db_impl::Days_Taken_Range db_impl::days_taken(size_t person, size_t day, const Date& from,
+		                                              const Date& to) const {
+			auto&& ledger = people[person].days_taken;
+			auto type = static_cast<uint32_t>(day);
+
+			if (to < from) {
+				auto empty = std::lower_bound(ledger.begin(), ledger.end(),
+				                              std::make_pair(type, from), Ledger_Order{});
+				return Days_Taken_Range{empty, empty};
+			}
+
+			auto first = std::lower_bound(ledger.begin(), ledger.end(),
+			                              std::make_pair(type, from), Ledger_Order{});
+			auto last =
+			    std::upper_bound(first, ledger.end(), std::make_pair(type, to), Ledger_Order{});
+
+			return Days_Taken_Range{first, last};
+		}
+
+		void db_impl::remove_day_taken(size_t person, size_t day, const Date& date) {
+			auto detail = pin(person, true);
+			auto& ledger = people[person].days_taken;
+			auto key = std::make_pair(static_cast<uint32_t>(day), date);
+
+			auto it = std::lower_bound(ledger.begin(), ledger.end(), key, Ledger_Order{});
+			if (it != ledger.end() && it->day_type == key.first && it->day == date) {
+				Number value = std::move(it->value);
+				it = ledger.erase(it);
+				for (; it != ledger.end() && it->day_type == key.first; ++it) {
+					it->running_total -= value;
+				}
+				planner.forget(person, day);
+			}
+		}
+
+		Number db_impl::days_taken_total(const Person& person, Days_Taken_Range range) {
+			if (range.first == range.second) {
+				return Number{0};
+			}
+
+			Number total = (range.second - 1)->running_total;
+			if (range.first != person.days_taken.begin()) {
+				auto&& before = *(range.first - 1);
+				if (before.day_type == range.first->day_type) {
+					total -= before.running_total;
+				}
+			}
+			return total;
+		}
+
+		std::vector<Date_t> db_impl::days_taken_list(Days_Taken_Range range) const {
+			std::vector<Date_t> ret;
+			ret.reserve(static_cast<size_t>(range.second - range.first));
+
+			for (auto it = range.first; it != range.second; ++it) {
+				uint16_t year = it->day.year();
+				uint16_t month = it->day.month();
+				uint16_t day = it->day.day();
+				std::string amount = it->value.convert_to<std::string>();
+
+				ret.push_back(Date_t{year, month, day, std::move(amount)});
+			}
+
+			return ret;
+		}
+
+		Person_Info_t db_impl::employee_info(size_t employee) const {
+			auto detail = pin(employee);
+			auto&& p = people[employee];
+
+			std::string work_time = p.percent_time.convert_to<std::string>();
+
+			using ewti_type = Person_Info_t::Extra_Work_Time_Info_t;
+			std::vector<ewti_type> ewti;
+			ewti.reserve(p.extra_time.size());
+			size_t i = 0;
+			for (auto&& et : p.extra_time) {
+				if (et.valid) {
+					uint16_t start_year = et.begin.year();
+					uint16_t start_month = et.begin.month();
+					uint16_t start_day = et.begin.day();
+					uint16_t end_year = et.end.year();
+					uint16_t end_month = et.end.month();
+					uint16_t end_day = et.end.day();
+					std::string percent = et.percent_time.convert_to<std::string>();
+
+					ewti.push_back(ewti_type{Extra_TimeID_t{i}, start_year, start_month, start_day,
+					                         end_year, end_month, end_day, percent});
+				}
+				i++;
+			}
+
+			Person_Info_t pi{PersonID_t{employee},
+			                 std::string(names.view(p.name)),
+			                 p.start_date.year(),
+			                 p.start_date.month(),
+			                 p.start_date.day(),
+			                 std::move(work_time),
+			                 std::move(ewti)};
+
+			return pi;
+		}
+
+
+		std::vector<Person_Info_t> db_impl::employee_info_list() const {
+			std::vector<Person_Info_t> ret;
+			ret.reserve(people.size());
+
+			for (size_t i = 0; i < people.size(); ++i) {
+				if (people[i].valid) {
+					ret.push_back(employee_info(i));
+				}
+			}
+
+			return ret;
+		}
+
+		std::vector<size_t> db_impl::people_by_name() {
+			std::lock_guard<std::mutex> l(name_index_lock);
+
+			if (!name_index_valid) {
+				name_index.clear();
+				for (size_t i = 0; i < people.size(); ++i) {
+					if (people[i].valid) {
+						name_index.push_back(i);
+					}
+				}
+				// Equal names stay in order of id
+				std::stable_sort(name_index.begin(), name_index.end(),
+				                 [this](size_t left, size_t right) {
+					                 return names.view(people[left].name) <
+					                        names.view(people[right].name);
+				                 });
+				name_index.shrink_to_fit();
+				name_index_valid = true;
+			}
+
+			return name_index;
+		}
+
+		void db_impl::invalidate_name_index() {
+			std::lock_guard<std::mutex> l(name_index_lock);
+			name_index_valid = false;
+		}
+
+		void db_impl::rebuild_work_time(size_t p) {
+			auto detail = pin(p, true);
+			build_work_time(people[p]);
+			replan_person(p);
+		}
+
+		void build_work_time(Person& person) {
+			struct Boundary_t {
+				Date date;
+				size_t index;
+				bool begin;
+			};
+
+			std::vector<Boundary_t> boundaries;
+			boundaries.reserve(person.extra_time.size() * 2);
+
+			for (size_t i = 0; i < person.extra_time.size(); ++i) {
+				auto&& et = person.extra_time[i];
+				// Empty and backwards ranges never apply
+				if (et.valid && et.begin < et.end) {
+					boundaries.push_back(Boundary_t{et.begin, i, true});
+					boundaries.push_back(Boundary_t{et.end, i, false});
+				}
+			}
+
+			std::sort(boundaries.begin(), boundaries.end(),
+			          [](const Boundary_t& left, const Boundary_t& right) {
+				          return left.date < right.date;
+				      });
+
+			person.work_time.clear();
+
+			// Extra times that cover the current date. The latest one added wins.
+			std::set<size_t> active;
+			bool open = false;
+
+			for (size_t b = 0; b < boundaries.size();) {
+				Date date = boundaries[b].date;
+				for (; b < boundaries.size() && boundaries[b].date == date; ++b) {
+					if (boundaries[b].begin) {
+						active.insert(boundaries[b].index);
+					}
+					else {
+						active.erase(boundaries[b].index);
+					}
+				}
+
+				if (open) {
+					person.work_time.back().end = date;
+					open = false;
+				}
+
+				if (!active.empty()) {
+					auto&& percent = person.extra_time[*active.rbegin()].percent_time;
+					bool extends = !person.work_time.empty() &&
+					               person.work_time.back().end == date &&
+					               person.work_time.back().percent_time == percent;
+					if (!extends) {
+						person.work_time.push_back(Person::Work_Time_Span_t{date, date, percent});
+					}
+					open = true;
+				}
+			}
+
+			person.work_time.shrink_to_fit();
+		}
+
+		const Number& db_impl::work_time_on(size_t p, const Date& date) const {
+			auto&& person = people[p];
+
+			auto after = std::upper_bound(
+			    person.work_time.begin(), person.work_time.end(), date,
+			    [](const Date& d, const Person::Work_Time_Span_t& span) { return d < span.begin; });
+
+			if (after != person.work_time.begin()) {
+				auto&& span = *(after - 1);
+				if (date < span.end) {
+					return span.percent_time;
+				}
+			}
+
+			return person.percent_time;
+		}
+
+		void db_impl::remove_day_from_people(size_t index) {
+			for (size_t p = 0; p < people.size(); ++p) {
+				auto detail = pin(p, true);
+				auto range = days_taken(p, index);
+				people[p].days_taken.erase(range.first, range.second);
+			}
+		}
 
 		// Clear all data
 		void db_impl::clear() {
@@ -173,11 +728,17 @@ namespace Vacationdb {
 			people.shrink_to_fit();
 			day_types.clear();
 			day_types.shrink_to_fit();
+			names.clear();
+			planner.clear();
+			if (detail_cache) {
+				detail_cache->reset();
+			}
+			invalidate_name_index();
 			current_file_name = "vdb.json";
 			io_lock.store(false);
 			io_percentage.store(0);
 			io_future = decltype(io_future)();
-			io_curop = IO_Status_t::NOOP;
+			io_curop.store(IO_Status_t::NOOP);
 		}
 	}
 }
@@ -1,111 +1,155 @@
-#include "boost/date_time/gregorian/gregorian.hpp"
-#include <boost/variant/get.hpp>
-#include <boost/variant/variant.hpp>
-
 #include <algorithm>
 #include <cmath>
-#include <iostream>
 #include <numeric>
 #include <sstream>
 #include <string>
 
 #include "database_impl.hpp"
+#include "trace.hpp"
 #include "vacationdb.hpp"
 
 namespace Vacationdb {
 	void _detail::db_impl_deleter::operator()(db_impl* value) {
+		value->stop_warming();
 		delete value;
 	}
 
-    Database::Database() {
-		std::unique_ptr<_detail::db_impl, _detail::db_impl_deleter> n(new _detail::db_impl);
+    Database::Database() : Database(std::pmr::get_default_resource()) {}
+
+	Database::Database(size_t thread_count) : Database() {
+		impl->thread_count = thread_count;
+	}
+
+	Database::Database(std::pmr::memory_resource* resource) {
+		std::unique_ptr<_detail::db_impl, _detail::db_impl_deleter> n(
+		    new _detail::db_impl(resource));
 		impl = std::move(n);
 	}
 
+	Database::Database(size_t thread_count, std::pmr::memory_resource* resource)
+	    : Database(resource) {
+		impl->thread_count = thread_count;
+	}
+
 	////////////////////////////////////////
 	// Operations on individual employees //
 	////////////////////////////////////////
 
 	PersonID_t Database::add_employee(const char* name, uint16_t start_year, uint16_t start_month,
 	                                  uint16_t start_day, const char* work_time) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "add_employee");
+		impl->block_for_write();
 
-		std::string n{name};
 		auto start_date = _detail::create_date_safe(start_year, start_month, start_day);
 		auto wt = _detail::create_number_safe(work_time);
 
-		_detail::Person p;
-		p.name = std::move(n);
-		p.start_date = std::move(start_date);
-		p.percent_time = std::move(wt);
-		p.extra_time = std::vector<_detail::Person::Extra_Time_t>();
-        p.days_taken = std::vector<std::vector<_detail::Person::Day_Taken_t>>{impl->day_types.size()};
+		return PersonID_t{impl->add_person(name, std::move(start_date), std::move(wt))};
+	}
+
+	PersonID_t Database::add_employee(const char* name, uint16_t start_year, uint16_t start_month,
+	                                  uint16_t start_day, Rational_t work_time) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "add_employee");
+		impl->block_for_write();
 
-		impl->people.emplace_back(std::move(p));
+		auto start_date = _detail::create_date_safe(start_year, start_month, start_day);
+		auto wt = _detail::create_number_safe(work_time);
 
-		return PersonID_t{impl->people.size() - 1};
+		return PersonID_t{impl->add_person(name, std::move(start_date), std::move(wt))};
 	}
 
 	void Database::edit_employee_name(const PersonID_t employee, const char* name) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_employee_name");
+		impl->block_for_write();
 		impl->validate(employee);
 
-		impl->people[employee].name = name;
+		impl->people[employee].name = impl->names.intern(name);
+		impl->invalidate_name_index();
 	}
 
 	void Database::edit_employee_start_date(const PersonID_t employee, uint16_t start_year,
 	                                        uint16_t start_month, uint16_t start_day) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_employee_start_date");
+		impl->block_for_write();
 		impl->validate(employee);
 
 		auto new_date = _detail::create_date_safe(start_year, start_month, start_day);
 
 		impl->people[employee].start_date = std::move(new_date);
+		impl->replan_person(employee);
 	}
 
 	void Database::edit_employee_work_time(const PersonID_t employee, const char* work_time) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_employee_work_time");
+		impl->block_for_write();
 		impl->validate(employee);
 
 		auto new_work_time = _detail::create_number_safe(work_time);
 
 		impl->people[employee].percent_time = std::move(new_work_time);
+		impl->replan_person(employee);
+	}
+
+	void Database::edit_employee_work_time(const PersonID_t employee, Rational_t work_time) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_employee_work_time");
+		impl->block_for_write();
+		impl->validate(employee);
+
+		auto new_work_time = _detail::create_number_safe(work_time);
+
+		impl->people[employee].percent_time = std::move(new_work_time);
+		impl->replan_person(employee);
 	}
 
 	Extra_TimeID_t Database::edit_employee_add_extra_work_time(
 	    PersonID_t employee, uint16_t start_year, uint16_t start_month, uint16_t start_day,
 	    uint16_t end_year, uint16_t end_month, uint16_t end_day, const char* time) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_employee_add_extra_work_time");
+		impl->block_for_write();
 		impl->validate(employee);
 
 		_detail::Date start_date = _detail::create_date_safe(start_year, start_month, start_day);
 		_detail::Date end_date = _detail::create_date_safe(end_year, end_month, end_day);
 		_detail::Number time_num = _detail::create_number_safe(time);
 
-		_detail::Person::Extra_Time_t ett;
-		ett.begin = std::move(start_date);
-		ett.end = std::move(end_date);
-		ett.percent_time = std::move(time_num);
+		return Extra_TimeID_t{impl->add_extra_time(employee, std::move(start_date),
+		                                           std::move(end_date), std::move(time_num))};
+	}
 
-		impl->people[employee].extra_time.push_back(std::move(ett));
+	Extra_TimeID_t Database::edit_employee_add_extra_work_time(
+	    PersonID_t employee, uint16_t start_year, uint16_t start_month, uint16_t start_day,
+	    uint16_t end_year, uint16_t end_month, uint16_t end_day, Rational_t time) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_employee_add_extra_work_time");
+		impl->block_for_write();
+		impl->validate(employee);
 
-		return Extra_TimeID_t{impl->people[employee].extra_time.size() - 1};
+		_detail::Date start_date = _detail::create_date_safe(start_year, start_month, start_day);
+		_detail::Date end_date = _detail::create_date_safe(end_year, end_month, end_day);
+		_detail::Number time_num = _detail::create_number_safe(time);
+
+		return Extra_TimeID_t{impl->add_extra_time(employee, std::move(start_date),
+		                                           std::move(end_date), std::move(time_num))};
 	}
 
 	void Database::edit_employee_remove_extra_work_time(const PersonID_t p,
 	                                                    const Extra_TimeID_t e) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_employee_remove_extra_work_time");
+		impl->block_for_write();
 		impl->validate(p, e);
 
+		auto detail = impl->pin(p, true);
 		impl->people[p].extra_time[e].valid = false;
+		impl->rebuild_work_time(p);
 	}
 
 	PersonID_t Database::find_employee(const char* name) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "find_employee");
 		impl->block_if_locked();
 
+		// Names are interned, so only the id has to be compared
+		auto id = impl->names.find(name);
 		auto employee_it =
 		    std::find_if(impl->people.begin(), impl->people.end(),
-		                 [name](_detail::Person& p) { return p.valid && (p.name == name); });
+		                 [id](_detail::Person& p) { return p.valid && (p.name == id); });
 
 		bool found = employee_it != impl->people.end();
 		if (found) {
@@ -118,59 +162,41 @@ namespace Vacationdb {
 	}
 
 	void Database::delete_employee(const PersonID_t employee) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "delete_employee");
+		impl->block_for_write();
 		impl->validate(employee);
 
 		impl->people[employee].valid = false;
+		impl->replan_person(employee);
+		impl->invalidate_name_index();
 	}
 
 	std::string Database::get_employee_name(const PersonID_t employee) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_employee_name");
 		impl->block_if_locked();
 		impl->validate(employee);
 
-		return impl->people[employee].name;
+		return std::string(impl->names.view(impl->people[employee].name));
 	}
 
-	Person_Info_t Database::get_employee_info(const PersonID_t employee) {
+	std::string_view Database::get_employee_name_view(const PersonID_t employee) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_employee_name_view");
 		impl->block_if_locked();
 		impl->validate(employee);
 
-		_detail::Person& p = impl->people[employee];
-
-		std::string work_time = p.percent_time.convert_to<std::string>();
-
-		using ewti_type = Person_Info_t::Extra_Work_Time_Info_t;
-		std::vector<ewti_type> ewti;
-		ewti.reserve(p.extra_time.size());
-		size_t i = 0;
-		for (auto&& et : p.extra_time) {
-			if (et.valid) {
-				uint16_t start_year = et.begin.year();
-				uint16_t start_month = et.begin.month();
-				uint16_t start_day = et.begin.day();
-				uint16_t end_year = et.end.year();
-				uint16_t end_month = et.end.month();
-				uint16_t end_day = et.end.day();
-				std::string percent = et.percent_time.convert_to<std::string>();
-
-				ewti.push_back(ewti_type{Extra_TimeID_t{i}, start_year, start_month, start_day,
-				                         end_year, end_month, end_day, percent});
-			}
-			i++;
-		}
+		return impl->names.view(impl->people[employee].name);
+	}
 
-		Person_Info_t pi{employee,
-		                 p.name,
-		                 p.start_date.year(),
-		                 p.start_date.month(),
-		                 p.start_date.day(),
-		                 std::move(work_time),
-		                 std::move(ewti)};
+	Person_Info_t Database::get_employee_info(const PersonID_t employee) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_employee_info");
+		impl->block_if_locked();
+		impl->validate(employee);
 
-		return pi;
+		return impl->employee_info(employee);
 	}
 
 	size_t Database::get_employee_count() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_employee_count");
 		impl->block_if_locked();
 
 		size_t valid_count =
@@ -181,6 +207,7 @@ namespace Vacationdb {
 	}
 
 	std::vector<std::string> Database::list_employee_names() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "list_employee_names");
 		impl->block_if_locked();
 
 		std::vector<std::string> ret;
@@ -188,7 +215,7 @@ namespace Vacationdb {
 
 		for (auto&& p : impl->people) {
 			if (p.valid) {
-				ret.emplace_back(p.name);
+				ret.emplace_back(impl->names.view(p.name));
 			}
 		}
 
@@ -196,96 +223,176 @@ namespace Vacationdb {
 	}
 
 	std::vector<Person_Info_t> Database::list_employee_info() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "list_employee_info");
 		impl->block_if_locked();
 
-		std::vector<Person_Info_t> ret;
+		return impl->employee_info_list();
+	}
+
+	std::vector<PersonID_t> Database::list_employee_ids() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "list_employee_ids");
+		impl->block_if_locked();
+
+		std::vector<PersonID_t> ret;
 		ret.reserve(impl->people.size());
 
 		for (size_t i = 0; i < impl->people.size(); ++i) {
 			if (impl->people[i].valid) {
-				ret.push_back(this->get_employee_info(PersonID_t{i}));
+				ret.emplace_back(i);
+			}
+		}
+
+		return ret;
+	}
+
+	std::vector<PersonID_t> Database::list_employee_ids_by_name() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "list_employee_ids_by_name");
+		impl->block_if_locked();
+
+		auto order = impl->people_by_name();
+		return std::vector<PersonID_t>(order.begin(), order.end());
+	}
+
+	std::vector<PersonID_t> Database::find_employees_containing(const char* text) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "find_employees_containing");
+		impl->block_if_locked();
+
+		std::string_view needle{text};
+		std::vector<PersonID_t> ret;
+		for (auto i : impl->people_by_name()) {
+			if (impl->names.view(impl->people[i].name).find(needle) != std::string_view::npos) {
+				ret.emplace_back(i);
 			}
 		}
 
 		return ret;
 	}
 
+	std::future<std::vector<Person_Info_t>> Database::list_employee_info_async() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "list_employee_info_async");
+		impl->block_if_locked();
+
+		auto* db = impl.get();
+		return impl->submit_read([db] { return db->employee_info_list(); });
+	}
+
 	/////////////////////////////
 	// Operations on day types //
 	/////////////////////////////
 
 	DayID_t Database::add_day(const char* name, const char* rollover, const char* yearly_bonus) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "add_day");
+		impl->block_for_write();
 
 		auto rollover_number = _detail::create_number_safe(rollover);
 		auto yearly_bonus_number = _detail::create_number_safe(yearly_bonus);
 
-		_detail::Day d;
-		d.name = name;
-		d.rollover = std::move(rollover_number);
-		d.yearly_bonus = std::move(yearly_bonus_number);
-		d.rules = std::vector<_detail::Day::Day_Rules_Data>();
+		return DayID_t{
+		    impl->add_day_type(name, std::move(rollover_number), std::move(yearly_bonus_number))};
+	}
 
-		impl->day_types.emplace_back(std::move(d));
-		impl->add_day_to_people();
+	DayID_t Database::add_day(const char* name, Rational_t rollover, Rational_t yearly_bonus) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "add_day");
+		impl->block_for_write();
 
-		return DayID_t{impl->day_types.size() - 1};
+		auto rollover_number = _detail::create_number_safe(rollover);
+		auto yearly_bonus_number = _detail::create_number_safe(yearly_bonus);
+
+		return DayID_t{
+		    impl->add_day_type(name, std::move(rollover_number), std::move(yearly_bonus_number))};
 	}
 
 	void Database::edit_day_name(const DayID_t d, const char* name) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_day_name");
+		impl->block_for_write();
 		impl->validate(d);
 
-		impl->day_types[d].name = name;
+		impl->day_types[d].name = impl->names.intern(name);
 	}
 
 	void Database::edit_day_rollover(const DayID_t d, const char* rollover) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_day_rollover");
+		impl->block_for_write();
+		impl->validate(d);
+
+		auto rollover_number = _detail::create_number_safe(rollover);
+
+		impl->day_types[d].rollover = std::move(rollover_number);
+		impl->replan_day(d);
+	}
+
+	void Database::edit_day_rollover(const DayID_t d, Rational_t rollover) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_day_rollover");
+		impl->block_for_write();
 		impl->validate(d);
 
 		auto rollover_number = _detail::create_number_safe(rollover);
 
 		impl->day_types[d].rollover = std::move(rollover_number);
+		impl->replan_day(d);
 	}
 
 	void Database::edit_day_yearly_bonus(const DayID_t d, const char* yearly_bonus) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_day_yearly_bonus");
+		impl->block_for_write();
+		impl->validate(d);
+
+		auto yearly_bonus_number = _detail::create_number_safe(yearly_bonus);
+
+		impl->day_types[d].yearly_bonus = std::move(yearly_bonus_number);
+		impl->replan_day(d);
+	}
+
+	void Database::edit_day_yearly_bonus(const DayID_t d, Rational_t yearly_bonus) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_day_yearly_bonus");
+		impl->block_for_write();
 		impl->validate(d);
 
 		auto yearly_bonus_number = _detail::create_number_safe(yearly_bonus);
 
 		impl->day_types[d].yearly_bonus = std::move(yearly_bonus_number);
+		impl->replan_day(d);
 	}
 
 	RuleID_t Database::edit_day_add_rule(DayID_t day, uint32_t month_start,
 	                                     const char* days_per_year) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_day_add_rule");
+		impl->block_for_write();
 		impl->validate(day);
 
 		auto dpy = _detail::create_number_safe(days_per_year);
 
-		_detail::Day::Day_Rules_Data drd;
-		drd.month_begin = month_start;
-		drd.days_per_year = std::move(dpy);
+		return RuleID_t{impl->add_rule(day, month_start, std::move(dpy))};
+	}
 
-		impl->day_types[day].rules.push_back(std::move(drd));
+	RuleID_t Database::edit_day_add_rule(DayID_t day, uint32_t month_start,
+	                                     Rational_t days_per_year) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_day_add_rule");
+		impl->block_for_write();
+		impl->validate(day);
+
+		auto dpy = _detail::create_number_safe(days_per_year);
 
-		return RuleID_t{impl->day_types[day].rules.size() - 1};
+		return RuleID_t{impl->add_rule(day, month_start, std::move(dpy))};
 	}
 
 	void Database::edit_day_remove_rule(DayID_t day, RuleID_t rule) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "edit_day_remove_rule");
+		impl->block_for_write();
 		impl->validate(day, rule);
 
 		impl->day_types[day].rules[rule].valid = false;
+		impl->replan_day(day);
 	}
 
 	DayID_t Database::find_day(const char* name) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "find_day");
 		impl->block_if_locked();
 
+		auto id = impl->names.find(name);
 		auto found_it =
 		    std::find_if(impl->day_types.begin(), impl->day_types.end(),
-		                 [name](_detail::Day& d) { return d.valid && (d.name == name); });
+		                 [id](_detail::Day& d) { return d.valid && (d.name == id); });
 
 		bool found = found_it != impl->day_types.end();
 		if (found) {
@@ -298,20 +405,32 @@ namespace Vacationdb {
 	}
 
 	void Database::delete_day(const DayID_t d) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "delete_day");
+		impl->block_for_write();
 		impl->validate(d);
 
 		impl->day_types[d].valid = false;
+		impl->replan_day(d);
 	}
 
 	std::string Database::get_day_name(const DayID_t d) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_day_name");
 		impl->block_if_locked();
 		impl->validate(d);
 
-		return impl->day_types[d].name;
+		return std::string(impl->names.view(impl->day_types[d].name));
+	}
+
+	std::string_view Database::get_day_name_view(const DayID_t d) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_day_name_view");
+		impl->block_if_locked();
+		impl->validate(d);
+
+		return impl->names.view(impl->day_types[d].name);
 	}
 
 	Day_Info_t Database::get_day_info(const DayID_t d) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_day_info");
 		impl->block_if_locked();
 		impl->validate(d);
 
@@ -334,12 +453,14 @@ namespace Vacationdb {
 			}
 		}
 
-		Day_Info_t ret{d, internal.name, std::move(ro), std::move(yb), std::move(r)};
+		std::string name{impl->names.view(internal.name)};
+		Day_Info_t ret{d, std::move(name), std::move(ro), std::move(yb), std::move(r)};
 
 		return ret;
 	}
 
 	size_t Database::get_day_count() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_day_count");
 		impl->block_if_locked();
 
 		size_t valid_count =
@@ -350,12 +471,13 @@ namespace Vacationdb {
 	}
 
 	std::vector<std::string> Database::list_day_names() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "list_day_names");
 		impl->block_if_locked();
 
 		std::vector<std::string> ret;
 		for (auto&& dt : impl->day_types) {
 			if (dt.valid) {
-				ret.push_back(dt.name);
+				ret.emplace_back(impl->names.view(dt.name));
 			}
 		}
 
@@ -363,6 +485,7 @@ namespace Vacationdb {
 	}
 
 	std::vector<Day_Info_t> Database::list_day_info() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "list_day_info");
 		impl->block_if_locked();
 
 		std::vector<Day_Info_t> ret;
@@ -383,348 +506,558 @@ namespace Vacationdb {
 
 	void Database::add_day_off(const PersonID_t p, const DayID_t d, uint16_t year, uint16_t month,
 	                           uint16_t day, const char* value) {
-		impl->block_if_locked();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "add_day_off");
+		impl->block_for_write();
 		impl->validate(p);
 		impl->validate(d);
 
 		auto date = _detail::create_date_safe(year, month, day);
 		auto val = _detail::create_number_safe(value);
 
-		impl->people[p].days_taken[d].push_back(
-		    _detail::Person::Day_Taken_t{std::move(date), std::move(val)});
+		impl->add_day_taken(p, d, std::move(date), std::move(val));
 	}
 
-	void Database::remove_day_off(const PersonID_t p, const DayID_t d, uint16_t year,
-	                              uint16_t month, uint16_t day) {
-		impl->block_if_locked();
+	void Database::add_day_off(const PersonID_t p, const DayID_t d, uint16_t year, uint16_t month,
+	                           uint16_t day, Rational_t value) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "add_day_off");
+		impl->block_for_write();
 		impl->validate(p);
 		impl->validate(d);
 
 		auto date = _detail::create_date_safe(year, month, day);
+		auto val = _detail::create_number_safe(value);
 
-		auto& dates = impl->people[p].days_taken[d];
-		auto it =
-		    std::find_if(dates.begin(), dates.end(), [&date](auto cur) { return date == cur.day; });
+		impl->add_day_taken(p, d, std::move(date), std::move(val));
+	}
 
-		if (it != dates.end()) {
-			dates.erase(it);
+	void Database::add_days_off(const PersonID_t p, const DayID_t d,
+	                            const std::vector<Date_t>& days) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "add_days_off");
+		impl->block_for_write();
+		impl->validate(p);
+		impl->validate(d);
+
+		// Everything is checked before anything is added
+		std::vector<std::pair<_detail::Date, _detail::Number>> parsed;
+		parsed.reserve(days.size());
+		for (auto&& day : days) {
+			parsed.emplace_back(_detail::create_date_safe(day.year, day.month, day.day),
+			                    _detail::create_number_safe(day.amount.c_str()));
 		}
+
+		impl->add_days_taken(p, d, std::move(parsed));
+	}
+
+	void Database::remove_day_off(const PersonID_t p, const DayID_t d, uint16_t year,
+	                              uint16_t month, uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "remove_day_off");
+		impl->block_for_write();
+		impl->validate(p);
+		impl->validate(d);
+
+		auto date = _detail::create_date_safe(year, month, day);
+
+		impl->remove_day_taken(p, d, date);
 	}
 
 	std::vector<Date_t> Database::list_days_off(const PersonID_t p, const DayID_t d) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "list_days_off");
 		impl->block_if_locked();
 		impl->validate(p);
 		impl->validate(d);
 
-		auto&& source_array = impl->people[p].days_taken[d];
-
-		std::vector<Date_t> ret;
-		ret.reserve(source_array.size());
+		auto detail = impl->pin(p);
+		return impl->days_taken_list(impl->days_taken(p, d));
+	}
 
-		for (auto& taken : source_array) {
-			uint16_t year = taken.day.year();
-			uint16_t month = taken.day.month();
-			uint16_t day = taken.day.day();
-			std::string amount = taken.value.convert_to<std::string>();
+	std::vector<Date_t> Database::list_days_off(const PersonID_t p, const DayID_t d,
+	                                            uint16_t from_year, uint16_t from_month,
+	                                            uint16_t from_day, uint16_t to_year,
+	                                            uint16_t to_month, uint16_t to_day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "list_days_off");
+		impl->block_if_locked();
+		impl->validate(p);
+		impl->validate(d);
 
-			ret.push_back(Date_t{year, month, day, std::move(amount)});
-		}
+		auto from = _detail::create_date_safe(from_year, from_month, from_day);
+		auto to = _detail::create_date_safe(to_year, to_month, to_day);
 
-		return ret;
+		auto detail = impl->pin(p);
+		return impl->days_taken_list(impl->days_taken(p, d, from, to));
 	}
 
-#define LIBVACATIONDB_QUERY_DEBUG 0
-
 	std::string Database::query_vacation_days(const PersonID_t p, const DayID_t d, uint16_t year,
 	                                          uint16_t month, uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "query_vacation_days");
 		impl->block_if_locked();
 		impl->validate(p);
 		impl->validate(d);
 
-		using namespace boost::gregorian;
-
-		struct Event_t {
-			_detail::Date date;
-			enum Tag_t {
-				Extra_Time_Event = 0,
-				Day_Rules_Event = 1,
-				Year_Start_Event = 2,
-				Day_Off_Event = 3,
-				End_of_Query_Event = 4
-			} tag;
-
-			struct Extra_Time_Event_t {
-				_detail::Number value;
-				enum OnOff_t : bool { enable = 1, disable = 0 } on;
-			};
-
-			struct Day_Rules_Event_t {
-				// Day_Rules_Event_t& operator=(const Day_Rules_Event_t&) = default;
-				// Day_Rules_Event_t& operator=(Day_Rules_Event_t&&) = default;
-				_detail::Number value;
-			};
-
-			struct Day_Off_Event_t {
-				// Day_Off_Event_t& operator=(const Day_Off_Event_t&) = default;
-				// Day_Off_Event_t& operator=(Day_Off_Event_t&&) = default;
-				_detail::Number value;
-			};
-
-			boost::variant<Extra_Time_Event_t, Day_Rules_Event_t, Day_Off_Event_t, std::nullptr_t>
-			    data;
-		};
+		auto query_date = _detail::create_date_safe(year, month, day);
+
+		auto accrued = impl->accrue_day(p, d, query_date);
+
+		// Convert amount to string, and return
+		_detail::Trace_Span span{"query: to string"};
+		auto outstring = accrued.convert_to<std::string>();
+		return outstring;
+	}
 
-		// References to appropriate data
-		auto&& person = impl->people[p];
-		auto&& day_type = impl->day_types[d];
+	std::vector<Person_Days_t> Database::query_vacation_days(const PersonID_t p, uint16_t year,
+	                                                         uint16_t month, uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "query_vacation_days_all_types");
+		impl->block_if_locked();
+		impl->validate(p);
 
 		auto query_date = _detail::create_date_safe(year, month, day);
 
-		// Sum up the total amount of events to expect
-		// May overallocate due to invalid events
-		size_t num_ete = person.extra_time.size() * 2;                        // Extra time events
-		size_t num_dre = day_type.rules.size();                               // Day rule events
-		size_t num_yse = ((query_date - person.start_date).days() / 365) + 2; // Year start events
-		size_t num_doe = person.days_taken[d].size();                         // Day taken event
-		size_t num_eqe = 1;                                                   // End of query event
-
-		// Create and reserve the appropriate amount of space in the array
-		std::vector<Event_t> events;
-		events.reserve(num_ete + num_dre + num_yse + num_doe + num_eqe);
-
-		// Add all extra time events
-		for (auto&& data : person.extra_time) {
-			using s_t = Event_t::Extra_Time_Event_t;
-			auto e_t = Event_t::Extra_Time_Event;
-
-			if (data.valid) {
-				auto start_event = s_t{data.percent_time, static_cast<decltype(s_t::on)>(true)};
-				auto end_event = s_t{person.percent_time, static_cast<decltype(s_t::on)>(false)};
-
-				events.push_back(Event_t{data.begin, e_t, std::move(start_event)});
-				events.push_back(Event_t{data.end, e_t, std::move(end_event)});
+		std::vector<size_t> valid_days;
+		valid_days.reserve(impl->day_types.size());
+		for (size_t i = 0; i < impl->day_types.size(); ++i) {
+			if (impl->day_types[i].valid) {
+				valid_days.push_back(i);
 			}
 		}
 
-		// Add all Day Rule Events
-		for (auto&& data : day_type.rules) {
-			using s_t = Event_t::Day_Rules_Event_t;
-			auto e_t = Event_t::Day_Rules_Event;
+		// All day types share one sweep over the employee's timeline
+		auto accrued = impl->accrue_days(p, valid_days, query_date);
 
-			if (data.valid) {
-				auto date = person.start_date + months{static_cast<int32_t>(data.month_begin) - 1};
-				auto event = s_t{data.days_per_year};
+		_detail::Trace_Span span{"query: to string"};
+		std::vector<Person_Days_t> ret;
+		ret.reserve(valid_days.size());
 
-				events.push_back(Event_t{std::move(date), e_t, std::move(event)});
-			}
+		for (size_t i = 0; i < valid_days.size(); ++i) {
+			auto day_name = impl->names.view(impl->day_types[valid_days[i]].name);
+			ret.push_back(
+			    Person_Days_t{std::string(day_name), accrued[i].convert_to<std::string>()});
 		}
 
-		// Add all year start events
-		// Including the one at the beginning of their employment
-		{
-			auto e_t = Event_t::Year_Start_Event;
-			events.push_back(Event_t{person.start_date, e_t, nullptr});
-
-			int16_t start_year = person.start_date.year();
-			_detail::Date working_date;
-			for (size_t i = 1;
-			     (working_date = _detail::Date(uint16_t(start_year + i), 1, 1)) <= query_date;
-			     ++i) {
-				events.push_back(Event_t{working_date, e_t, nullptr});
-			}
-		}
+		return ret;
+	}
 
-		// Add add day off events
-		for (auto&& data : person.days_taken[d]) {
-			using s_t = Event_t::Day_Off_Event_t;
-			auto e_t = Event_t::Day_Off_Event;
+	std::future<std::string> Database::query_vacation_days_async(const PersonID_t p,
+	                                                             const DayID_t d, uint16_t year,
+	                                                             uint16_t month, uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "query_vacation_days_async");
+		impl->block_if_locked();
+		impl->validate(p);
+		impl->validate(d);
 
-			auto event = s_t{data.value};
-			events.push_back(Event_t{data.day, e_t, event});
-		}
+		auto query_date = _detail::create_date_safe(year, month, day);
 
-		// Add the single end of query event
-		events.push_back(Event_t{query_date, Event_t::End_of_Query_Event, nullptr});
+		auto promise = std::make_shared<std::promise<std::string>>();
+		auto future = promise->get_future();
 
-		// Sort the structures into chronological order
-		auto sort_func = [](Event_t left, Event_t right) -> bool {
-			if (left.date != right.date) {
-				return left.date < right.date;
-			}
-			else {
-				return left.tag < right.tag;
-			}
+		_detail::db_impl::Batched_Query_t query;
+		query.person = p;
+		query.date = query_date;
+		query.days = std::vector<size_t>{d};
+		query.deliver = [promise](std::vector<_detail::Number>& accrued) {
+			promise->set_value(accrued[0].convert_to<std::string>());
 		};
+		query.fail = [promise](std::exception_ptr error) { promise->set_exception(error); };
 
-		std::sort(events.begin(), events.end(), sort_func);
-
-		// Use a state machine to calculate the amount of days accrued.
-		_detail::Number accrued{0};
-		_detail::Number& default_percent = person.percent_time;
-		_detail::Number current_rate{0};
-		_detail::Number current_percent = default_percent;
-		_detail::Date current_date = person.start_date;
-		bool end_of_query = false;
-
-		// Length of a year in days
-		auto year_val = _detail::create_number_safe("365");
-		auto leap_year_val = _detail::create_number_safe("366");
-		auto current_year_length = year_val;
-
-		for (auto&& event : events) {
-#if LIBVACATIONDB_QUERY_DEBUG
-			std::cout << "\n----------------------\n" << event.date << " - ";
-			switch (event.tag) {
-				case Event_t::Extra_Time_Event:
-					std::cout << "Extra time event\n";
-					break;
-				case Event_t::Day_Rules_Event:
-					std::cout << "Day rules event\n";
-					break;
-				case Event_t::Year_Start_Event:
-					std::cout << "Year start event\n";
-					break;
-				case Event_t::Day_Off_Event:
-					std::cout << "Day Off Event\n";
-					break;
-				case Event_t::End_of_Query_Event:
-					std::cout << "End of query event\n";
-					break;
-			}
-#endif
-
-			auto diff = (event.date - current_date);
-			auto diff_days = diff.days();
-			if (diff_days >= 0) {
-#if LIBVACATIONDB_QUERY_DEBUG
-				std::cout << " Days: " << diff_days << '\n';
-#endif
-				auto diff_val = _detail::Number{diff_days};
-				auto years = diff_val / current_year_length;
-				accrued += (years * current_rate * current_percent);
-				current_date = event.date;
-			}
+		impl->submit_query(std::move(query));
 
-			switch (event.tag) {
-				case Event_t::Extra_Time_Event: {
-					auto&& data = boost::get<Event_t::Extra_Time_Event_t>(event.data);
-					if (data.on) {
-						current_percent = data.value;
-					}
-					else {
-						current_percent = default_percent;
-					}
-					break;
-				}
-
-				case Event_t::Day_Rules_Event: {
-					auto&& data = boost::get<Event_t::Day_Rules_Event_t>(event.data);
-#if LIBVACATIONDB_QUERY_DEBUG
-					std::cout << " Rate: " << data.value << '\n';
-#endif
-					current_rate = data.value;
-					break;
-				}
-
-				case Event_t::Year_Start_Event: {
-					// Negative values signal complete rollover
-					if (day_type.rollover >= 0) {
-						accrued = std::min(accrued, day_type.rollover);
-					}
-					accrued += day_type.yearly_bonus;
-					current_year_length =
-					    boost::gregorian::gregorian_calendar::is_leap_year(event.date.year())
-					        ? leap_year_val
-					        : year_val;
-					break;
-				}
-
-				case Event_t::Day_Off_Event: {
-					auto&& data = boost::get<Event_t::Day_Off_Event_t>(event.data);
-					if (diff_days >= 0) {
-						accrued -= data.value;
-					}
-					break;
-				}
-
-				case Event_t::End_of_Query_Event: {
-					end_of_query = true;
-					break;
-				}
-				default:
-					break;
-			}
+		return future;
+	}
+
+	std::future<std::vector<Person_Days_t>> Database::query_vacation_days_async(
+	    const PersonID_t p, uint16_t year, uint16_t month, uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "query_vacation_days_async_all_types");
+		impl->block_if_locked();
+		impl->validate(p);
 
-#if LIBVACATIONDB_QUERY_DEBUG
-			std::cout << "Value: " << accrued << '\n';
-#endif
+		auto query_date = _detail::create_date_safe(year, month, day);
 
-			if (end_of_query) {
-				break;
+		std::vector<size_t> valid_days;
+		valid_days.reserve(impl->day_types.size());
+		for (size_t i = 0; i < impl->day_types.size(); ++i) {
+			if (impl->day_types[i].valid) {
+				valid_days.push_back(i);
 			}
 		}
 
-		// Convert amount to string, and return
-		auto outstring = accrued.convert_to<std::string>();
-		return outstring;
+		auto promise = std::make_shared<std::promise<std::vector<Person_Days_t>>>();
+		auto future = promise->get_future();
+
+		auto* db = impl.get();
+
+		_detail::db_impl::Batched_Query_t query;
+		query.person = p;
+		query.date = query_date;
+		query.days = valid_days;
+		query.deliver = [promise, db, valid_days](std::vector<_detail::Number>& accrued) {
+			std::vector<Person_Days_t> ret;
+			ret.reserve(valid_days.size());
+			for (size_t i = 0; i < valid_days.size(); ++i) {
+				auto day_name = db->names.view(db->day_types[valid_days[i]].name);
+				ret.push_back(Person_Days_t{std::string(day_name),
+				                            accrued[i].convert_to<std::string>()});
+			}
+			promise->set_value(std::move(ret));
+		};
+		query.fail = [promise](std::exception_ptr error) { promise->set_exception(error); };
+
+		impl->submit_query(std::move(query));
+
+		return future;
 	}
 
-	std::vector<Person_Days_t> Database::query_vacation_days(const PersonID_t p, uint16_t year,
-	                                                         uint16_t month, uint16_t day) {
+	Rational_t Database::query_vacation_days_value(const PersonID_t p, const DayID_t d,
+	                                               uint16_t year, uint16_t month, uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "query_vacation_days_value");
 		impl->block_if_locked();
 		impl->validate(p);
+		impl->validate(d);
 
-		std::vector<Person_Days_t> ret;
-		ret.reserve(impl->day_types.size());
+		auto query_date = _detail::create_date_safe(year, month, day);
 
-		size_t i = 0;
-		for (auto&& day_type : impl->day_types) {
-			if (day_type.valid) {
-				auto&& day_name = day_type.name;
-				auto value = this->query_vacation_days(p, DayID_t{i}, year, month, day);
-				ret.push_back(Person_Days_t{day_name, value});
-			}
-			i++;
+		auto accrued = impl->accrue_day(p, d, query_date);
+
+		return _detail::create_rational_safe(accrued);
+	}
+
+	std::string Database::query_work_time(const PersonID_t p, uint16_t year, uint16_t month,
+	                                      uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "query_work_time");
+		impl->block_if_locked();
+		impl->validate(p);
+
+		auto date = _detail::create_date_safe(year, month, day);
+
+		auto detail = impl->pin(p);
+		return impl->work_time_on(p, date).convert_to<std::string>();
+	}
+
+	Rational_t Database::query_work_time_value(const PersonID_t p, uint16_t year, uint16_t month,
+	                                           uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "query_work_time_value");
+		impl->block_if_locked();
+		impl->validate(p);
+
+		auto date = _detail::create_date_safe(year, month, day);
+
+		auto detail = impl->pin(p);
+		return _detail::create_rational_safe(impl->work_time_on(p, date));
+	}
+
+	std::string Database::query_days_used(const PersonID_t p, const DayID_t d, uint16_t from_year,
+	                                      uint16_t from_month, uint16_t from_day, uint16_t to_year,
+	                                      uint16_t to_month, uint16_t to_day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "query_days_used");
+		impl->block_if_locked();
+		impl->validate(p);
+		impl->validate(d);
+
+		auto from = _detail::create_date_safe(from_year, from_month, from_day);
+		auto to = _detail::create_date_safe(to_year, to_month, to_day);
+
+		return impl->days_used(p, d, from, to).convert_to<std::string>();
+	}
+
+	Rational_t Database::query_days_used_value(const PersonID_t p, const DayID_t d,
+	                                           uint16_t from_year, uint16_t from_month,
+	                                           uint16_t from_day, uint16_t to_year,
+	                                           uint16_t to_month, uint16_t to_day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "query_days_used_value");
+		impl->block_if_locked();
+		impl->validate(p);
+		impl->validate(d);
+
+		auto from = _detail::create_date_safe(from_year, from_month, from_day);
+		auto to = _detail::create_date_safe(to_year, to_month, to_day);
+
+		return _detail::create_rational_safe(impl->days_used(p, d, from, to));
+	}
+
+	Query_Plan_t Database::explain_query(const PersonID_t p, const DayID_t d, uint16_t year,
+	                                     uint16_t month, uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "explain_query");
+		impl->block_if_locked();
+		impl->validate(p);
+		impl->validate(d);
+
+		auto query_date = _detail::create_date_safe(year, month, day);
+
+		return impl->explain_query(p, d, query_date);
+	}
+
+	std::vector<Employee_Days_t> Database::report_vacation_days(const DayID_t d, uint16_t year,
+	                                                            uint16_t month, uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "report_vacation_days");
+		impl->block_if_locked();
+		impl->validate(d);
+
+		auto query_date = _detail::create_date_safe(year, month, day);
+
+		return impl->report_days(d, query_date);
+	}
+
+	std::vector<Employee_Days_Value_t> Database::report_vacation_days_value(const DayID_t d,
+	                                                                        uint16_t year,
+	                                                                        uint16_t month,
+	                                                                        uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "report_vacation_days_value");
+		impl->block_if_locked();
+		impl->validate(d);
+
+		auto query_date = _detail::create_date_safe(year, month, day);
+
+		std::vector<size_t> employees;
+		std::vector<_detail::Number> balances;
+		impl->report_balances(d, query_date, employees, balances);
+
+		std::vector<Employee_Days_Value_t> ret;
+		ret.reserve(employees.size());
+		for (size_t i = 0; i < employees.size(); ++i) {
+			ret.push_back(Employee_Days_Value_t{PersonID_t{employees[i]},
+			                                    _detail::create_rational_safe(balances[i])});
 		}
 
 		return ret;
 	}
 
+	std::vector<Employee_Days_Value_t> Database::scan_vacation_days(const DayID_t d, uint16_t year,
+	                                                                uint16_t month, uint16_t day,
+	                                                                Balance_Scan_t scan) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "scan_vacation_days");
+		impl->block_if_locked();
+		impl->validate(d);
+
+		auto query_date = _detail::create_date_safe(year, month, day);
+		auto threshold = _detail::create_number_safe(scan.threshold);
+
+		std::vector<size_t> employees;
+		std::vector<_detail::Number> balances;
+		impl->scan_balances(d, query_date, threshold, scan.op, employees, balances);
+
+		std::vector<Employee_Days_Value_t> ret;
+		ret.reserve(employees.size());
+		for (size_t i = 0; i < employees.size(); ++i) {
+			ret.push_back(Employee_Days_Value_t{PersonID_t{employees[i]},
+			                                    _detail::create_rational_safe(balances[i])});
+		}
+
+		return ret;
+	}
+
+	std::vector<Employee_Days_Value_t> Database::top_vacation_days(const DayID_t d, uint16_t year,
+	                                                               uint16_t month, uint16_t day,
+	                                                               size_t count, bool highest) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "top_vacation_days");
+		impl->block_if_locked();
+		impl->validate(d);
+
+		auto query_date = _detail::create_date_safe(year, month, day);
+
+		std::vector<size_t> employees;
+		std::vector<_detail::Number> balances;
+		impl->top_balances(d, query_date, count, highest, employees, balances);
+
+		std::vector<Employee_Days_Value_t> ret;
+		ret.reserve(employees.size());
+		for (size_t i = 0; i < employees.size(); ++i) {
+			ret.push_back(Employee_Days_Value_t{PersonID_t{employees[i]},
+			                                    _detail::create_rational_safe(balances[i])});
+		}
+
+		return ret;
+	}
+
+	std::future<std::vector<Employee_Days_t>> Database::report_vacation_days_async(
+	    const DayID_t d, uint16_t year, uint16_t month, uint16_t day) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "report_vacation_days_async");
+		impl->block_if_locked();
+		impl->validate(d);
+
+		auto query_date = _detail::create_date_safe(year, month, day);
+
+		auto* db = impl.get();
+		size_t day_type = d;
+		return impl->submit_read([db, day_type, query_date] {
+			return db->report_days(day_type, query_date);
+		});
+	}
+
 	/////////////////////////////////
 	// Loading/Saving the Database //
 	/////////////////////////////////
 
 	void Database::load(const char* name) {
-		impl->current_file_name = name;
-		impl->load_file();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "load");
+		this->load_async(name);
 		impl->block_if_locked();
+		// Rethrows anything the load threw, the database is left as it was
+		impl->io_future.get();
 	}
 
 	void Database::load_async(const char* name) {
-		impl->current_file_name = name;
-		impl->load_file();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "load_async");
+		impl->block_for_write();
+
+		impl->io_file_name = name;
+		impl->io_curop.store(IO_Status_t::LOAD);
+		impl->io_percentage.store(0);
+		impl->io_lock.store(true);
+
+		auto* db = impl.get();
+		impl->io_future = impl->workers().submit([db] { db->load_file(); });
 	}
 
 	void Database::save(const char* name) {
-		impl->current_file_name = name;
-		impl->save_file();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "save");
+		this->save_async(name);
 		impl->block_if_locked();
+		impl->io_future.get();
 	}
 
 	void Database::save_async(const char* name) {
-		impl->current_file_name = name;
-		impl->save_file();
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "save_async");
+		impl->block_if_locked();
+
+		impl->io_file_name = name;
+		impl->io_curop.store(IO_Status_t::SAVE);
+		impl->io_percentage.store(0);
+		impl->io_lock.store(true);
+
+		auto* db = impl.get();
+		impl->io_future = impl->workers().submit([db] { db->save_file(); });
 	}
 
 	void Database::clear_db() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "clear_db");
+		impl->block_for_write();
 		impl->clear();
 	}
 
 	std::string Database::get_current_filename() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_current_filename");
+		// Changed by the load or save once it has worked
+		impl->block_if_locked();
 		return impl->current_file_name;
 	}
 
 	IO_Status_t Database::get_load_status() {
-		return IO_Status_t{impl->io_curop, impl->io_percentage.load()};
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_load_status");
+		return IO_Status_t{impl->io_curop.load(), impl->io_percentage.load()};
+	}
+
+	void Database::set_lazy_load(const Lazy_Load_Config_t& config) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "set_lazy_load");
+		impl->block_for_write();
+		impl->lazy_load = config.enabled;
+		impl->warm_lazy_load = config.warm_in_background;
+	}
+
+	Lazy_Load_Stats_t Database::get_lazy_load_stats() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_lazy_load_stats");
+		impl->block_if_locked();
+
+		size_t pending = impl->detail_cache ? impl->detail_cache->pending() : 0;
+		return Lazy_Load_Stats_t{impl->lazy_load, pending};
+	}
+
+	////////////////////
+	// Worker threads //
+	////////////////////
+
+	void Database::set_thread_count(size_t thread_count) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "set_thread_count");
+		impl->block_for_write();
+
+		std::lock_guard<std::mutex> l(impl->pool_lock);
+		// The old workers finish what they have before they are replaced
+		impl->pool.reset();
+		impl->thread_count = thread_count;
+	}
+
+	Thread_Pool_Stats_t Database::get_thread_pool_stats() {
+		std::lock_guard<std::mutex> l(impl->pool_lock);
+		if (impl->pool) {
+			return impl->pool->stats();
+		}
+
+		size_t threads = impl->thread_count;
+		if (threads == 0) {
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		return Thread_Pool_Stats_t{threads, 0, 0, 0, 0};
+	}
+
+	/////////////
+	// Metrics //
+	/////////////
+
+	void Database::enable_metrics(bool enabled) {
+		impl->metrics.enable(enabled);
+	}
+
+	Database_Stats_t Database::get_stats() {
+		return impl->metrics.snapshot();
+	}
+
+	void Database::reset_stats() {
+		impl->metrics.reset();
+	}
+
+	Memory_Usage_t Database::memory_usage() {
+		impl->block_if_locked();
+		return impl->memory_usage();
+	}
+
+	/////////////////
+	// Out of core //
+	/////////////////
+
+	void Database::enable_out_of_core(const Out_Of_Core_Config_t& config) {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "enable_out_of_core");
+		impl->block_for_write();
+
+		// Everyone is read back in before moving to the new file, or out of
+		// the file a lazy load left them in
+		disable_out_of_core();
+		if (impl->detail_cache) {
+			impl->detail_cache->fault_all();
+		}
+		impl->detail_cache.reset(
+		    new _detail::Detail_Cache(config.page_file, config.memory_limit, impl->people));
+
+		// Pages out everyone past the limit
+		for (size_t p = 0; p < impl->people.size(); ++p) {
+			impl->pin(p, true);
+		}
+	}
+
+	void Database::disable_out_of_core() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "disable_out_of_core");
+		impl->block_for_write();
+
+		// A lazy load's cache is kept for whoever it hasn't read in yet
+		if (impl->detail_cache && impl->detail_cache->paged()) {
+			impl->detail_cache->fault_all();
+			impl->detail_cache.reset();
+		}
+	}
+
+	Out_Of_Core_Stats_t Database::get_out_of_core_stats() {
+		LIBVACATIONDB_METRIC_SCOPE(impl->metrics, "get_out_of_core_stats");
+
+		if (!impl->detail_cache) {
+			return Out_Of_Core_Stats_t{false, impl->people.size(), 0, 0, 0, 0, 0};
+		}
+		return impl->detail_cache->stats();
+	}
+
+	/////////////
+	// Tracing //
+	/////////////
+
+	void Database::start_tracing() {
+		_detail::Tracing::start();
+	}
+
+	void Database::stop_tracing(const char* filename) {
+		_detail::Tracing::stop(filename);
 	}
 }
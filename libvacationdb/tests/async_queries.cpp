@@ -0,0 +1,91 @@
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+
+#include <future>
+#include <vector>
+
+TEST(ASYNC_QUERIES, MatchesSynchronous) {
+	Vacationdb::Database db(2);
+
+	auto eid = db.add_employee("Bob", 2015, 3, 14, "1");
+	auto vacayid = db.add_day("Vacation", "-1", "0");
+	db.edit_day_add_rule(vacayid, 1, "24");
+	auto sickid = db.add_day("Sick", "5", "2");
+	db.edit_day_add_rule(sickid, 1, "9.96");
+	db.add_day_off(eid, sickid, 2016, 4, 21, "0.5");
+
+	// Issued together so they get batched into one sweep
+	auto vacay = db.query_vacation_days_async(eid, vacayid, 2017, 6, 30);
+	auto sick = db.query_vacation_days_async(eid, sickid, 2017, 6, 30);
+	auto all = db.query_vacation_days_async(eid, 2017, 6, 30);
+	auto earlier = db.query_vacation_days_async(eid, vacayid, 2016, 1, 1);
+
+	auto vacay_result = vacay.get();
+	auto sick_result = sick.get();
+	auto all_result = all.get();
+
+	ASSERT_STREQ(vacay_result.c_str(), db.query_vacation_days(eid, vacayid, 2017, 6, 30).c_str());
+	ASSERT_STREQ(sick_result.c_str(), db.query_vacation_days(eid, sickid, 2017, 6, 30).c_str());
+	ASSERT_STREQ(earlier.get().c_str(), db.query_vacation_days(eid, vacayid, 2016, 1, 1).c_str());
+
+	ASSERT_EQ(all_result.size(), size_t{2});
+	ASSERT_STREQ(all_result[0].day_name.c_str(), "Vacation");
+	ASSERT_STREQ(all_result[0].days.c_str(), vacay_result.c_str());
+	ASSERT_STREQ(all_result[1].day_name.c_str(), "Sick");
+	ASSERT_STREQ(all_result[1].days.c_str(), sick_result.c_str());
+}
+
+TEST(ASYNC_QUERIES, ManyEmployees) {
+	Vacationdb::Database db(2);
+
+	auto did = db.add_day("Vacation", "10", "5");
+	db.edit_day_add_rule(did, 1, "20");
+
+	std::vector<Vacationdb::PersonID_t> ids;
+	for (uint16_t i = 0; i < 100; ++i) {
+		ids.push_back(db.add_employee("Bob", uint16_t(2000 + i % 15), uint16_t(1 + i % 12), 1, "1"));
+	}
+
+	std::vector<std::future<std::string>> results;
+	for (auto&& id : ids) {
+		results.push_back(db.query_vacation_days_async(id, did, 2017, 1, 1));
+	}
+	auto report = db.report_vacation_days_async(did, 2017, 1, 1);
+	auto info = db.list_employee_info_async();
+
+	auto report_result = report.get();
+	ASSERT_EQ(report_result.size(), ids.size());
+	for (size_t i = 0; i < ids.size(); ++i) {
+		ASSERT_STREQ(results[i].get().c_str(), report_result[i].days.c_str());
+	}
+	ASSERT_EQ(info.get().size(), ids.size());
+}
+
+TEST(ASYNC_QUERIES, EditsWaitForQueries) {
+	Vacationdb::Database db(1);
+
+	auto eid = db.add_employee("Bob", 2017, 1, 1, "1");
+	auto did = db.add_day("Vacation", "-1", "0");
+	db.edit_day_add_rule(did, 1, "10");
+
+	auto before = db.query_vacation_days_async(eid, did, 2018, 1, 1);
+	db.edit_employee_work_time(eid, "1/2");
+	auto after = db.query_vacation_days_async(eid, did, 2018, 1, 1);
+
+	ASSERT_STREQ(before.get().c_str(), "10");
+	ASSERT_STREQ(after.get().c_str(), "5");
+}
+
+TEST(ASYNC_QUERIES, ThrowOnInvalidIndex) {
+	Vacationdb::Database db;
+
+	bool threw = false;
+	try {
+		db.query_vacation_days_async(Vacationdb::PersonID_t{0}, Vacationdb::DayID_t{0}, 2017, 1, 1);
+	}
+	catch (Vacationdb::Invalid_Index&) {
+		threw = true;
+	}
+
+	ASSERT_EQ(threw, true);
+}
@@ -0,0 +1,147 @@
+#include "database_impl.hpp"
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace {
+	using Vacationdb::_detail::Number;
+
+	Number value_of(const Vacationdb::Rational_t& value) {
+		return Vacationdb::_detail::create_number_safe(value);
+	}
+
+	Vacationdb::Rational_t rational(const Number& value) {
+		return Vacationdb::Rational_t{
+		    boost::multiprecision::numerator(value).convert_to<int64_t>(),
+		    boost::multiprecision::denominator(value).convert_to<int64_t>()};
+	}
+
+	// Every rollover policy, with rules, work time and days off all over the place
+	std::vector<Vacationdb::DayID_t> fill(Vacationdb::Database& db) {
+		std::vector<Vacationdb::DayID_t> days{db.add_day("None", "0", "1/2"),
+		                                      db.add_day("Capped", "5", "1"),
+		                                      db.add_day("Full", "-1", "1/3")};
+		for (auto d : days) {
+			db.edit_day_add_rule(d, 3, "25");
+		}
+		auto multi = db.add_day("Multi", "8", "0");
+		db.edit_day_add_rule(multi, 1, "10");
+		db.edit_day_add_rule(multi, 13, "20");
+		days.push_back(multi);
+
+		for (uint16_t i = 0; i < 400; ++i) {
+			auto name = "Employee " + std::to_string(i);
+			auto eid = db.add_employee(name.c_str(), static_cast<uint16_t>(2008 + i % 12),
+			                           static_cast<uint16_t>(i % 12 + 1),
+			                           static_cast<uint16_t>(i % 28 + 1), i % 3 ? "1" : "3/4");
+			for (auto d : days) {
+				db.add_day_off(eid, d, static_cast<uint16_t>(2012 + i % 5), 6, 1,
+				               i % 13 ? "1/4" : "60");
+				db.add_day_off(eid, d, 2019, 2, static_cast<uint16_t>(i % 28 + 1),
+				               std::to_string(i % 9).c_str());
+			}
+			if (i % 7 == 0) {
+				db.edit_employee_add_extra_work_time(eid, 2014, 1, 1, 2015, 1, 1, "1/2");
+			}
+			if (i % 50 == 0) {
+				db.delete_employee(eid);
+			}
+		}
+		return days;
+	}
+}
+
+TEST(DB_BALANCE_SCAN, Threshold) {
+	Vacationdb::Database db;
+	auto days = fill(db);
+
+	for (auto d : days) {
+		for (uint16_t year : std::initializer_list<uint16_t>{2010, 2018, 2019}) {
+			auto report = db.report_vacation_days_value(d, year, 3, 1);
+			for (const char* threshold : {"-3", "0", "6", "25/2", "40"}) {
+				for (auto op : {Vacationdb::Balance_Scan_t::AT_LEAST,
+				                Vacationdb::Balance_Scan_t::AT_MOST}) {
+					auto t = Vacationdb::_detail::create_number_safe(threshold);
+					std::vector<Vacationdb::Employee_Days_Value_t> expected;
+					for (auto&& entry : report) {
+						auto value = value_of(entry.days);
+						if (op == Vacationdb::Balance_Scan_t::AT_LEAST ? value >= t : value <= t) {
+							expected.push_back(entry);
+						}
+					}
+
+					auto found = db.scan_vacation_days(d, year, 3, 1,
+					                                   Vacationdb::Balance_Scan_t{op, rational(t)});
+					ASSERT_EQ(found.size(), expected.size());
+					for (size_t i = 0; i < found.size(); ++i) {
+						ASSERT_EQ(found[i].employee, expected[i].employee);
+						ASSERT_EQ(value_of(found[i].days), value_of(expected[i].days));
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(DB_BALANCE_SCAN, NearRolloverCap) {
+	Vacationdb::Database db;
+
+	auto did = db.add_day("Vacation", "10", "0");
+	db.edit_day_add_rule(did, 1, "20");
+	auto near = db.add_employee("Near", 2010, 1, 1, "1");
+	auto far = db.add_employee("Far", 2010, 1, 1, "1");
+	auto late = db.add_employee("Late", 2018, 11, 1, "1");
+	db.add_day_off(near, did, 2017, 12, 1, "9");
+	db.add_day_off(near, did, 2018, 1, 2, "1");
+	db.add_day_off(far, did, 2018, 1, 2, "12");
+
+	// Everyone within 2 days of the rollover cap at the start of the year
+	auto found = db.scan_vacation_days(did, 2018, 1, 2,
+	                                   Vacationdb::Balance_Scan_t{
+	                                       Vacationdb::Balance_Scan_t::AT_LEAST, {8, 1}});
+	ASSERT_EQ(found.size(), size_t{1});
+	ASSERT_EQ(found[0].employee, near);
+	// 9 and 20/365 days
+	ASSERT_EQ(value_of(found[0].days), Vacationdb::_detail::create_number_safe("3305/365"));
+
+	found = db.scan_vacation_days(did, 2018, 1, 2,
+	                              Vacationdb::Balance_Scan_t{Vacationdb::Balance_Scan_t::AT_MOST,
+	                                                         {0, 1}});
+	ASSERT_EQ(found.size(), size_t{2});
+	ASSERT_EQ(found[0].employee, far);
+	ASSERT_EQ(found[1].employee, late);
+}
+
+TEST(DB_BALANCE_SCAN, TopK) {
+	Vacationdb::Database db;
+	auto days = fill(db);
+
+	for (auto d : days) {
+		for (uint16_t year : std::initializer_list<uint16_t>{2010, 2019}) {
+			auto report = db.report_vacation_days_value(d, year, 3, 1);
+			for (bool highest : {true, false}) {
+				auto expected = report;
+				std::stable_sort(expected.begin(), expected.end(),
+				                 [highest](const Vacationdb::Employee_Days_Value_t& left,
+				                           const Vacationdb::Employee_Days_Value_t& right) {
+					                 auto l = value_of(left.days);
+					                 auto r = value_of(right.days);
+					                 return highest ? l > r : l < r;
+				                 });
+
+				for (size_t count : {size_t{0}, size_t{1}, size_t{10}, size_t{300}, size_t{1000}}) {
+					auto found = db.top_vacation_days(d, year, 3, 1, count, highest);
+					ASSERT_EQ(found.size(), std::min(count, expected.size()));
+					for (size_t i = 0; i < found.size(); ++i) {
+						ASSERT_EQ(found[i].employee, expected[i].employee);
+						ASSERT_EQ(value_of(found[i].days), value_of(expected[i].days));
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#include "batch_kernel.hpp"
+#include "gtest/gtest.h"
+#include <random>
+
+namespace {
+	Vacationdb::_detail::Batch_Columns_t random_columns(size_t lanes, std::mt19937_64& rng) {
+		Vacationdb::_detail::Batch_Columns_t columns;
+		columns.resize(lanes, 2000, 2020);
+
+		std::uniform_int_distribution<int64_t> year(1998, 2021);
+		std::uniform_int_distribution<int64_t> amount(-1000000, 1000000);
+		for (size_t e = 0; e < lanes; ++e) {
+			columns.start_year[e] = std::max<int64_t>(year(rng), columns.first_year);
+			columns.accrual_year[e] = columns.start_year[e] + year(rng) % 2;
+			columns.first_gain[e] = amount(rng);
+			columns.year_gain[e] = amount(rng);
+			columns.final_gain[e] = amount(rng);
+			columns.bonus[e] = amount(rng);
+			columns.cap[e] = std::abs(amount(rng));
+			columns.final_days_off[e] = amount(rng);
+			columns.balance[e] = columns.bonus[e];
+		}
+		for (auto& value : columns.days_off) {
+			value = amount(rng);
+		}
+		return columns;
+	}
+}
+
+TEST(BATCH_KERNEL, VectorMatchesScalar) {
+	using namespace Vacationdb::_detail;
+	if (!batch_avx2_supported()) {
+		GTEST_SKIP();
+	}
+
+	std::mt19937_64 rng{42};
+	for (auto policy : {Rollover_Policy::None, Rollover_Policy::Capped, Rollover_Policy::Full}) {
+		// Lane counts that do and don't fill the last vector
+		for (size_t lanes : {1, 4, 7, 64, 67}) {
+			auto scalar = random_columns(lanes, rng);
+			auto vector = scalar;
+
+			run_batch_scalar(scalar, policy);
+			run_batch_avx2(vector, policy);
+			ASSERT_EQ(scalar.balance, vector.balance);
+		}
+	}
+}
+
+TEST(BATCH_KERNEL, SingleLane) {
+	using namespace Vacationdb::_detail;
+	Batch_Columns_t columns;
+	columns.resize(1, 2018, 2020);
+	columns.start_year[0] = 2018;
+	columns.accrual_year[0] = 2018;
+	columns.first_gain[0] = 5;
+	columns.year_gain[0] = 20;
+	columns.final_gain[0] = 3;
+	columns.bonus[0] = 1;
+	columns.cap[0] = 3;
+	columns.days_off = {2, 30};
+	columns.final_days_off[0] = 1;
+	columns.balance[0] = 1;
+
+	auto capped = columns;
+	run_batch(capped, Rollover_Policy::Capped);
+	// 1 + 5 - 2 = 4 caps at 3, + 1 = 4, + 20 - 30 = -6, + 1 = -5, + 3 - 1 = -3
+	ASSERT_EQ(capped.balance[0], int64_t{-3});
+
+	auto full = columns;
+	run_batch(full, Rollover_Policy::Full);
+	ASSERT_EQ(full.balance[0], int64_t{-2});
+
+	auto none = columns;
+	run_batch(none, Rollover_Policy::None);
+	// 4 drops to 0, + 1 = 1, + 20 - 30 = -9, + 1 = -8, + 3 - 1 = -6
+	ASSERT_EQ(none.balance[0], int64_t{-6});
+}
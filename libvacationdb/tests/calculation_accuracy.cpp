@@ -3,6 +3,7 @@
 #include "gtest/gtest.h"
 #include <iostream>
 #include <string>
+#include <tuple>
 
 bool within(std::string& value, const char* expected, const char* epsilon);
 
@@ -276,3 +277,218 @@ TEST(CALC_ACCURACY, TestCase1) {
 	ASSERT_EQ(within(pers_result, "2", "1/2"), true);
 	ASSERT_EQ(within(sick_result, "1446/100", "1/4"), true);
 }
+
+TEST(CALC_ACCURACY, AllDayTypesMatchSingle) {
+	Vacationdb::Database db;
+
+	auto eid = db.add_employee("Bob", 2015, 3, 14, "1");
+	db.edit_employee_add_extra_work_time(eid, 2016, 2, 1, 2016, 9, 1, "0.5");
+
+	auto vacayid = db.add_day("Vacation", "-1", "0");
+	db.edit_day_add_rule(vacayid, 1, "24");
+	db.edit_day_add_rule(vacayid, 13, "30");
+	db.add_day_off(eid, vacayid, 2015, 7, 2, "1");
+	db.add_day_off(eid, vacayid, 2017, 1, 1, "2.5");
+
+	auto deleted = db.add_day("Deleted", "0", "3");
+	db.delete_day(deleted);
+
+	auto sickid = db.add_day("Sick", "5", "2");
+	db.edit_day_add_rule(sickid, 1, "9.96");
+	db.add_day_off(eid, sickid, 2016, 4, 21, "0.5");
+
+	auto all = db.query_vacation_days(eid, 2017, 6, 30);
+
+	ASSERT_EQ(all.size(), size_t{2});
+	ASSERT_STREQ(all[0].day_name.c_str(), "Vacation");
+	ASSERT_STREQ(all[0].days.c_str(),
+	             db.query_vacation_days(eid, vacayid, 2017, 6, 30).c_str());
+	ASSERT_STREQ(all[1].day_name.c_str(), "Sick");
+	ASSERT_STREQ(all[1].days.c_str(), db.query_vacation_days(eid, sickid, 2017, 6, 30).c_str());
+}
+
+TEST(CALC_ACCURACY, KernelsMatchSharedSweep) {
+	Vacationdb::Database db;
+
+	auto plain = db.add_employee("Bob", 2014, 5, 31, "1");
+	auto part = db.add_employee("Alice", 2014, 8, 12, "0.8");
+	db.edit_employee_add_extra_work_time(part, 2015, 2, 1, 2016, 9, 1, "0.5");
+	db.edit_employee_add_extra_work_time(part, 2016, 3, 1, 2016, 4, 1, "0");
+
+	// Every rollover policy with no, one and several rules
+	for (auto rollover : {"0", "5", "-1"}) {
+		for (int rules = 0; rules < 3; ++rules) {
+			auto did = db.add_day("Type", rollover, "1.5");
+			if (rules > 0) {
+				db.edit_day_add_rule(did, 3, "12");
+			}
+			if (rules > 1) {
+				db.edit_day_add_rule(did, 20, "25.5");
+			}
+			for (auto eid : {plain, part}) {
+				db.add_day_off(eid, did, 2014, 1, 1, "4");
+				db.add_day_off(eid, did, 2015, 12, 31, "3");
+				db.add_day_off(eid, did, 2016, 1, 1, "1/3");
+			}
+		}
+	}
+
+	using Ymd = std::tuple<uint16_t, uint16_t, uint16_t>;
+	auto day_list = db.list_day_info();
+	for (auto eid : {plain, part}) {
+		for (auto date : {Ymd{2014, 6, 1}, Ymd{2016, 1, 1}, Ymd{2018, 2, 28}}) {
+			auto all = db.query_vacation_days(eid, std::get<0>(date), std::get<1>(date),
+			                                  std::get<2>(date));
+			ASSERT_EQ(all.size(), day_list.size());
+
+			for (size_t i = 0; i < day_list.size(); ++i) {
+				auto single = db.query_vacation_days(eid, day_list[i].id, std::get<0>(date),
+				                                     std::get<1>(date), std::get<2>(date));
+				ASSERT_STREQ(all[i].days.c_str(), single.c_str());
+			}
+		}
+	}
+}
+
+TEST(CALC_ACCURACY, RulesOnTheSameMonth) {
+	Vacationdb::Database db;
+
+	// Enough year starts that the sort can't fall back to insertion sort
+	auto eid = db.add_employee("Bob", 1990, 1, 1, "1");
+	db.edit_employee_add_extra_work_time(eid, 1991, 1, 1, 1991, 7, 1, "1/2");
+
+	// Of the rules starting in the same month, the one added last applies
+	auto other = db.add_day("Sick", "0", "3");
+	db.edit_day_add_rule(other, 1, "5");
+	db.edit_day_add_rule(other, 13, "8");
+	auto did = db.add_day("Vacation", "-1", "0");
+	db.edit_day_add_rule(did, 1, "10");
+	db.edit_day_add_rule(did, 1, "20");
+	db.edit_day_add_rule(did, 13, "30");
+	db.edit_day_add_rule(did, 13, "15");
+
+	ASSERT_STREQ(db.query_vacation_days(eid, did, 1991, 1, 1).c_str(), "20");
+
+	for (uint16_t year = 1990; year < 2030; year += 3) {
+		auto all = db.query_vacation_days(eid, year, 6, 1);
+		ASSERT_EQ(all.size(), size_t{2});
+		ASSERT_STREQ(all[0].days.c_str(), db.query_vacation_days(eid, other, year, 6, 1).c_str());
+		ASSERT_STREQ(all[1].days.c_str(), db.query_vacation_days(eid, did, year, 6, 1).c_str());
+	}
+}
+
+TEST(CALC_ACCURACY, OverlappingExtraWorkTime) {
+	Vacationdb::Database db;
+
+	std::string result;
+
+	auto eid = db.add_employee("Bob", 2017, 1, 1, "1");
+	auto did = db.add_day("Vacation", "-1", "0");
+	db.edit_day_add_rule(did, 1, "20");
+
+	// The later range wins while they overlap, the earlier one resumes after it.
+	db.edit_employee_add_extra_work_time(eid, 2017, 1, 1, 2019, 1, 1, "0.5");
+	db.edit_employee_add_extra_work_time(eid, 2017, 7, 2, 2018, 1, 1, "0");
+
+	result = db.query_vacation_days(eid, did, 2019, 1, 1);
+
+	ASSERT_EQ(within(result, "15", "1/2"), true);
+}
+
+TEST(CALC_ACCURACY, WorkTimeLookup) {
+	Vacationdb::Database db;
+
+	auto eid = db.add_employee("Bob", 2017, 1, 1, "1");
+	db.edit_employee_add_extra_work_time(eid, 2017, 1, 1, 2019, 1, 1, "0.5");
+	auto e = db.edit_employee_add_extra_work_time(eid, 2017, 7, 2, 2018, 1, 1, "1/4");
+
+	ASSERT_STREQ(db.query_work_time(eid, 2016, 12, 31).c_str(), "1");
+	ASSERT_STREQ(db.query_work_time(eid, 2017, 1, 1).c_str(), "1/2");
+	ASSERT_STREQ(db.query_work_time(eid, 2017, 7, 2).c_str(), "1/4");
+	ASSERT_STREQ(db.query_work_time(eid, 2018, 1, 1).c_str(), "1/2");
+	ASSERT_STREQ(db.query_work_time(eid, 2019, 1, 1).c_str(), "1");
+
+	db.edit_employee_remove_extra_work_time(eid, e);
+	db.edit_employee_work_time(eid, "3/4");
+
+	ASSERT_STREQ(db.query_work_time(eid, 2017, 7, 2).c_str(), "1/2");
+	ASSERT_STREQ(db.query_work_time(eid, 2020, 1, 1).c_str(), "3/4");
+}
+
+TEST(CALC_ACCURACY, TypedNumbers) {
+	Vacationdb::Database db;
+
+	auto eid = db.add_employee("Bob", 2017, 1, 1, Vacationdb::Rational_t{1, 2});
+	auto did = db.add_day("Vacation", Vacationdb::Rational_t{-1, 1}, Vacationdb::Rational_t{0, 1});
+	db.edit_day_add_rule(did, 1, Vacationdb::Rational_t{20, 1});
+	db.add_day_off(eid, did, 2017, 3, 1, Vacationdb::Rational_t{3, 4});
+
+	auto value = db.query_vacation_days_value(eid, did, 2018, 1, 1);
+	ASSERT_EQ(value.numerator, int64_t{37});
+	ASSERT_EQ(value.denominator, int64_t{4});
+	ASSERT_DOUBLE_EQ(value.to_double(), 9.25);
+	ASSERT_STREQ(db.query_vacation_days(eid, did, 2018, 1, 1).c_str(), "37/4");
+
+	auto report = db.report_vacation_days_value(did, 2018, 1, 1);
+	ASSERT_EQ(report.size(), size_t{1});
+	ASSERT_EQ(report[0].days.numerator, int64_t{37});
+
+	auto work_time = db.query_work_time_value(eid, 2017, 6, 1);
+	ASSERT_EQ(work_time.numerator, int64_t{1});
+	ASSERT_EQ(work_time.denominator, int64_t{2});
+
+	bool threw = false;
+	try {
+		db.edit_employee_work_time(eid, Vacationdb::Rational_t{1, 0});
+	}
+	catch (Vacationdb::Invalid_Number&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+}
+
+TEST(CALC_ACCURACY, BatchedReport) {
+	Vacationdb::Database db;
+
+	std::vector<Vacationdb::DayID_t> days{db.add_day("None", "0", "1/2"),
+	                                      db.add_day("Capped", "5", "0"),
+	                                      db.add_day("Full", "-1", "1/3")};
+	for (auto d : days) {
+		db.edit_day_add_rule(d, 3, "25");
+	}
+	auto multi = db.add_day("Multi", "5", "0");
+	db.edit_day_add_rule(multi, 1, "10");
+	db.edit_day_add_rule(multi, 13, "20");
+	days.push_back(multi);
+
+	// Enough employees to fill several vector lanes, with a few that can't be batched
+	for (uint16_t i = 0; i < 150; ++i) {
+		auto month = static_cast<uint16_t>(i % 12 + 1);
+		auto name = "Employee " + std::to_string(i);
+		auto eid = db.add_employee(name.c_str(), static_cast<uint16_t>(2010 + i % 9), month,
+		                           static_cast<uint16_t>(i % 28 + 1), i % 3 ? "1" : "3/4");
+		for (auto d : days) {
+			db.add_day_off(eid, d, static_cast<uint16_t>(2012 + i % 5), 6, 1, "1/4");
+			db.add_day_off(eid, d, 2019, 2, static_cast<uint16_t>(i % 28 + 1), "1");
+		}
+		if (i % 7 == 0) {
+			db.edit_employee_add_extra_work_time(eid, 2014, 1, 1, 2015, 1, 1, "1/2");
+		}
+		if (i % 11 == 0) {
+			// Far too many digits for the integer columns
+			db.add_day_off(eid, days[0], 2015, 1, 5, "1.00000000000000000000000000000001");
+		}
+	}
+
+	for (auto d : days) {
+		auto report = db.report_vacation_days(d, 2019, 3, 1);
+		ASSERT_EQ(report.size(), size_t{150});
+		for (auto&& entry : report) {
+			ASSERT_EQ(entry.days, db.query_vacation_days(entry.employee, d, 2019, 3, 1));
+		}
+		report = db.report_vacation_days(d, 2011, 5, 1);
+		for (auto&& entry : report) {
+			ASSERT_EQ(entry.days, db.query_vacation_days(entry.employee, d, 2011, 5, 1));
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+
+#include <string>
+
+// A database big enough to be worth paging or loading lazily, and a check
+// that two databases answer the same way
+namespace Database_Fixture {
+	// Two day types, both with rules, and count employees with days off and
+	// extra work time over several years
+	inline void fill(Vacationdb::Database& db, uint16_t count) {
+		auto vacation = db.add_day("Vacation", "5", "1");
+		db.edit_day_add_rule(vacation, 1, "20");
+		auto sick = db.add_day("Sick", "-1", "0");
+		db.edit_day_add_rule(sick, 1, "10");
+		db.edit_day_add_rule(sick, 25, "12");
+
+		for (uint16_t i = 0; i < count; ++i) {
+			auto name = "Employee " + std::to_string(i);
+			auto eid = db.add_employee(name.c_str(), static_cast<uint16_t>(2005 + i % 10),
+			                           static_cast<uint16_t>(i % 12 + 1), 1, "1");
+			for (uint16_t year = 2012; year < 2019; ++year) {
+				db.add_day_off(eid, vacation, year, static_cast<uint16_t>(i % 12 + 1), 3, "1/2");
+				db.add_day_off(eid, sick, year, 2, static_cast<uint16_t>(i % 28 + 1), "1");
+			}
+			if (i % 4 == 0) {
+				db.edit_employee_add_extra_work_time(eid, 2014, 1, 1, 2016, 1, 1, "1/2");
+			}
+		}
+	}
+
+	// Reports read every employee, the rest is checked for every seventh
+	inline void expect_same(Vacationdb::Database& db, Vacationdb::Database& expected) {
+		for (auto d : {Vacationdb::DayID_t{0}, Vacationdb::DayID_t{1}}) {
+			auto report = db.report_vacation_days(d, 2019, 3, 1);
+			auto expected_report = expected.report_vacation_days(d, 2019, 3, 1);
+			ASSERT_EQ(report.size(), expected_report.size());
+			for (size_t i = 0; i < report.size(); ++i) {
+				ASSERT_EQ(report[i].days, expected_report[i].days);
+			}
+		}
+
+		for (size_t i = 0; i < expected.get_employee_count(); i += 7) {
+			Vacationdb::PersonID_t eid{i};
+			auto days = db.query_vacation_days(eid, 2018, 7, 1);
+			auto expected_days = expected.query_vacation_days(eid, 2018, 7, 1);
+			ASSERT_EQ(days.size(), expected_days.size());
+			for (size_t j = 0; j < days.size(); ++j) {
+				ASSERT_EQ(days[j].days, expected_days[j].days);
+			}
+			ASSERT_EQ(db.query_work_time(eid, 2015, 1, 1),
+			          expected.query_work_time(eid, 2015, 1, 1));
+			ASSERT_EQ(db.get_employee_info(eid).extra_work_time.size(),
+			          expected.get_employee_info(eid).extra_work_time.size());
+			for (auto d : {Vacationdb::DayID_t{0}, Vacationdb::DayID_t{1}}) {
+				ASSERT_EQ(db.list_days_off(eid, d).size(), expected.list_days_off(eid, d).size());
+			}
+		}
+	}
+}
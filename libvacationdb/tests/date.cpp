@@ -0,0 +1,66 @@
+#include "boost/date_time/gregorian/gregorian.hpp"
+#include "date.hpp"
+#include "database_impl.hpp"
+#include "gtest/gtest.h"
+
+using Vacationdb::_detail::Date;
+
+TEST(UTILS_DATE, MatchesBoost) {
+	boost::gregorian::date reference(1400, 1, 1);
+	Date date(1400, 1, 1);
+
+	const boost::gregorian::date last(9999, 12, 28);
+	while (reference <= last) {
+		ASSERT_EQ(date.year(), reference.year());
+		ASSERT_EQ(date.month(), reference.month());
+		ASSERT_EQ(date.day(), reference.day());
+		ASSERT_EQ(Date(reference.year(), reference.month(), reference.day()).days(), date.days());
+
+		reference += boost::gregorian::days(3);
+		date = date + 3;
+	}
+}
+
+TEST(UTILS_DATE, Differences) {
+	ASSERT_EQ(Date(2017, 1, 1) - Date(2016, 1, 1), 366);
+	ASSERT_EQ(Date(2018, 1, 1) - Date(2017, 1, 1), 365);
+	ASSERT_EQ(Date(1400, 1, 1) - Date(9999, 12, 31),
+	          (boost::gregorian::date(1400, 1, 1) - boost::gregorian::date(9999, 12, 31)).days());
+}
+
+TEST(UTILS_DATE, AddMonthsMatchesBoost) {
+	const int32_t offsets[] = {-13, -1, 0, 1, 2, 6, 11, 12, 13, 25, 119};
+
+	boost::gregorian::date reference(1999, 1, 1);
+	while (reference.year() < 2002) {
+		Date date(reference.year(), reference.month(), reference.day());
+
+		for (auto&& offset : offsets) {
+			auto expected = reference + boost::gregorian::months(offset);
+			auto actual = Vacationdb::_detail::add_months(date, offset);
+
+			ASSERT_EQ(actual.year(), expected.year());
+			ASSERT_EQ(actual.month(), expected.month());
+			ASSERT_EQ(actual.day(), expected.day());
+		}
+
+		reference += boost::gregorian::days(1);
+	}
+}
+
+TEST(UTILS_DATE, Validation) {
+	ASSERT_EQ(Vacationdb::_detail::is_valid_date(2016, 2, 29), true);
+	ASSERT_EQ(Vacationdb::_detail::is_valid_date(2017, 2, 29), false);
+	ASSERT_EQ(Vacationdb::_detail::is_valid_date(2017, 13, 1), false);
+	ASSERT_EQ(Vacationdb::_detail::is_valid_date(2017, 4, 31), false);
+	ASSERT_EQ(Vacationdb::_detail::is_valid_date(1399, 12, 31), false);
+
+	bool threw = false;
+	try {
+		Vacationdb::_detail::create_date_safe(2017, 0, 1);
+	}
+	catch (Vacationdb::Invalid_Date&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+}
@@ -0,0 +1,177 @@
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+
+TEST(DB_DAYS_OFF, ListSorted) {
+	Vacationdb::Database db;
+
+	auto e = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto vacation = db.add_day("Vacation", "0", "0");
+	auto sick = db.add_day("Sick", "0", "0");
+
+	db.add_day_off(e, vacation, 2017, 3, 1, "1");
+	db.add_day_off(e, sick, 2016, 5, 1, "2");
+	db.add_day_off(e, vacation, 2016, 2, 1, "3");
+	db.add_day_off(e, vacation, 2016, 12, 31, "4");
+
+	auto list = db.list_days_off(e, vacation);
+	ASSERT_EQ(list.size(), size_t{3});
+	ASSERT_EQ(list[0].year, 2016);
+	ASSERT_EQ(list[0].month, 2);
+	ASSERT_STREQ(list[0].amount.c_str(), "3");
+	ASSERT_EQ(list[1].year, 2016);
+	ASSERT_EQ(list[1].month, 12);
+	ASSERT_STREQ(list[1].amount.c_str(), "4");
+	ASSERT_EQ(list[2].year, 2017);
+	ASSERT_STREQ(list[2].amount.c_str(), "1");
+
+	list = db.list_days_off(e, sick);
+	ASSERT_EQ(list.size(), size_t{1});
+	ASSERT_STREQ(list[0].amount.c_str(), "2");
+}
+
+TEST(DB_DAYS_OFF, Remove) {
+	Vacationdb::Database db;
+
+	auto e = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto d = db.add_day("Vacation", "0", "0");
+
+	db.add_day_off(e, d, 2016, 2, 1, "1");
+	db.add_day_off(e, d, 2016, 2, 2, "2");
+	db.add_day_off(e, d, 2016, 2, 1, "3");
+
+	// Only the first day off on that date goes
+	db.remove_day_off(e, d, 2016, 2, 1);
+	auto list = db.list_days_off(e, d);
+	ASSERT_EQ(list.size(), size_t{2});
+	ASSERT_STREQ(list[0].amount.c_str(), "3");
+	ASSERT_STREQ(list[1].amount.c_str(), "2");
+
+	// Nothing on that date
+	db.remove_day_off(e, d, 2016, 2, 3);
+	ASSERT_EQ(db.list_days_off(e, d).size(), size_t{2});
+}
+
+TEST(DB_DAYS_OFF, Range) {
+	Vacationdb::Database db;
+
+	auto e = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto d = db.add_day("Vacation", "0", "0");
+	auto other = db.add_day("Sick", "0", "0");
+
+	for (uint16_t month = 1; month <= 12; ++month) {
+		db.add_day_off(e, d, 2016, month, 15, "1");
+		db.add_day_off(e, other, 2016, month, 15, "1");
+	}
+
+	auto list = db.list_days_off(e, d, 2016, 3, 15, 2016, 6, 14);
+	ASSERT_EQ(list.size(), size_t{3});
+	ASSERT_EQ(list[0].month, 3);
+	ASSERT_EQ(list[2].month, 5);
+
+	ASSERT_EQ(db.list_days_off(e, d, 2010, 1, 1, 2020, 1, 1).size(), size_t{12});
+	ASSERT_EQ(db.list_days_off(e, d, 2016, 6, 15, 2016, 6, 15).size(), size_t{1});
+	ASSERT_EQ(db.list_days_off(e, d, 2016, 7, 1, 2016, 6, 1).size(), size_t{0});
+}
+
+TEST(DB_DAYS_OFF, DayTypeLifetime) {
+	Vacationdb::Database db;
+
+	auto e = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto first = db.add_day("Vacation", "0", "0");
+	db.add_day_off(e, first, 2016, 1, 1, "1");
+
+	// Day types added after the employee work straight away
+	auto second = db.add_day("Sick", "0", "0");
+	db.add_day_off(e, second, 2016, 1, 1, "2");
+	ASSERT_EQ(db.list_days_off(e, second).size(), size_t{1});
+
+	db.delete_day(first);
+	ASSERT_EQ(db.list_days_off(e, second).size(), size_t{1});
+
+	bool threw = false;
+	try {
+		db.list_days_off(e, first);
+	}
+	catch (Vacationdb::Invalid_Index&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+}
+
+TEST(DB_DAYS_OFF, DaysUsed) {
+	Vacationdb::Database db;
+
+	auto e = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto d = db.add_day("Vacation", "0", "0");
+	auto other = db.add_day("Sick", "0", "0");
+
+	db.add_day_off(e, other, 2016, 3, 1, "10");
+	db.add_day_off(e, d, 2016, 3, 1, "1");
+	db.add_day_off(e, d, 2016, 1, 1, "1/2");
+	db.add_day_off(e, d, 2016, 6, 1, "2");
+	db.add_day_off(e, d, 2017, 1, 1, "4");
+
+	ASSERT_STREQ(db.query_days_used(e, d, 2016, 1, 1, 2016, 12, 31).c_str(), "7/2");
+	ASSERT_STREQ(db.query_days_used(e, d, 2016, 3, 1, 2017, 1, 1).c_str(), "7");
+	ASSERT_STREQ(db.query_days_used(e, d, 2016, 3, 2, 2016, 5, 31).c_str(), "0");
+	ASSERT_STREQ(db.query_days_used(e, other, 2000, 1, 1, 2020, 1, 1).c_str(), "10");
+
+	// Totals follow removals
+	db.remove_day_off(e, d, 2016, 1, 1);
+	auto used = db.query_days_used_value(e, d, 2016, 1, 1, 2017, 12, 31);
+	ASSERT_EQ(used.numerator, 7);
+	ASSERT_EQ(used.denominator, 1);
+	ASSERT_STREQ(db.query_days_used(e, other, 2016, 3, 1, 2016, 3, 1).c_str(), "10");
+}
+
+TEST(DB_DAYS_OFF, Bulk) {
+	Vacationdb::Database single;
+	Vacationdb::Database bulk;
+
+	for (auto db : {&single, &bulk}) {
+		db->add_employee("Bob", 2015, 1, 1, "1");
+		db->add_day("Vacation", "5", "0");
+		db->add_day("Sick", "0", "0");
+		db->edit_day_add_rule(Vacationdb::DayID_t{0}, 1, "20");
+		db->add_day_off(Vacationdb::PersonID_t{0}, Vacationdb::DayID_t{0}, 2016, 3, 1, "1");
+		db->add_day_off(Vacationdb::PersonID_t{0}, Vacationdb::DayID_t{1}, 2016, 3, 1, "7");
+	}
+	Vacationdb::PersonID_t e{0};
+	Vacationdb::DayID_t d{0};
+
+	std::vector<Vacationdb::Date_t> days{{2017, 1, 1, "2"},
+	                                     {2016, 3, 1, "1/2"},
+	                                     {2015, 6, 30, "3"},
+	                                     {2016, 12, 31, "0.25"}};
+	for (auto&& day : days) {
+		single.add_day_off(e, d, day.year, day.month, day.day, day.amount.c_str());
+	}
+	bulk.add_days_off(e, d, days);
+
+	auto expected = single.list_days_off(e, d);
+	auto actual = bulk.list_days_off(e, d);
+	ASSERT_EQ(actual.size(), expected.size());
+	for (size_t i = 0; i < actual.size(); ++i) {
+		ASSERT_EQ(actual[i].year, expected[i].year);
+		ASSERT_EQ(actual[i].month, expected[i].month);
+		ASSERT_EQ(actual[i].day, expected[i].day);
+		ASSERT_STREQ(actual[i].amount.c_str(), expected[i].amount.c_str());
+	}
+	ASSERT_STREQ(bulk.query_days_used(e, d, 2015, 1, 1, 2016, 12, 31).c_str(),
+	             single.query_days_used(e, d, 2015, 1, 1, 2016, 12, 31).c_str());
+	ASSERT_STREQ(bulk.query_vacation_days(e, d, 2017, 6, 1).c_str(),
+	             single.query_vacation_days(e, d, 2017, 6, 1).c_str());
+	ASSERT_STREQ(bulk.query_days_used(e, Vacationdb::DayID_t{1}, 2016, 1, 1, 2016, 12, 31).c_str(),
+	             "7");
+
+	// One bad entry keeps the whole batch out
+	bool threw = false;
+	try {
+		bulk.add_days_off(e, d, {{2018, 1, 1, "1"}, {2018, 2, 30, "1"}});
+	}
+	catch (Vacationdb::Invalid_Date&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+	ASSERT_EQ(bulk.list_days_off(e, d).size(), expected.size());
+}
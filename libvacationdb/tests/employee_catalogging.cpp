@@ -89,6 +89,33 @@ TEST(DB_EMPLOYEE_CATALOG, EditAddExtraWorkTimeAccuracy) {
 	ASSERT_STREQ(info.extra_work_time[0].time.c_str(), "2");
 }
 
+TEST(DB_EMPLOYEE_CATALOG, EditAddExtraWorkTimeBackwards) {
+	Vacationdb::Database db;
+
+	auto e = db.add_employee("", 1400, 1, 1, "1");
+
+	bool threw = false;
+	try {
+		db.edit_employee_add_extra_work_time(e, 2001, 2, 2, 2000, 1, 1, "2");
+	}
+	catch (Vacationdb::Invalid_Date&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+
+	threw = false;
+	try {
+		db.edit_employee_add_extra_work_time(e, 2000, 1, 1, 2000, 1, 1, "2");
+	}
+	catch (Vacationdb::Invalid_Date&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+
+	auto info = db.get_employee_info(e);
+	ASSERT_EQ(info.extra_work_time.size(), size_t{0});
+}
+
 TEST(DB_EMPLOYEE_CATALOG, Find) {
 	Vacationdb::Database db;
 	const char* name = "George Costanza";
@@ -263,3 +290,69 @@ TEST(DB_EMPLOYEE_CATALOG, ThrowOnInvalidNumber) {
 
 	ASSERT_EQ(threw, true);
 }
+
+TEST(DB_EMPLOYEE_CATALOG, NameViews) {
+	Vacationdb::Database db;
+
+	auto bob = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto bob2 = db.add_employee("Bob", 2016, 1, 1, "1");
+	auto d = db.add_day("Bob", "0", "0");
+
+	// Equal names share their storage
+	auto view = db.get_employee_name_view(bob);
+	ASSERT_EQ(view, "Bob");
+	ASSERT_EQ(view.data(), db.get_employee_name_view(bob2).data());
+	ASSERT_EQ(view.data(), db.get_day_name_view(d).data());
+
+	// Renaming leaves earlier views intact
+	db.edit_employee_name(bob, "Robert");
+	ASSERT_EQ(view, "Bob");
+	ASSERT_EQ(db.get_employee_name_view(bob), "Robert");
+	ASSERT_EQ(db.find_employee("Robert"), bob);
+	ASSERT_EQ(db.find_employee("Bob"), bob2);
+
+	bool threw = false;
+	try {
+		db.find_employee("Alice");
+	}
+	catch (Vacationdb::Employee_Not_Found&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+}
+
+TEST(DB_EMPLOYEE_CATALOG, ListIds) {
+	Vacationdb::Database db;
+
+	auto carol = db.add_employee("Carol", 2015, 1, 1, "1");
+	auto alice = db.add_employee("Alice", 2015, 1, 1, "1");
+	auto bob = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto alina = db.add_employee("Alina", 2015, 1, 1, "1");
+
+	auto ids = db.list_employee_ids();
+	ASSERT_EQ(ids.size(), size_t{4});
+	ASSERT_EQ(ids[0], carol);
+	ASSERT_EQ(ids[3], alina);
+
+	auto by_name = db.list_employee_ids_by_name();
+	ASSERT_EQ(by_name.size(), size_t{4});
+	ASSERT_EQ(by_name[0], alice);
+	ASSERT_EQ(by_name[1], alina);
+	ASSERT_EQ(by_name[2], bob);
+	ASSERT_EQ(by_name[3], carol);
+
+	auto found = db.find_employees_containing("li");
+	ASSERT_EQ(found.size(), size_t{2});
+	ASSERT_EQ(found[0], alice);
+	ASSERT_EQ(found[1], alina);
+
+	// The index follows renames and deletes
+	db.edit_employee_name(carol, "Aaron");
+	db.delete_employee(alina);
+	by_name = db.list_employee_ids_by_name();
+	ASSERT_EQ(by_name.size(), size_t{3});
+	ASSERT_EQ(by_name[0], carol);
+	ASSERT_EQ(by_name[1], alice);
+	ASSERT_EQ(db.find_employees_containing("li").size(), size_t{1});
+	ASSERT_EQ(db.find_employees_containing("").size(), size_t{3});
+}
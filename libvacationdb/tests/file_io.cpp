@@ -0,0 +1,176 @@
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+TEST(DB_FILE_IO, RoundTrip) {
+	const char* file = "vdb_test_round_trip.json";
+
+	Vacationdb::Database db;
+
+	auto bob = db.add_employee("Bob \"the builder\"", 2015, 3, 14, "1");
+	auto gone = db.add_employee("Gone", 2016, 1, 1, "1");
+	auto alice = db.add_employee("Al\xC3\xAF" "ce\n", 2014, 8, 12, "4/5");
+	db.delete_employee(gone);
+	db.edit_employee_add_extra_work_time(alice, 2015, 2, 1, 2016, 9, 1, "0.5");
+	auto removed = db.edit_employee_add_extra_work_time(alice, 2015, 3, 1, 2015, 4, 1, "0");
+	db.edit_employee_remove_extra_work_time(alice, removed);
+
+	auto vacation = db.add_day("Vacation", "-1", "0");
+	db.edit_day_add_rule(vacation, 1, "24");
+	auto rule = db.edit_day_add_rule(vacation, 13, "30");
+	auto deleted = db.add_day("Deleted", "0", "3");
+	db.delete_day(deleted);
+	auto sick = db.add_day("Sick", "5", "2/3");
+	db.edit_day_add_rule(sick, 1, "9.96");
+
+	db.add_day_off(bob, vacation, 2015, 7, 2, "1");
+	db.add_day_off(bob, vacation, 2017, 1, 1, "2.5");
+	db.add_day_off(alice, sick, 2016, 4, 21, "1/2");
+	db.add_day_off(alice, vacation, 2016, 4, 21, "3");
+
+	db.save(file);
+
+	Vacationdb::Database loaded;
+	loaded.load(file);
+	std::remove(file);
+
+	ASSERT_STREQ(loaded.get_current_filename().c_str(), file);
+	ASSERT_EQ(loaded.get_employee_count(), db.get_employee_count());
+	ASSERT_EQ(loaded.get_day_count(), db.get_day_count());
+
+	// Ids stay the same, deleted records stay deleted
+	ASSERT_STREQ(loaded.get_employee_name(bob).c_str(), "Bob \"the builder\"");
+	ASSERT_STREQ(loaded.get_employee_name(alice).c_str(), "Al\xC3\xAF" "ce\n");
+	ASSERT_EQ(loaded.find_day("Sick"), sick);
+	ASSERT_STREQ(loaded.get_day_info(vacation).rules[size_t{rule}].days_per_year.c_str(), "30");
+
+	bool threw = false;
+	try {
+		loaded.get_employee_name(gone);
+	}
+	catch (Vacationdb::Invalid_Index&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+
+	for (auto eid : {bob, alice}) {
+		auto before = db.query_vacation_days(eid, 2018, 2, 28);
+		auto after = loaded.query_vacation_days(eid, 2018, 2, 28);
+		ASSERT_EQ(before.size(), after.size());
+		for (size_t i = 0; i < before.size(); ++i) {
+			ASSERT_STREQ(before[i].day_name.c_str(), after[i].day_name.c_str());
+			ASSERT_STREQ(before[i].days.c_str(), after[i].days.c_str());
+		}
+		ASSERT_STREQ(db.query_work_time(eid, 2015, 3, 15).c_str(),
+		             loaded.query_work_time(eid, 2015, 3, 15).c_str());
+	}
+
+	auto days_off = loaded.list_days_off(alice, vacation);
+	ASSERT_EQ(days_off.size(), size_t{1});
+	ASSERT_STREQ(days_off[0].amount.c_str(), "3");
+
+	// Nothing is running once the load is done
+	auto status = loaded.get_load_status();
+	ASSERT_EQ(status.operation, Vacationdb::IO_Status_t::NOOP);
+	ASSERT_EQ(status.percentage, 100.0f);
+}
+
+TEST(DB_FILE_IO, InvalidFile) {
+	const char* file = "vdb_test_invalid.json";
+
+	Vacationdb::Database db;
+	db.add_employee("Bob", 2015, 3, 14, "1");
+
+	bool threw = false;
+	try {
+		db.load("vdb_test_does_not_exist.json");
+	}
+	catch (Vacationdb::Invalid_File&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+
+	const char* broken[] = {
+	    "",
+	    "{\"version\":1,\"day_types\":[],\"employees\":[{\"name\":\"Bob\"",
+	    "{\"version\":2,\"day_types\":[],\"employees\":[]}",
+	    "{\"version\":1,\"day_types\":[],\"employees\":[{\"start_date\":\"2015-02-30\"}]}",
+	    "{\"version\":1,\"day_types\":[],\"employees\":[{\"work_time\":\"one\"}]}",
+	    "{\"version\":1,\"day_types\":[],\"employees\":[{\"days_off\":[{\"type\":0}]}]}",
+	    "{\"version\":1,\"day_types\":[],\"employees\":[{\"valid\":\"yes\"}]}",
+	    "{\"version\":1,\"day_types\":[3],\"employees\":[]}",
+	    "{\"version\":1,\"day_types\":[],\"employees\":[]} {}",
+	};
+
+	for (auto contents : broken) {
+		{
+			std::ofstream out(file, std::ios::binary | std::ios::trunc);
+			out << contents;
+		}
+
+		threw = false;
+		try {
+			db.load(file);
+		}
+		catch (Vacationdb::Invalid_File&) {
+			threw = true;
+		}
+		ASSERT_EQ(threw, true);
+
+		// A failed load leaves the database alone, down to the file a save goes to
+		ASSERT_EQ(db.get_employee_count(), size_t{1});
+		ASSERT_STREQ(db.get_current_filename().c_str(), "vdb.json");
+		ASSERT_EQ(db.get_load_status().operation, Vacationdb::IO_Status_t::NOOP);
+	}
+	std::remove(file);
+}
+
+TEST(DB_FILE_IO, FailedSave) {
+	const char* file = "vdb_test_failed_save.json";
+	std::string temp_name = std::string(file) + ".tmp";
+
+	Vacationdb::Database db;
+	db.add_employee("Bob", 2015, 3, 14, "1");
+	db.save(file);
+	ASSERT_FALSE(std::ifstream(temp_name).good());
+
+	// Nowhere to write the new contents, the old ones stay as they were
+	std::filesystem::create_directory(temp_name);
+	db.add_employee("Alice", 2015, 3, 14, "1");
+	bool threw = false;
+	try {
+		db.save(file);
+	}
+	catch (Vacationdb::Invalid_File&) {
+		threw = true;
+	}
+	std::filesystem::remove(temp_name);
+	ASSERT_EQ(threw, true);
+
+	Vacationdb::Database loaded;
+	loaded.load(file);
+	std::remove(file);
+	ASSERT_EQ(loaded.get_employee_count(), size_t{1});
+}
+
+TEST(DB_FILE_IO, UnknownKeys) {
+	const char* file = "vdb_test_unknown_keys.json";
+	{
+		std::ofstream out(file, std::ios::binary | std::ios::trunc);
+		out << "{\"version\":1,\"comment\":{\"a\":[1,-2.5e3,true,null,\"\\u00e9\"]},\n"
+		       "\"day_types\":[{\"name\":\"Vacation\",\"rollover\":\"0\",\"yearly_bonus\":\"5\","
+		       "\"valid\":true,\"rules\":[],\"color\":\"red\"}],\n"
+		       "\"employees\":[{\"name\":\"Bob\",\"start_date\":\"2015-03-14\","
+		       "\"work_time\":\"1\",\"valid\":true,\"extra_time\":[],\"days_off\":[]}]}";
+	}
+
+	Vacationdb::Database db;
+	db.load(file);
+	std::remove(file);
+
+	ASSERT_EQ(db.get_employee_count(), size_t{1});
+	ASSERT_STREQ(db.get_day_info(db.find_day("Vacation")).yearly_bonus.c_str(), "5");
+}
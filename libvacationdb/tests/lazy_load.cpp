@@ -0,0 +1,177 @@
+#include "database_fixture.hpp"
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(DB_LAZY_LOAD, OnDemand) {
+	const char* file = "vdb_lazy_load_test.json";
+
+	Vacationdb::Database expected;
+	Database_Fixture::fill(expected, 150);
+	expected.save(file);
+
+	Vacationdb::Database db;
+	db.set_lazy_load(Vacationdb::Lazy_Load_Config_t{true, false});
+	db.load(file);
+	std::remove(file);
+
+	// Only names and day types are read up front
+	auto stats = db.get_lazy_load_stats();
+	ASSERT_TRUE(stats.enabled);
+	ASSERT_EQ(stats.pending_employees, size_t{150});
+	ASSERT_EQ(db.get_employee_count(), size_t{150});
+	ASSERT_EQ(db.get_employee_name(db.find_employee("Employee 42")), "Employee 42");
+	ASSERT_EQ(db.list_day_names().size(), size_t{2});
+	ASSERT_EQ(db.get_lazy_load_stats().pending_employees, size_t{150});
+
+	// Each query reads in only who it touches
+	Vacationdb::PersonID_t eid{8};
+	ASSERT_EQ(db.query_vacation_days(eid, Vacationdb::DayID_t{0}, 2017, 6, 1),
+	          expected.query_vacation_days(eid, Vacationdb::DayID_t{0}, 2017, 6, 1));
+	ASSERT_EQ(db.get_lazy_load_stats().pending_employees, size_t{149});
+
+	// Edits read the employee in before changing them
+	for (auto* d : {&db, &expected}) {
+		Vacationdb::PersonID_t edited{20};
+		d->add_day_off(edited, Vacationdb::DayID_t{0}, 2018, 12, 24, "2");
+		d->edit_employee_add_extra_work_time(edited, 2017, 1, 1, 2017, 7, 1, "3/4");
+	}
+	ASSERT_EQ(db.get_lazy_load_stats().pending_employees, size_t{148});
+
+	Database_Fixture::expect_same(db, expected);
+	ASSERT_EQ(db.get_lazy_load_stats().pending_employees, size_t{0});
+
+	// Saving reads in everyone nothing has touched yet
+	expected.save(file);
+	db.load(file);
+	db.save(file);
+	ASSERT_EQ(db.get_lazy_load_stats().pending_employees, size_t{0});
+	Vacationdb::Database reloaded;
+	reloaded.load(file);
+	std::remove(file);
+	Database_Fixture::expect_same(reloaded, expected);
+}
+
+TEST(DB_LAZY_LOAD, Warm) {
+	const char* file = "vdb_lazy_load_warm_test.json";
+
+	Vacationdb::Database expected;
+	Database_Fixture::fill(expected, 150);
+	expected.save(file);
+
+	Vacationdb::Database db(4);
+	db.set_lazy_load(Vacationdb::Lazy_Load_Config_t{true, true});
+	db.load(file);
+
+	for (int i = 0; i < 1000 && db.get_lazy_load_stats().pending_employees != 0; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	ASSERT_EQ(db.get_lazy_load_stats().pending_employees, size_t{0});
+	Database_Fixture::expect_same(db, expected);
+
+	// An edit stops warming, whoever is left is read in on demand
+	db.load(file);
+	db.add_employee("Bob", 2016, 1, 1, "1");
+	expected.add_employee("Bob", 2016, 1, 1, "1");
+	Database_Fixture::expect_same(db, expected);
+
+	// Out of core mode reads everyone in out of the loaded file first
+	expected.save(file);
+	db.set_lazy_load(Vacationdb::Lazy_Load_Config_t{true, false});
+	db.load(file);
+	std::remove(file);
+	ASSERT_GT(db.get_lazy_load_stats().pending_employees, size_t{0});
+	db.enable_out_of_core(Vacationdb::Out_Of_Core_Config_t{"vdb_lazy_load_test.pages", 4096});
+	ASSERT_EQ(db.get_lazy_load_stats().pending_employees, size_t{0});
+	Database_Fixture::expect_same(db, expected);
+	db.disable_out_of_core();
+}
+
+TEST(DB_LAZY_LOAD, Concurrent) {
+	const char* file = "vdb_lazy_load_concurrent_test.json";
+
+	Vacationdb::Database expected;
+	Database_Fixture::fill(expected, 150);
+	expected.save(file);
+
+	Vacationdb::Database db(4);
+	db.set_lazy_load(Vacationdb::Lazy_Load_Config_t{true, false});
+	db.load(file);
+	std::remove(file);
+
+	// The workers read everyone in at the same time, several of them wanting the
+	// same employees
+	std::vector<std::future<std::vector<Vacationdb::Employee_Days_t>>> reports;
+	for (size_t i = 0; i < 4; ++i) {
+		reports.push_back(db.report_vacation_days_async(Vacationdb::DayID_t{i % 2}, 2019, 3, 1));
+	}
+	std::vector<std::future<std::string>> queries;
+	for (size_t i = 0; i < 150; ++i) {
+		queries.push_back(db.query_vacation_days_async(Vacationdb::PersonID_t{149 - i},
+		                                               Vacationdb::DayID_t{0}, 2018, 7, 1));
+	}
+
+	for (size_t i = 0; i < 4; ++i) {
+		Vacationdb::DayID_t d{i % 2};
+		auto report = reports[i].get();
+		auto expected_report = expected.report_vacation_days(d, 2019, 3, 1);
+		ASSERT_EQ(report.size(), expected_report.size());
+		for (size_t j = 0; j < report.size(); ++j) {
+			ASSERT_EQ(report[j].days, expected_report[j].days);
+		}
+	}
+	for (size_t i = 0; i < 150; ++i) {
+		ASSERT_EQ(queries[i].get(),
+		          expected.query_vacation_days(Vacationdb::PersonID_t{149 - i},
+		                                       Vacationdb::DayID_t{0}, 2018, 7, 1));
+	}
+	ASSERT_EQ(db.get_lazy_load_stats().pending_employees, size_t{0});
+	Database_Fixture::expect_same(db, expected);
+}
+
+TEST(DB_LAZY_LOAD, BadHistory) {
+	const char* file = "vdb_lazy_load_bad_test.json";
+	{
+		std::ofstream out(file, std::ios::binary | std::ios::trunc);
+		out << "{\"version\":1,\n"
+		       "\"day_types\":[{\"name\":\"Vacation\",\"rollover\":\"0\",\"yearly_bonus\":\"5\","
+		       "\"valid\":true,\"rules\":[]}],\n"
+		       "\"employees\":[{\"name\":\"Bob\",\"start_date\":\"2015-03-14\","
+		       "\"work_time\":\"1\",\"valid\":true,\"extra_time\":[],\"days_off\":["
+		       "{\"type\":3,\"date\":\"2016-01-02\",\"amount\":\"1\"}]},\n"
+		       "{\"name\":\"Alice\",\"start_date\":\"2015-03-14\","
+		       "\"work_time\":\"1\",\"valid\":true,\"extra_time\":[],\"days_off\":["
+		       "{\"type\":0,\"date\":\"2016-01-02\",\"amount\":\"1\"}]}]}";
+	}
+
+	// A lazy load only finds out about a bad employee once they are needed
+	Vacationdb::Database db;
+	db.set_lazy_load(Vacationdb::Lazy_Load_Config_t{true, false});
+	db.load(file);
+	std::remove(file);
+	ASSERT_EQ(db.get_employee_count(), size_t{2});
+
+	for (int attempt = 0; attempt < 2; ++attempt) {
+		bool threw = false;
+		try {
+			db.query_vacation_days(db.find_employee("Bob"), db.find_day("Vacation"), 2017, 1, 1);
+		}
+		catch (Vacationdb::Invalid_File&) {
+			threw = true;
+		}
+		ASSERT_TRUE(threw);
+	}
+
+	// Nothing rolls over, 2017 starts with a new yearly bonus
+	ASSERT_EQ(db.query_vacation_days(db.find_employee("Alice"), db.find_day("Vacation"), 2017, 1,
+	                                 1),
+	          "5");
+	ASSERT_EQ(db.get_lazy_load_stats().pending_employees, size_t{1});
+}
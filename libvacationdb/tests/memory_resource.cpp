@@ -0,0 +1,81 @@
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <memory_resource>
+
+namespace {
+	// Counts what passes through to the global heap
+	class Counting_Resource : public std::pmr::memory_resource {
+	  public:
+		size_t allocations = 0;
+		size_t outstanding = 0;
+
+	  private:
+		void* do_allocate(size_t bytes, size_t alignment) override {
+			++allocations;
+			outstanding += bytes;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+			outstanding -= bytes;
+			std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+	};
+
+	void fill(Vacationdb::Database& db) {
+		auto e = db.add_employee("An employee with a name longer than a short string", 2015, 1,
+		                         1, "1");
+		db.edit_employee_add_extra_work_time(e, 2015, 6, 1, 2016, 1, 1, "1/2");
+		auto d = db.add_day("A day type with a name longer than a short string", "0", "0");
+		db.edit_day_add_rule(d, 1, "25");
+		db.add_day_off(e, d, 2016, 2, 1, "1");
+		db.add_day_off(e, d, 2016, 3, 1, "1");
+	}
+}
+
+TEST(DB_MEMORY_RESOURCE, RecordsUseResource) {
+	Counting_Resource resource;
+	{
+		Vacationdb::Database db{&resource};
+		fill(db);
+
+		ASSERT_GT(resource.allocations, size_t{0});
+		ASSERT_GT(resource.outstanding, size_t{0});
+
+		Vacationdb::Database reference;
+		fill(reference);
+
+		auto e = Vacationdb::PersonID_t{size_t{0}};
+		auto d = Vacationdb::DayID_t{size_t{0}};
+		ASSERT_EQ(db.query_vacation_days(e, d, 2016, 12, 31),
+		          reference.query_vacation_days(e, d, 2016, 12, 31));
+		ASSERT_EQ(db.get_employee_info(e).name, reference.get_employee_info(e).name);
+	}
+	// Everything is given back when the database goes away
+	ASSERT_EQ(resource.outstanding, size_t{0});
+}
+
+TEST(DB_MEMORY_RESOURCE, LoadIntoArena) {
+	const char* file = "vdb_test_memory_resource.json";
+
+	Vacationdb::Database db;
+	fill(db);
+	db.save(file);
+
+	std::pmr::monotonic_buffer_resource arena;
+	Vacationdb::Database loaded{1, &arena};
+	loaded.load(file);
+
+	auto e = Vacationdb::PersonID_t{size_t{0}};
+	auto d = Vacationdb::DayID_t{size_t{0}};
+	ASSERT_EQ(loaded.get_employee_name(e), db.get_employee_name(e));
+	ASSERT_EQ(loaded.get_day_name(d), db.get_day_name(d));
+	ASSERT_EQ(loaded.query_vacation_days(e, d, 2017, 1, 1),
+	          db.query_vacation_days(e, d, 2017, 1, 1));
+	ASSERT_EQ(loaded.list_days_off(e, d).size(), size_t{2});
+
+	std::remove(file);
+}
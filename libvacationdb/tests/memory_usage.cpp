@@ -0,0 +1,85 @@
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+#include <cstdio>
+
+namespace {
+	size_t category_sum(const Vacationdb::Memory_Usage_t& usage) {
+		return usage.employees + usage.names + usage.extra_time + usage.days_off +
+		       usage.day_types + usage.rules + usage.rational_heap + usage.tombstoned +
+		       usage.unused_names + usage.caches;
+	}
+}
+
+TEST(DB_MEMORY_USAGE, Empty) {
+	Vacationdb::Database db;
+
+	auto usage = db.memory_usage();
+	ASSERT_EQ(usage.total, size_t{0});
+}
+
+TEST(DB_MEMORY_USAGE, Categories) {
+	Vacationdb::Database db;
+
+	auto bob = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto alice = db.add_employee("Alice, whose name is too long to be stored inline", 2015, 1, 1,
+	                             "1");
+	db.edit_employee_add_extra_work_time(alice, 2015, 6, 1, 2016, 1, 1, "1/2");
+	auto d = db.add_day("Vacation", "0", "0");
+	db.edit_day_add_rule(d, 1, "25");
+	db.add_day_off(bob, d, 2016, 2, 1, "1");
+	// Far too many digits for a 128 bit number
+	db.add_day_off(bob, d, 2016, 2, 2, "1.000000000000000000000000000000000000000000000001");
+
+	auto usage = db.memory_usage();
+	ASSERT_GT(usage.employees, size_t{0});
+	ASSERT_GT(usage.names, size_t{0});
+	ASSERT_GT(usage.extra_time, size_t{0});
+	ASSERT_GT(usage.days_off, size_t{0});
+	ASSERT_GT(usage.day_types, size_t{0});
+	ASSERT_GT(usage.rules, size_t{0});
+	ASSERT_GT(usage.rational_heap, size_t{0});
+	ASSERT_GT(usage.caches, size_t{0});
+	ASSERT_EQ(usage.tombstoned, size_t{0});
+	ASSERT_EQ(usage.total, category_sum(usage));
+
+	db.delete_employee(alice);
+
+	auto after = db.memory_usage();
+	ASSERT_GT(after.tombstoned, size_t{0});
+	ASSERT_EQ(after.names, usage.names);
+	ASSERT_EQ(after.extra_time, size_t{0});
+	ASSERT_EQ(after.total, usage.total);
+	ASSERT_EQ(after.total, category_sum(after));
+
+	// The name index counts once something builds it
+	db.list_employee_ids_by_name();
+	ASSERT_GT(db.memory_usage().caches, after.caches);
+}
+
+TEST(DB_MEMORY_USAGE, UnusedNames) {
+	const char* file = "vdb_memory_usage_names.json";
+	Vacationdb::Database db;
+
+	auto bob = db.add_employee("Bob, whose name is too long to be stored inline", 2015, 1, 1,
+	                           "1");
+	auto d = db.add_day("Vacation", "0", "0");
+	auto usage = db.memory_usage();
+	ASSERT_EQ(usage.unused_names, size_t{0});
+
+	// The old names stay in the table, but nothing uses them
+	db.edit_employee_name(bob, "Robert");
+	db.edit_day_name(d, "Holiday");
+	auto renamed = db.memory_usage();
+	ASSERT_GT(renamed.unused_names, size_t{0});
+	ASSERT_GT(renamed.total, usage.total);
+	ASSERT_EQ(renamed.total, category_sum(renamed));
+
+	// A load only keeps the names that were saved
+	db.save(file);
+	db.load(file);
+	std::remove(file);
+	auto loaded = db.memory_usage();
+	ASSERT_EQ(loaded.unused_names, size_t{0});
+	ASSERT_LT(loaded.names, renamed.names + renamed.unused_names);
+	ASSERT_EQ(loaded.total, category_sum(loaded));
+}
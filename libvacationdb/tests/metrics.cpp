@@ -0,0 +1,115 @@
+#include "metrics.hpp"
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+namespace {
+	const Vacationdb::Operation_Stats_t* find_operation(const Vacationdb::Database_Stats_t& stats,
+	                                                   const char* name) {
+		auto it = std::find_if(
+		    stats.operations.begin(), stats.operations.end(),
+		    [name](const Vacationdb::Operation_Stats_t& op) { return op.name == name; });
+		return it == stats.operations.end() ? nullptr : &*it;
+	}
+}
+
+TEST(DB_METRICS, DisabledByDefault) {
+	Vacationdb::Database db;
+
+	auto e = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto d = db.add_day("Vacation", "0", "0");
+	db.query_vacation_days(e, d, 2016, 1, 1);
+
+	auto stats = db.get_stats();
+	ASSERT_EQ(stats.enabled, false);
+	ASSERT_EQ(stats.operations.size(), size_t{0});
+	ASSERT_EQ(stats.queries, uint64_t{0});
+}
+
+TEST(DB_METRICS, Operations) {
+	// Nothing is recorded when built with LIBVACATIONDB_METRICS=0
+	if (!Vacationdb::_detail::metrics_compiled) {
+		return;
+	}
+
+	Vacationdb::Database db;
+	db.enable_metrics(true);
+
+	auto e = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto d = db.add_day("Vacation", "0", "0");
+	db.edit_day_add_rule(d, 1, "25");
+	db.add_day_off(e, d, 2015, 6, 1, "1");
+	db.query_vacation_days(e, d, 2016, 1, 1);
+	db.query_vacation_days(e, d, 2017, 1, 1);
+
+	bool threw = false;
+	try {
+		db.get_employee_name(Vacationdb::PersonID_t{size_t{5}});
+	}
+	catch (Vacationdb::Invalid_Index&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+
+	auto stats = db.get_stats();
+	ASSERT_EQ(stats.enabled, true);
+
+	auto query = find_operation(stats, "query_vacation_days");
+	ASSERT_NE(query, nullptr);
+	ASSERT_EQ(query->calls, uint64_t{2});
+	ASSERT_EQ(query->errors, uint64_t{0});
+	ASSERT_EQ(query->latency_histogram.size(), size_t{40});
+	ASSERT_EQ(std::accumulate(query->latency_histogram.begin(), query->latency_histogram.end(),
+	                          uint64_t{0}),
+	          uint64_t{2});
+
+	auto name = find_operation(stats, "get_employee_name");
+	ASSERT_NE(name, nullptr);
+	ASSERT_EQ(name->calls, uint64_t{1});
+	ASSERT_EQ(name->errors, uint64_t{1});
+
+	ASSERT_EQ(stats.queries, uint64_t{2});
+	ASSERT_GT(stats.query_events, uint64_t{0});
+	ASSERT_GE(stats.query_events, stats.max_query_events);
+
+	db.reset_stats();
+	stats = db.get_stats();
+	ASSERT_EQ(stats.enabled, true);
+	ASSERT_EQ(stats.operations.size(), size_t{0});
+	ASSERT_EQ(stats.queries, uint64_t{0});
+
+	db.enable_metrics(false);
+	db.query_vacation_days(e, d, 2016, 1, 1);
+	ASSERT_EQ(db.get_stats().operations.size(), size_t{0});
+}
+
+TEST(DB_METRICS, LoadSave) {
+	// Nothing is recorded when built with LIBVACATIONDB_METRICS=0
+	if (!Vacationdb::_detail::metrics_compiled) {
+		return;
+	}
+
+	const char* file = "vdb_test_metrics.json";
+
+	Vacationdb::Database db;
+	db.enable_metrics(true);
+	db.add_employee("Bob", 2015, 1, 1, "1");
+	db.save(file);
+
+	Vacationdb::Database loaded;
+	loaded.enable_metrics(true);
+	loaded.load(file);
+
+	auto saved = db.get_stats();
+	ASSERT_EQ(saved.saves, uint64_t{1});
+	ASSERT_GT(saved.bytes_saved, uint64_t{0});
+
+	auto stats = loaded.get_stats();
+	ASSERT_EQ(stats.loads, uint64_t{1});
+	ASSERT_EQ(stats.bytes_loaded, saved.bytes_saved);
+	ASSERT_NE(find_operation(stats, "load"), nullptr);
+
+	std::remove(file);
+}
@@ -0,0 +1,74 @@
+#include "database_fixture.hpp"
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace {
+	const char* page_file = "vdb_out_of_core_test.pages";
+}
+
+TEST(DB_OUT_OF_CORE, PagedQueries) {
+	Vacationdb::Database db;
+	Vacationdb::Database in_memory;
+	Database_Fixture::fill(db, 200);
+	Database_Fixture::fill(in_memory, 200);
+
+	auto before = db.memory_usage();
+	db.enable_out_of_core(Vacationdb::Out_Of_Core_Config_t{page_file, 8192});
+
+	auto stats = db.get_out_of_core_stats();
+	ASSERT_TRUE(stats.enabled);
+	ASSERT_LE(stats.resident_bytes, size_t{8192});
+	ASSERT_LT(stats.resident_employees, size_t{200});
+	ASSERT_GT(stats.page_file_bytes, uint64_t{0});
+	ASSERT_LT(db.memory_usage().days_off, before.days_off);
+
+	Database_Fixture::expect_same(db, in_memory);
+	stats = db.get_out_of_core_stats();
+	ASSERT_GT(stats.faults, uint64_t{0});
+	ASSERT_LE(stats.resident_bytes, size_t{8192});
+
+	// Edits of paged out employees are written back before they are dropped again
+	for (size_t i = 0; i < 200; i += 9) {
+		for (auto* d : {&db, &in_memory}) {
+			Vacationdb::PersonID_t eid{i};
+			d->add_day_off(eid, Vacationdb::DayID_t{0}, 2018, 12, 24, "2");
+			d->remove_day_off(eid, Vacationdb::DayID_t{1}, 2016, 2,
+			                  static_cast<uint16_t>(i % 28 + 1));
+			d->edit_employee_add_extra_work_time(eid, 2017, 1, 1, 2017, 7, 1, "3/4");
+		}
+	}
+	Database_Fixture::expect_same(db, in_memory);
+
+	db.disable_out_of_core();
+	ASSERT_FALSE(db.get_out_of_core_stats().enabled);
+	ASSERT_FALSE(std::ifstream(page_file).good());
+	Database_Fixture::expect_same(db, in_memory);
+}
+
+TEST(DB_OUT_OF_CORE, LoadSave) {
+	const char* file = "vdb_out_of_core_test.json";
+
+	Vacationdb::Database in_memory;
+	Database_Fixture::fill(in_memory, 200);
+	in_memory.save(file);
+
+	Vacationdb::Database db;
+	db.enable_out_of_core(Vacationdb::Out_Of_Core_Config_t{page_file, 4096});
+	db.load(file);
+	std::remove(file);
+	ASSERT_LT(db.get_out_of_core_stats().resident_employees, size_t{200});
+	Database_Fixture::expect_same(db, in_memory);
+
+	// Saving reads the paged out employees back in one at a time
+	db.save(file);
+	Vacationdb::Database reloaded;
+	reloaded.load(file);
+	std::remove(file);
+	Database_Fixture::expect_same(reloaded, in_memory);
+
+	db.clear_db();
+	ASSERT_EQ(db.get_out_of_core_stats().page_file_bytes, uint64_t{0});
+}
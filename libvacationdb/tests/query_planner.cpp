@@ -0,0 +1,115 @@
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+#include <initializer_list>
+
+namespace {
+	// Every day type at once goes through a shared sweep that never uses the planner
+	std::string swept(Vacationdb::Database& db, uint16_t year, uint16_t month, uint16_t day) {
+		return db.query_vacation_days(Vacationdb::PersonID_t{0}, year, month, day)[0].days;
+	}
+}
+
+TEST(DB_QUERY_PLANNER, Classification) {
+	Vacationdb::Database db;
+
+	auto eid = db.add_employee("Bob", 2010, 3, 15, "1");
+	auto full = db.add_day("Full", "-1", "1");
+	db.edit_day_add_rule(full, 1, "20");
+	auto capped = db.add_day("Capped", "5", "0");
+	db.edit_day_add_rule(capped, 1, "20");
+
+	ASSERT_EQ(db.explain_query(eid, full, 2020, 1, 1).classification,
+	          Vacationdb::Query_Plan_t::CLOSED_FORM);
+	ASSERT_EQ(db.explain_query(eid, capped, 2020, 1, 1).classification,
+	          Vacationdb::Query_Plan_t::SWEEP);
+
+	// A second rule makes for a longer sweep
+	auto rule = db.edit_day_add_rule(capped, 13, "25");
+	ASSERT_EQ(db.explain_query(eid, capped, 2020, 1, 1).classification,
+	          Vacationdb::Query_Plan_t::CHECKPOINT);
+	db.edit_day_remove_rule(capped, rule);
+	ASSERT_EQ(db.explain_query(eid, capped, 2020, 1, 1).classification,
+	          Vacationdb::Query_Plan_t::SWEEP);
+
+	// So does extra work time, and it can't be closed form anymore either
+	auto extra = db.edit_employee_add_extra_work_time(eid, 2012, 1, 1, 2013, 1, 1, "1/2");
+	ASSERT_EQ(db.explain_query(eid, full, 2020, 1, 1).classification,
+	          Vacationdb::Query_Plan_t::CHECKPOINT);
+	db.edit_employee_remove_extra_work_time(eid, extra);
+	ASSERT_EQ(db.explain_query(eid, full, 2020, 1, 1).classification,
+	          Vacationdb::Query_Plan_t::CLOSED_FORM);
+
+	db.edit_day_rollover(full, "0");
+	ASSERT_EQ(db.explain_query(eid, full, 2020, 1, 1).classification,
+	          Vacationdb::Query_Plan_t::SWEEP);
+}
+
+TEST(DB_QUERY_PLANNER, ClosedForm) {
+	Vacationdb::Database db;
+
+	// A cap that is never reached gives the same balances through a sweep
+	auto full = db.add_day("Full", "-1", "1/3");
+	db.edit_day_add_rule(full, 4, "25");
+	auto uncapped = db.add_day("Uncapped", "100000", "1/3");
+	db.edit_day_add_rule(uncapped, 4, "25");
+
+	auto eid = db.add_employee("Bob", 2011, 7, 20, "3/4");
+	for (auto d : {full, uncapped}) {
+		db.add_day_off(eid, d, 2011, 7, 1, "5");
+		db.add_day_off(eid, d, 2012, 2, 29, "1/2");
+		db.add_day_off(eid, d, 2016, 12, 31, "3");
+		db.add_day_off(eid, d, 2019, 6, 30, "1");
+	}
+
+	ASSERT_EQ(db.explain_query(eid, full, 2019, 6, 30).strategy,
+	          Vacationdb::Query_Plan_t::CLOSED_FORM);
+	ASSERT_EQ(db.explain_query(eid, uncapped, 2019, 6, 30).strategy,
+	          Vacationdb::Query_Plan_t::SWEEP);
+
+	for (uint16_t year : std::initializer_list<uint16_t>{2010, 2011, 2012, 2016, 2017, 2019}) {
+		for (uint16_t month : std::initializer_list<uint16_t>{1, 7, 11}) {
+			ASSERT_EQ(db.query_vacation_days(eid, full, year, month, 1),
+			          db.query_vacation_days(eid, uncapped, year, month, 1));
+		}
+	}
+	ASSERT_EQ(db.query_vacation_days(eid, full, 2019, 6, 30),
+	          db.query_vacation_days(eid, uncapped, 2019, 6, 30));
+}
+
+TEST(DB_QUERY_PLANNER, Checkpoints) {
+	Vacationdb::Database db;
+
+	auto eid = db.add_employee("Bob", 2005, 5, 1, "1");
+	db.edit_employee_add_extra_work_time(eid, 2008, 1, 1, 2012, 6, 1, "1/2");
+	auto did = db.add_day("Vacation", "5", "0");
+	db.edit_day_add_rule(did, 1, "20");
+	db.add_day_off(eid, did, 2010, 3, 1, "2");
+	db.add_day("Other", "0", "0");
+
+	ASSERT_EQ(db.explain_query(eid, did, 2018, 3, 1).strategy, Vacationdb::Query_Plan_t::SWEEP);
+	ASSERT_EQ(db.query_vacation_days(eid, did, 2018, 3, 1), swept(db, 2018, 3, 1));
+
+	// Later dates resume from the start of 2018, earlier ones sweep from the start
+	auto plan = db.explain_query(eid, did, 2019, 7, 1);
+	ASSERT_EQ(plan.strategy, Vacationdb::Query_Plan_t::CHECKPOINT);
+	ASSERT_EQ(plan.checkpoint_year, uint16_t{2018});
+	ASSERT_EQ(db.explain_query(eid, did, 2017, 12, 31).strategy,
+	          Vacationdb::Query_Plan_t::SWEEP);
+
+	for (uint16_t year : std::initializer_list<uint16_t>{2018, 2019, 2020, 2016, 2030}) {
+		ASSERT_EQ(db.query_vacation_days(eid, did, year, 1, 1), swept(db, year, 1, 1));
+		ASSERT_EQ(db.query_vacation_days(eid, did, year, 8, 17), swept(db, year, 8, 17));
+	}
+	ASSERT_EQ(db.explain_query(eid, did, 2031, 1, 1).checkpoint_year, uint16_t{2030});
+
+	// Edits drop the checkpoints they could change
+	db.add_day_off(eid, did, 2012, 2, 1, "3");
+	ASSERT_EQ(db.explain_query(eid, did, 2031, 1, 1).strategy, Vacationdb::Query_Plan_t::SWEEP);
+	ASSERT_EQ(db.query_vacation_days(eid, did, 2030, 5, 1), swept(db, 2030, 5, 1));
+
+	db.edit_day_rollover(did, "7");
+	ASSERT_EQ(db.query_vacation_days(eid, did, 2031, 5, 1), swept(db, 2031, 5, 1));
+
+	db.edit_employee_start_date(eid, 2004, 1, 1);
+	ASSERT_EQ(db.query_vacation_days(eid, did, 2031, 5, 1), swept(db, 2031, 5, 1));
+}
@@ -0,0 +1,225 @@
+#include "database_impl.hpp"
+#include "sharded_database.hpp"
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+	Vacationdb::_detail::Number value_of(const Vacationdb::Rational_t& value) {
+		return Vacationdb::_detail::create_number_safe(value);
+	}
+
+	bool same(const Vacationdb::Rational_t& left, const Vacationdb::Rational_t& right) {
+		return left.numerator == right.numerator && left.denominator == right.denominator;
+	}
+}
+
+TEST(DB_SHARDED, Routing) {
+	Vacationdb::Sharded_Database db(4);
+	auto did = db.add_day("Vacation", "5", "0");
+	db.edit_day_add_rule(did, 1, "20");
+
+	for (int i = 0; i < 40; ++i) {
+		auto name = "Employee " + std::to_string(i);
+		auto eid = db.add_employee(name.c_str(), 2015, 1, 1, "1");
+		ASSERT_EQ(eid.shard, Vacationdb::Sharded_Database::hash_name(name, 4));
+		ASSERT_EQ(db.find_employee(name.c_str()).shard, eid.shard);
+		ASSERT_EQ(size_t{db.find_employee(name.c_str()).employee}, size_t{eid.employee});
+	}
+	ASSERT_EQ(db.get_employee_count(), size_t{40});
+
+	// Employees can be put into a shard of their own, such as their department's
+	auto bob = db.add_employee(3, "Bob", 2016, 1, 1, "1");
+	ASSERT_EQ(bob.shard, size_t{3});
+	db.add_day_off(bob, did, 2017, 1, 2, "3");
+	ASSERT_EQ(db.query_vacation_days(bob, did, 2017, 1, 2),
+	          db.get_shard(3).query_vacation_days(bob.employee, db.get_shard_day(3, did), 2017,
+	                                              1, 2));
+
+	bool threw = false;
+	try {
+		db.get_employee_name(Vacationdb::Shard_PersonID_t{4, Vacationdb::PersonID_t{0}});
+	}
+	catch (Vacationdb::Invalid_Index&) {
+		threw = true;
+	}
+	ASSERT_TRUE(threw);
+
+	// A key of our own
+	Vacationdb::Sharded_Database by_letter(2, [](std::string_view name, size_t) noexcept {
+		return name[0] < 'N' ? size_t{0} : size_t{1};
+	});
+	ASSERT_EQ(by_letter.add_employee("Alice", 2015, 1, 1, "1").shard, size_t{0});
+	ASSERT_EQ(by_letter.add_employee("Zed", 2015, 1, 1, "1").shard, size_t{1});
+}
+
+TEST(DB_SHARDED, BadDay) {
+	Vacationdb::Sharded_Database db(3);
+	auto did = db.add_day("Vacation", "5", "0");
+	auto bob = db.add_employee(1, "Bob", 2016, 1, 1, "1");
+
+	// No shard takes a day type that one of them would turn down
+	bool threw = false;
+	try {
+		db.add_day("Sick", "bad", "1");
+	}
+	catch (Vacationdb::Invalid_Number&) {
+		threw = true;
+	}
+	ASSERT_TRUE(threw);
+	ASSERT_EQ(db.get_day_count(), size_t{1});
+	for (size_t s = 0; s < 3; ++s) {
+		ASSERT_EQ(db.get_shard(s).get_day_count(), size_t{1});
+	}
+
+	threw = false;
+	try {
+		db.find_day("Sick");
+	}
+	catch (Vacationdb::Day_Not_Found&) {
+		threw = true;
+	}
+	ASSERT_TRUE(threw);
+
+	threw = false;
+	try {
+		db.report_vacation_days(Vacationdb::DayID_t{1}, 2017, 1, 1);
+	}
+	catch (Vacationdb::Day_Not_Found&) {
+		threw = true;
+	}
+	ASSERT_TRUE(threw);
+
+	// Everything still works, including adding the day type properly
+	ASSERT_EQ(db.report_vacation_days(did, 2017, 1, 1).size(), size_t{1});
+	auto sick = db.add_day("Sick", "0", "1");
+	ASSERT_EQ(size_t{sick}, size_t{1});
+	ASSERT_EQ(db.query_vacation_days(bob, sick, 2017, 1, 1), "1");
+	ASSERT_EQ(db.report_vacation_days(sick, 2017, 1, 1).size(), size_t{1});
+}
+
+TEST(DB_SHARDED, CrossShardReports) {
+	Vacationdb::Sharded_Database sharded(3);
+	auto did = sharded.add_day("Vacation", "5", "1");
+	sharded.edit_day_add_rule(did, 1, "20");
+	for (int i = 0; i < 90; ++i) {
+		auto name = "Employee " + std::to_string(i);
+		auto eid = sharded.add_employee(static_cast<size_t>(i % 3), name.c_str(),
+		                                static_cast<uint16_t>(2010 + i % 7), 3, 1, "1");
+		sharded.add_day_off(eid, did, 2018, 2, static_cast<uint16_t>(i % 28 + 1),
+		                    std::to_string(i % 11).c_str());
+	}
+
+	auto report = sharded.report_vacation_days_value(did, 2018, 6, 1);
+	ASSERT_EQ(report.size(), size_t{90});
+	size_t at = 0;
+	for (size_t s = 0; s < 3; ++s) {
+		auto part = sharded.get_shard(s).report_vacation_days_value(
+		    sharded.get_shard_day(s, did), 2018, 6, 1);
+		for (auto&& entry : part) {
+			ASSERT_EQ(report[at].employee.shard, s);
+			ASSERT_EQ(size_t{report[at].employee.employee}, size_t{entry.employee});
+			ASSERT_TRUE(same(report[at].days, entry.days));
+			++at;
+		}
+	}
+
+	auto strings = sharded.report_vacation_days(did, 2018, 6, 1);
+	ASSERT_EQ(strings.size(), report.size());
+	for (size_t i = 0; i < strings.size(); ++i) {
+		ASSERT_EQ(strings[i].days, sharded.query_vacation_days(strings[i].employee, did, 2018, 6,
+		                                                       1));
+	}
+
+	auto scan = sharded.scan_vacation_days(
+	    did, 2018, 6, 1,
+	    Vacationdb::Balance_Scan_t{Vacationdb::Balance_Scan_t::AT_MOST, {0, 1}});
+	size_t expected = 0;
+	for (auto&& entry : report) {
+		expected += entry.days.numerator <= 0;
+	}
+	ASSERT_EQ(scan.size(), expected);
+
+	// The merged top balances are the best of every shard, ties in order of shard
+	for (bool highest : {true, false}) {
+		auto expected_top = report;
+		std::stable_sort(expected_top.begin(), expected_top.end(),
+		                 [highest](const Vacationdb::Shard_Employee_Days_Value_t& left,
+		                           const Vacationdb::Shard_Employee_Days_Value_t& right) {
+			                 auto l = value_of(left.days);
+			                 auto r = value_of(right.days);
+			                 return highest ? l > r : l < r;
+		                 });
+
+		auto top = sharded.top_vacation_days(did, 2018, 6, 1, 10, highest);
+		ASSERT_EQ(top.size(), size_t{10});
+		for (size_t i = 0; i < top.size(); ++i) {
+			ASSERT_EQ(top[i].employee.shard, expected_top[i].employee.shard);
+			ASSERT_EQ(size_t{top[i].employee.employee}, size_t{expected_top[i].employee.employee});
+			ASSERT_TRUE(same(top[i].days, expected_top[i].days));
+		}
+	}
+}
+
+TEST(DB_SHARDED, LoadSave) {
+	std::vector<std::string> files{"vdb_shard_test_0.json", "vdb_shard_test_1.json"};
+
+	{
+		Vacationdb::Sharded_Database db(2);
+		auto did = db.add_day("Vacation", "5", "0");
+		db.edit_day_add_rule(did, 1, "20");
+		for (int i = 0; i < 20; ++i) {
+			auto name = "Employee " + std::to_string(i);
+			auto eid = db.add_employee(name.c_str(), 2015, 1, 1, "1");
+			db.add_day_off(eid, did, 2017, 5, 1, "2");
+		}
+		// Day types that only some shards have are matched up by name on load
+		db.get_shard(1).add_day("Sick", "0", "3");
+		db.save(files);
+	}
+
+	Vacationdb::Sharded_Database loaded(1);
+	loaded.load(files);
+	for (auto&& file : files) {
+		std::remove(file.c_str());
+	}
+
+	ASSERT_EQ(loaded.get_shard_count(), size_t{2});
+	ASSERT_EQ(loaded.get_current_filenames(), files);
+	ASSERT_EQ(loaded.get_employee_count(), size_t{20});
+	ASSERT_EQ(loaded.list_day_names(), (std::vector<std::string>{"Vacation", "Sick"}));
+
+	auto did = loaded.find_day("Vacation");
+	auto sick = loaded.find_day("Sick");
+	auto eid = loaded.find_employee("Employee 7");
+	ASSERT_EQ(eid.shard, Vacationdb::Sharded_Database::hash_name("Employee 7", 2));
+	ASSERT_EQ(loaded.query_vacation_days(eid, did, 2018, 1, 1), "5");
+
+	size_t with_sick = loaded.report_vacation_days(sick, 2018, 1, 1).size();
+	ASSERT_EQ(with_sick, loaded.get_shard(1).get_employee_count());
+
+	// A shard that fails to load leaves every shard as it was
+	bool threw = false;
+	try {
+		loaded.load({"vdb_shard_test_missing_0.json", "vdb_shard_test_missing_1.json"});
+	}
+	catch (Vacationdb::Invalid_File&) {
+		threw = true;
+	}
+	ASSERT_TRUE(threw);
+	ASSERT_EQ(loaded.get_employee_count(), size_t{20});
+
+	threw = false;
+	try {
+		loaded.load({});
+	}
+	catch (Vacationdb::Invalid_Index&) {
+		threw = true;
+	}
+	ASSERT_TRUE(threw);
+	ASSERT_EQ(loaded.get_shard_count(), size_t{2});
+}
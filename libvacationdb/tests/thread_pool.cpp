@@ -0,0 +1,92 @@
+#include "thread_pool.hpp"
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(THREAD_POOL, Submit) {
+	Vacationdb::_detail::Thread_Pool pool(2);
+
+	auto a = pool.submit([]() noexcept { return 21 * 2; });
+	auto b = pool.submit([] { return std::string("done"); });
+
+	ASSERT_EQ(a.get(), 42);
+	ASSERT_STREQ(b.get().c_str(), "done");
+}
+
+TEST(THREAD_POOL, ParallelFor) {
+	Vacationdb::_detail::Thread_Pool pool(3);
+
+	std::vector<int> values(1000, 0);
+	pool.parallel_for(values.size(), 7, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			values[i] += 1;
+		}
+	});
+
+	for (auto v : values) {
+		ASSERT_EQ(v, 1);
+	}
+
+	auto stats = pool.stats();
+	ASSERT_EQ(stats.thread_count, size_t{3});
+	ASSERT_EQ(stats.queue_depth, size_t{0});
+}
+
+TEST(THREAD_POOL, NestedParallelFor) {
+	Vacationdb::_detail::Thread_Pool pool(2);
+
+	std::atomic<size_t> total{0};
+	auto outer = pool.submit([&] {
+		pool.parallel_for(16, 1, [&](size_t, size_t) {
+			pool.parallel_for(16, 1, [&](size_t, size_t) { total.fetch_add(1); });
+		});
+	});
+	pool.wait(outer);
+
+	ASSERT_EQ(total.load(), size_t{256});
+}
+
+TEST(THREAD_POOL, ParallelForRethrows) {
+	Vacationdb::_detail::Thread_Pool pool(2);
+
+	bool threw = false;
+	try {
+		pool.parallel_for(10, 1, [](size_t begin, size_t) {
+			if (begin == 5) {
+				throw std::runtime_error("chunk failed");
+			}
+		});
+	}
+	catch (std::runtime_error&) {
+		threw = true;
+	}
+
+	ASSERT_EQ(threw, true);
+}
+
+TEST(THREAD_POOL, ReportMatchesQueries) {
+	Vacationdb::Database db(2);
+
+	auto did = db.add_day("Vacation", "-1", "0");
+	db.edit_day_add_rule(did, 1, "24");
+
+	std::vector<Vacationdb::PersonID_t> ids;
+	for (uint16_t i = 0; i < 200; ++i) {
+		ids.push_back(db.add_employee("Bob", uint16_t(1990 + i % 20), 1, uint16_t(1 + i % 28), "1"));
+	}
+	db.delete_employee(ids[3]);
+
+	auto report = db.report_vacation_days(did, 2017, 6, 30);
+	ASSERT_EQ(report.size(), size_t{199});
+
+	for (auto&& r : report) {
+		ASSERT_STREQ(r.days.c_str(), db.query_vacation_days(r.employee, did, 2017, 6, 30).c_str());
+	}
+
+	auto stats = db.get_thread_pool_stats();
+	ASSERT_EQ(stats.thread_count, size_t{2});
+	ASSERT_GT(stats.tasks_executed, uint64_t{0});
+}
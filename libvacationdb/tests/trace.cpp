@@ -0,0 +1,60 @@
+#include "trace.hpp"
+#include "vacationdb.hpp"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace {
+	std::string read_file(const char* name) {
+		std::ifstream in(name, std::ios::binary);
+		return std::string{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+	}
+}
+
+TEST(DB_TRACE, Spans) {
+	// Nothing is recorded when built with LIBVACATIONDB_TRACING=0
+	if (!Vacationdb::_detail::tracing_compiled) {
+		return;
+	}
+
+	const char* file = "vdb_test_trace_db.json";
+	const char* trace = "vdb_test_trace.json";
+
+	Vacationdb::Database db;
+	auto e = db.add_employee("Bob", 2015, 1, 1, "1");
+	auto d = db.add_day("Vacation", "0", "0");
+	db.edit_day_add_rule(d, 1, "25");
+
+	db.query_vacation_days(e, d, 2016, 1, 1);
+
+	Vacationdb::Database::start_tracing();
+	db.query_vacation_days(e, d, 2017, 1, 1);
+	db.report_vacation_days(d, 2017, 1, 1);
+	db.query_vacation_days_async(e, 2017, 1, 1).get();
+	db.save(file);
+	db.load(file);
+	Vacationdb::Database::stop_tracing(trace);
+
+	// Nothing is recorded once tracing stopped
+	db.query_vacation_days(e, d, 2018, 1, 1);
+
+	auto contents = read_file(trace);
+	ASSERT_EQ(contents.compare(0, 16, "{\"traceEvents\":["), 0);
+	for (auto name : {"query: build events", "query: sort", "query: sweep", "query: to string",
+	                  "report: balances", "query batch", "load: parse", "save: write"}) {
+		ASSERT_NE(contents.find(std::string("\"name\":\"") + name + "\""), std::string::npos)
+		    << name;
+	}
+	ASSERT_NE(contents.find("\"ph\":\"X\""), std::string::npos);
+	ASSERT_NE(contents.find("\"tid\":"), std::string::npos);
+
+	// A new trace starts out empty
+	Vacationdb::Database::start_tracing();
+	Vacationdb::Database::stop_tracing(trace);
+	ASSERT_EQ(read_file(trace), "{\"traceEvents\":[]}\n");
+
+	std::remove(file);
+	std::remove(trace);
+}
@@ -76,3 +76,58 @@ TEST(UTILS_NUMBER, Fractional_Decimals) {
 	ASSERT_STREQ(gen_number("2.6/-12.532").c_str(), "-50/241");
 	ASSERT_STREQ(gen_number("3.1/-12.532").c_str(), "-775/3133");
 }
+
+TEST(UTILS_NUMBER, Rationals) {
+	auto r = Vacationdb::_detail::create_rational_safe(
+	    Vacationdb::_detail::create_number_safe("-6/4"));
+	ASSERT_EQ(r.numerator, int64_t{-3});
+	ASSERT_EQ(r.denominator, int64_t{2});
+
+	auto n = Vacationdb::_detail::create_number_safe(Vacationdb::Rational_t{6, -4});
+	ASSERT_STREQ(n.convert_to<std::string>().c_str(), "-3/2");
+
+	bool threw = false;
+	try {
+		Vacationdb::_detail::create_rational_safe(
+		    Vacationdb::_detail::create_number_safe("100000000000000000000"));
+	}
+	catch (Vacationdb::Number_Out_Of_Range&) {
+		threw = true;
+	}
+	ASSERT_EQ(threw, true);
+}
+
+TEST(UTILS_NUMBER, Decimal_Forms) {
+	ASSERT_STREQ(gen_number("+2.50").c_str(), "5/2");
+	ASSERT_STREQ(gen_number(".5").c_str(), "1/2");
+	ASSERT_STREQ(gen_number("5.").c_str(), "5");
+	ASSERT_STREQ(gen_number("-0.25").c_str(), "-1/4");
+	ASSERT_STREQ(gen_number("007").c_str(), "7");
+	ASSERT_STREQ(gen_number("1/.5").c_str(), "2");
+}
+
+TEST(UTILS_NUMBER, Large_Numbers) {
+	ASSERT_STREQ(gen_number("123456789012345678901234567890").c_str(),
+	             "123456789012345678901234567890");
+	ASSERT_STREQ(gen_number("-1/123456789012345678901234567890").c_str(),
+	             "-1/123456789012345678901234567890");
+	ASSERT_STREQ(gen_number("0.0000000000000000000001").c_str(), "1/10000000000000000000000");
+	ASSERT_STREQ(gen_number("9223372036854775807").c_str(), "9223372036854775807");
+	ASSERT_STREQ(gen_number("-9223372036854775808").c_str(), "-9223372036854775808");
+}
+
+TEST(UTILS_NUMBER, Invalid) {
+	const char* invalid[] = {"", "-", ".", "1..2", "1/", "/2", "1/2/3", "1/0", "0.0/0.00", "1e5",
+	                         " 1", "abc"};
+
+	for (auto&& value : invalid) {
+		bool threw = false;
+		try {
+			gen_number(value);
+		}
+		catch (Vacationdb::Invalid_Number&) {
+			threw = true;
+		}
+		ASSERT_EQ(threw, true) << value;
+	}
+}
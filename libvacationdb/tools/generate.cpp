@@ -0,0 +1,135 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "generator.hpp"
+
+namespace {
+	void usage(const char* name) {
+		std::cerr
+		    << "Usage: " << name << " [options]\n"
+		    << "Writes a synthetic database in the native file format.\n\n"
+		    << "  --output FILE          file to write (vdb.json)\n"
+		    << "  --seed N               random seed (42)\n"
+		    << "  --employees N          number of employees (100000)\n"
+		    << "  --final-year N         last year of history (2017)\n"
+		    << "  --years MIN MAX        years of history per employee (10 40)\n"
+		    << "  --day-types N          number of day types (4)\n"
+		    << "  --max-rules N          most rules per day type (3)\n"
+		    << "  --extra-time P N       chance of extra work time, most ranges (0.2 3)\n"
+		    << "  --days-off MIN MAX     days off per employee per year (15 35)\n"
+		    << "  --single-inserts       add days off one at a time\n";
+	}
+
+	uint64_t number_arg(int argc, char** argv, int& i) {
+		if (++i >= argc) {
+			throw std::invalid_argument(argv[i - 1]);
+		}
+		char* end;
+		auto value = std::strtoull(argv[i], &end, 10);
+		if (*end != '\0') {
+			throw std::invalid_argument(argv[i]);
+		}
+		return value;
+	}
+
+	double fraction_arg(int argc, char** argv, int& i) {
+		if (++i >= argc) {
+			throw std::invalid_argument(argv[i - 1]);
+		}
+		char* end;
+		auto value = std::strtod(argv[i], &end);
+		if (*end != '\0' || value < 0 || value > 1) {
+			throw std::invalid_argument(argv[i]);
+		}
+		return value;
+	}
+}
+
+int main(int argc, char** argv) {
+	Vacationdb_Tools::Generator_Config_t cfg;
+	std::string output = "vdb.json";
+
+	try {
+		for (int i = 1; i < argc; ++i) {
+			const char* arg = argv[i];
+			if (std::strcmp(arg, "--output") == 0 && i + 1 < argc) {
+				output = argv[++i];
+			}
+			else if (std::strcmp(arg, "--seed") == 0) {
+				cfg.seed = number_arg(argc, argv, i);
+			}
+			else if (std::strcmp(arg, "--employees") == 0) {
+				cfg.employees = number_arg(argc, argv, i);
+			}
+			else if (std::strcmp(arg, "--final-year") == 0) {
+				cfg.final_year = static_cast<uint16_t>(number_arg(argc, argv, i));
+			}
+			else if (std::strcmp(arg, "--years") == 0) {
+				cfg.min_years = static_cast<uint16_t>(number_arg(argc, argv, i));
+				cfg.max_years = static_cast<uint16_t>(number_arg(argc, argv, i));
+			}
+			else if (std::strcmp(arg, "--day-types") == 0) {
+				cfg.day_types = number_arg(argc, argv, i);
+			}
+			else if (std::strcmp(arg, "--max-rules") == 0) {
+				cfg.max_rules = number_arg(argc, argv, i);
+			}
+			else if (std::strcmp(arg, "--extra-time") == 0) {
+				cfg.extra_time_chance = fraction_arg(argc, argv, i);
+				cfg.max_extra_times = number_arg(argc, argv, i);
+			}
+			else if (std::strcmp(arg, "--days-off") == 0) {
+				cfg.min_days_off = static_cast<uint32_t>(number_arg(argc, argv, i));
+				cfg.max_days_off = static_cast<uint32_t>(number_arg(argc, argv, i));
+			}
+			else if (std::strcmp(arg, "--single-inserts") == 0) {
+				cfg.single_inserts = true;
+			}
+			else {
+				throw std::invalid_argument(arg);
+			}
+		}
+	}
+	catch (std::invalid_argument& e) {
+		std::cerr << "Invalid argument: " << e.what() << "\n\n";
+		usage(argv[0]);
+		return 1;
+	}
+
+	bool valid = cfg.min_years >= 1 && cfg.min_years <= cfg.max_years &&
+	             uint32_t{cfg.max_years} + 1400u <= cfg.final_year && cfg.final_year <= 9999 &&
+	             cfg.day_types >= 1 && cfg.max_rules >= 1 && cfg.max_extra_times >= 1 &&
+	             cfg.min_days_off <= cfg.max_days_off;
+	if (!valid) {
+		std::cerr << "Inconsistent options\n\n";
+		usage(argv[0]);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	Vacationdb::Database db;
+	Vacationdb_Tools::Generator{cfg}.fill(db);
+
+	auto generated = std::chrono::steady_clock::now();
+
+	try {
+		db.save(output.c_str());
+	}
+	catch (std::exception& e) {
+		std::cerr << "Could not write " << output << ": " << e.what() << '\n';
+		return 1;
+	}
+
+	auto saved = std::chrono::steady_clock::now();
+
+	auto ms = [](std::chrono::steady_clock::duration d) {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+	};
+	std::cout << "Generated " << cfg.employees << " employees in " << ms(generated - start)
+	          << " ms, saved to " << output << " in " << ms(saved - generated) << " ms\n";
+
+	return 0;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "vacationdb.hpp"
+
+namespace Vacationdb_Tools {
+	// Everything is drawn uniformly from [min, max] unless noted otherwise.
+	struct Generator_Config_t {
+		uint64_t seed = 42;
+		size_t employees = 100000;
+		// History ends on the last day of final_year
+		uint16_t final_year = 2017;
+		uint16_t min_years = 10;
+		uint16_t max_years = 40;
+
+		size_t day_types = 4;
+		size_t max_rules = 3;
+
+		// Chance an employee has extra work time, and how many ranges they
+		// have if so. Ranges are placed independently, so they overlap.
+		double extra_time_chance = 0.2;
+		size_t max_extra_times = 3;
+
+		// Days off per employee per year, spread over the day types
+		uint32_t min_days_off = 15;
+		uint32_t max_days_off = 35;
+
+		// Add days off one call at a time instead of one batch per day type
+		bool single_inserts = false;
+	};
+
+	// Generates the same database for the same config on every platform. The
+	// standard distributions differ between libraries, so they are not used.
+	class Generator {
+	  public:
+		explicit Generator(const Generator_Config_t& config) : cfg(config), state(config.seed) {}
+
+		void fill(Vacationdb::Database& db) {
+			std::vector<Vacationdb::DayID_t> types;
+			for (size_t i = 0; i < cfg.day_types; ++i) {
+				types.push_back(add_day_type(db, i));
+			}
+
+			std::vector<std::vector<Vacationdb::Date_t>> days_off(types.size());
+			for (size_t i = 0; i < cfg.employees; ++i) {
+				add_employee(db, i, types, days_off);
+			}
+		}
+
+		static std::string employee_name(size_t index) {
+			char buffer[32];
+			std::snprintf(buffer, sizeof(buffer), "Employee %06zu", index);
+			return buffer;
+		}
+
+	  private:
+		Generator_Config_t cfg;
+		uint64_t state;
+
+		// splitmix64, small and the same everywhere
+		uint64_t next() {
+			uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		uint32_t uniform(uint32_t min, uint32_t max) {
+			return min + static_cast<uint32_t>(next() % (uint64_t{max} - min + 1));
+		}
+
+		bool chance(double p) {
+			return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0) < p;
+		}
+
+		template <size_t N>
+		const char* pick(const char* const (&choices)[N]) {
+			return choices[uniform(0, N - 1)];
+		}
+
+		static uint16_t days_in_month(uint16_t year, uint16_t month) {
+			static const uint16_t days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+			bool leap = (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0));
+			return static_cast<uint16_t>(days[month - 1] + ((month == 2 && leap) ? 1 : 0));
+		}
+
+		Vacationdb::DayID_t add_day_type(Vacationdb::Database& db, size_t index) {
+			static const char* const rollovers[] = {"0", "5", "10", "-1"};
+			static const char* const bonuses[] = {"0", "0", "1", "5"};
+			static const char* const rates[] = {"10", "15", "20", "25", "9.96", "30"};
+
+			auto name = "Day Type " + std::to_string(index);
+			auto d = db.add_day(name.c_str(), pick(rollovers), pick(bonuses));
+
+			// Later rules start further into the employment
+			uint32_t month = 1;
+			auto rules = uniform(1, static_cast<uint32_t>(cfg.max_rules));
+			for (uint32_t r = 0; r < rules; ++r) {
+				db.edit_day_add_rule(d, month, pick(rates));
+				month += uniform(12, 60);
+			}
+			return d;
+		}
+
+		void add_employee(Vacationdb::Database& db, size_t index,
+		                  const std::vector<Vacationdb::DayID_t>& types,
+		                  std::vector<std::vector<Vacationdb::Date_t>>& days_off) {
+			static const char* const work_times[] = {"1", "1", "1", "0.8", "1/2"};
+			static const char* const extra_times[] = {"0", "1/2", "0.6", "1"};
+			static const char* const amounts[] = {"1", "1", "1", "1", "0.5", "2"};
+
+			auto years = uniform(cfg.min_years, cfg.max_years);
+			auto first_year = static_cast<uint16_t>(cfg.final_year - years + 1);
+			auto start_month = static_cast<uint16_t>(uniform(1, 12));
+			auto start_day = static_cast<uint16_t>(uniform(1, 28));
+
+			auto e = db.add_employee(employee_name(index).c_str(), first_year, start_month,
+			                         start_day, pick(work_times));
+
+			if (chance(cfg.extra_time_chance)) {
+				auto count = uniform(1, static_cast<uint32_t>(cfg.max_extra_times));
+				for (uint32_t i = 0; i < count; ++i) {
+					auto begin = static_cast<uint16_t>(uniform(first_year, cfg.final_year));
+					auto end = static_cast<uint16_t>(begin + uniform(1, 3));
+					db.edit_employee_add_extra_work_time(
+					    e, begin, static_cast<uint16_t>(uniform(1, 12)), 1, end,
+					    static_cast<uint16_t>(uniform(1, 12)), 1, pick(extra_times));
+				}
+			}
+
+			for (auto& list : days_off) {
+				list.clear();
+			}
+
+			for (uint16_t year = first_year; year <= cfg.final_year; ++year) {
+				auto count = uniform(cfg.min_days_off, cfg.max_days_off);
+				for (uint32_t i = 0; i < count; ++i) {
+					auto month = static_cast<uint16_t>(uniform(1, 12));
+					auto day = static_cast<uint16_t>(uniform(1, days_in_month(year, month)));
+					// The first day type is the one most days off go to
+					auto type = chance(0.6) ? 0 : uniform(0, static_cast<uint32_t>(types.size() - 1));
+					days_off[type].push_back(Vacationdb::Date_t{year, month, day, pick(amounts)});
+				}
+			}
+
+			for (size_t t = 0; t < types.size(); ++t) {
+				if (cfg.single_inserts) {
+					for (auto&& day : days_off[t]) {
+						db.add_day_off(e, types[t], day.year, day.month, day.day,
+						               day.amount.c_str());
+					}
+				}
+				else {
+					db.add_days_off(e, types[t], days_off[t]);
+				}
+			}
+		}
+	};
+}
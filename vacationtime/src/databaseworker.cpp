@@ -0,0 +1,72 @@
+#include "databaseworker.hpp"
+
+#include <future>
+#include <vector>
+
+DatabaseWorker::DatabaseWorker(Vacationdb::Database& database) :
+    QObject(nullptr),
+    db(database)
+{
+    qRegisterMetaType<QVector<quint64>>("QVector<quint64>");
+}
+
+void DatabaseWorker::ComputeBalances(quint64 generation, QVector<quint64> employees,
+                                     quint64 day, QDate date) {
+    Vacationdb::DayID_t day_id{static_cast<size_t>(day)};
+    auto year = static_cast<uint16_t>(date.year());
+    auto month = static_cast<uint16_t>(date.month());
+    auto month_day = static_cast<uint16_t>(date.day());
+
+    // Issued all at once so the database answers them together
+    std::vector<std::future<std::string>> futures;
+    futures.reserve(static_cast<size_t>(employees.size()));
+    for (auto employee : employees) {
+        try {
+            Vacationdb::PersonID_t id{static_cast<size_t>(employee)};
+            futures.push_back(db.query_vacation_days_async(id, day_id, year, month, month_day));
+        }
+        catch (std::exception&) {
+            std::promise<std::string> failed;
+            failed.set_exception(std::current_exception());
+            futures.push_back(failed.get_future());
+        }
+    }
+
+    QStringList balances;
+    balances.reserve(employees.size());
+    for (auto& future : futures) {
+        try {
+            balances.append(QString::fromStdString(future.get()));
+        }
+        catch (std::exception&) {
+            balances.append(QString());
+        }
+    }
+
+    emit BalancesReady(generation, employees, balances);
+}
+
+void DatabaseWorker::Load(QString filename) {
+    try {
+        db.load(filename.toLocal8Bit().constData());
+        emit IoFinished(QString());
+    }
+    catch (std::exception& e) {
+        emit IoFinished(QString::fromUtf8(e.what()));
+    }
+}
+
+void DatabaseWorker::Save(QString filename) {
+    try {
+        db.save(filename.toLocal8Bit().constData());
+        emit IoFinished(QString());
+    }
+    catch (std::exception& e) {
+        emit IoFinished(QString::fromUtf8(e.what()));
+    }
+}
+
+void DatabaseWorker::Clear() {
+    db.clear_db();
+    emit IoFinished(QString());
+}
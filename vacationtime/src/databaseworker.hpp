@@ -0,0 +1,41 @@
+#ifndef DATABASEWORKER_HPP
+#define DATABASEWORKER_HPP
+
+#include <QDate>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include "vacationdb.hpp"
+
+// Everything that can take a while runs through this object on its own
+// thread, one request at a time. Results go back through queued signals, so
+// the GUI thread never waits on the database. While a load or save is running
+// the GUI thread may only call get_load_status.
+class DatabaseWorker : public QObject
+{
+        Q_OBJECT
+
+    public:
+        explicit DatabaseWorker(Vacationdb::Database& database);
+
+    public slots:
+        // Answered through BalancesReady with the same generation
+        void ComputeBalances(quint64 generation, QVector<quint64> employees, quint64 day,
+                             QDate date);
+        // Each answered through IoFinished
+        void Load(QString filename);
+        void Save(QString filename);
+        void Clear();
+
+    signals:
+        // An empty string for an employee whose balance couldn't be computed
+        void BalancesReady(quint64 generation, QVector<quint64> employees, QStringList balances);
+        // error is empty when it worked
+        void IoFinished(QString error);
+
+    private:
+        Vacationdb::Database& db;
+};
+
+#endif // DATABASEWORKER_HPP
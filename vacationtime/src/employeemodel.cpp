@@ -0,0 +1,248 @@
+#include "employeemodel.hpp"
+
+#include <algorithm>
+#include <string_view>
+
+namespace {
+    // Rows handed to the view at a time
+    const int page_size = 256;
+    // Balances asked for at once
+    const int request_size = 512;
+
+    QString to_qstring(std::string_view value) {
+        return QString::fromUtf8(value.data(), static_cast<int>(value.size()));
+    }
+}
+
+EmployeeModel::EmployeeModel(Vacationdb::Database& database, QObject *parent) :
+    QAbstractTableModel(parent),
+    db(database)
+{
+    qRegisterMetaType<QVector<quint64>>("QVector<quint64>");
+
+    // Rows shown together are asked for together
+    request_timer.setSingleShot(true);
+    request_timer.setInterval(20);
+    connect(&request_timer, SIGNAL(timeout()), this, SLOT(RequestBalances()));
+
+    Reload();
+}
+
+int EmployeeModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : fetched;
+}
+
+int EmployeeModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant EmployeeModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= fetched || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    auto employee = ids[static_cast<size_t>(index.row())];
+    try {
+        switch (index.column()) {
+            case NameColumn:
+                return to_qstring(db.get_employee_name_view(employee));
+            case StartColumn:
+                return InfoFor(employee).start;
+            case WorkTimeColumn:
+                return InfoFor(employee).work_time;
+            case BalanceColumn: {
+                if (!has_balance_query) {
+                    return QVariant();
+                }
+
+                auto found = balances.find(employee);
+                if (found != balances.end()) {
+                    return *found;
+                }
+                if (!pending.contains(employee)) {
+                    pending.insert(employee);
+                    queued.append(employee);
+                    if (!request_timer.isActive()) {
+                        request_timer.start();
+                    }
+                }
+                return tr("...");
+            }
+            default:
+                return QVariant();
+        }
+    }
+    catch (std::exception&) {
+        // Deleted since the list was read
+        return QVariant();
+    }
+}
+
+QVariant EmployeeModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section) {
+        case NameColumn:
+            return tr("Name");
+        case StartColumn:
+            return tr("Start Date");
+        case WorkTimeColumn:
+            return tr("Work Time");
+        case BalanceColumn:
+            return tr("Balance");
+        default:
+            return QVariant();
+    }
+}
+
+bool EmployeeModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && static_cast<size_t>(fetched) < ids.size();
+}
+
+void EmployeeModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid()) {
+        return;
+    }
+
+    int remaining = static_cast<int>(ids.size()) - fetched;
+    int count = std::min(remaining, page_size);
+    if (count <= 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), fetched, fetched + count - 1);
+    fetched += count;
+    endInsertRows();
+}
+
+void EmployeeModel::sort(int column, Qt::SortOrder order) {
+    sort_column = column;
+    sort_order = order;
+    Reload();
+}
+
+Vacationdb::PersonID_t EmployeeModel::EmployeeAt(int row) const {
+    return ids[static_cast<size_t>(row)];
+}
+
+int EmployeeModel::EmployeeCount() const {
+    return static_cast<int>(ids.size());
+}
+
+void EmployeeModel::Reload() {
+    beginResetModel();
+
+    if (!filter.isEmpty()) {
+        ids = db.find_employees_containing(filter.toUtf8().constData());
+    }
+    else if (sort_column == NameColumn) {
+        ids = db.list_employee_ids_by_name();
+    }
+    else {
+        ids = db.list_employee_ids();
+    }
+    if (sort_order == Qt::DescendingOrder) {
+        std::reverse(ids.begin(), ids.end());
+    }
+
+    fetched = std::min(static_cast<int>(ids.size()), page_size);
+    row_info.clear();
+    ResetRows();
+
+    endResetModel();
+}
+
+void EmployeeModel::Suspend() {
+    beginResetModel();
+    ids.clear();
+    fetched = 0;
+    row_info.clear();
+    ResetRows();
+    endResetModel();
+}
+
+void EmployeeModel::SetFilter(const QString& text) {
+    if (text != filter) {
+        filter = text;
+        Reload();
+    }
+}
+
+void EmployeeModel::SetBalanceQuery(Vacationdb::DayID_t day, const QDate& date) {
+    has_balance_query = true;
+    balance_day = day;
+    balance_date = date;
+    ResetRows();
+    BalancesChanged();
+}
+
+void EmployeeModel::ClearBalanceQuery() {
+    has_balance_query = false;
+    ResetRows();
+    BalancesChanged();
+}
+
+void EmployeeModel::RequestBalances() {
+    if (queued.isEmpty()) {
+        return;
+    }
+
+    // Rows that were scrolled past long ago are asked for last
+    QVector<quint64> employees;
+    int count = std::min(queued.size(), request_size);
+    employees.reserve(count);
+    for (int i = queued.size() - count; i < queued.size(); ++i) {
+        employees.append(queued[i]);
+    }
+    queued.resize(queued.size() - count);
+
+    emit BalancesWanted(generation, employees, static_cast<size_t>(balance_day), balance_date);
+
+    if (!queued.isEmpty()) {
+        request_timer.start();
+    }
+}
+
+void EmployeeModel::BalancesReady(quint64 result_generation, QVector<quint64> employees,
+                                  QStringList results) {
+    if (result_generation != generation) {
+        return;
+    }
+
+    for (int i = 0; i < employees.size(); ++i) {
+        balances.insert(employees[i], results[i]);
+        pending.remove(employees[i]);
+    }
+
+    BalancesChanged();
+}
+
+const EmployeeModel::RowInfo& EmployeeModel::InfoFor(Vacationdb::PersonID_t employee) const {
+    auto found = row_info.find(employee);
+    if (found != row_info.end()) {
+        return *found;
+    }
+
+    auto info = db.get_employee_info(employee);
+    RowInfo row;
+    row.start = QDate(info.start_year, info.start_month, info.start_day).toString(Qt::ISODate);
+    row.work_time = QString::fromStdString(info.work_time);
+    return *row_info.insert(employee, row);
+}
+
+void EmployeeModel::BalancesChanged() {
+    // The view only repaints the rows it shows
+    if (fetched > 0) {
+        emit dataChanged(index(0, BalanceColumn), index(fetched - 1, BalanceColumn));
+    }
+}
+
+void EmployeeModel::ResetRows() {
+    ++generation;
+    balances.clear();
+    pending.clear();
+    queued.clear();
+    request_timer.stop();
+}
@@ -0,0 +1,104 @@
+#ifndef EMPLOYEEMODEL_HPP
+#define EMPLOYEEMODEL_HPP
+
+#include <QAbstractTableModel>
+#include <QDate>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include <vector>
+
+#include "vacationdb.hpp"
+
+// The employees of a database as a table. Only ids are read up front, rows
+// are handed to the view a page at a time and everything else is read when a
+// row is first shown. Balances are asked for through BalancesWanted, to be
+// computed off the GUI thread, and cached until the list or the query changes.
+class EmployeeModel : public QAbstractTableModel
+{
+        Q_OBJECT
+
+    public:
+        enum Column {
+            NameColumn = 0,
+            StartColumn,
+            WorkTimeColumn,
+            BalanceColumn,
+            ColumnCount
+        };
+
+        explicit EmployeeModel(Vacationdb::Database& database, QObject *parent = 0);
+
+        int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+        int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+        QVariant headerData(int section, Qt::Orientation orientation,
+                            int role = Qt::DisplayRole) const override;
+
+        bool canFetchMore(const QModelIndex& parent) const override;
+        void fetchMore(const QModelIndex& parent) override;
+
+        // Only the name column has an index to sort with, the others go by id
+        void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+        Vacationdb::PersonID_t EmployeeAt(int row) const;
+        // Every employee that matches the filter, fetched into the view or not
+        int EmployeeCount() const;
+
+    public slots:
+        // Rereads the list of employees, after a load or edits
+        void Reload();
+        // Empties the table without reading the database, for while it is busy
+        void Suspend();
+        // Only employees whose name contains text
+        void SetFilter(const QString& text);
+        // The day type and date the balance column is for
+        void SetBalanceQuery(Vacationdb::DayID_t day, const QDate& date);
+        void ClearBalanceQuery();
+
+        // Results of an older generation are thrown away
+        void BalancesReady(quint64 generation, QVector<quint64> employees, QStringList balances);
+
+    signals:
+        void BalancesWanted(quint64 generation, QVector<quint64> employees, quint64 day,
+                            QDate date);
+
+    private slots:
+        void RequestBalances();
+
+    private:
+        struct RowInfo {
+            QString start;
+            QString work_time;
+        };
+
+        const RowInfo& InfoFor(Vacationdb::PersonID_t employee) const;
+        void BalancesChanged();
+        void ResetRows();
+
+        Vacationdb::Database& db;
+
+        std::vector<Vacationdb::PersonID_t> ids;
+        int fetched = 0;
+        QString filter;
+        int sort_column = -1;
+        Qt::SortOrder sort_order = Qt::AscendingOrder;
+
+        // Filled in as rows are shown
+        mutable QHash<quint64, RowInfo> row_info;
+
+        bool has_balance_query = false;
+        Vacationdb::DayID_t balance_day;
+        QDate balance_date;
+        // Results from before the last reset are thrown away
+        quint64 generation = 0;
+        mutable QHash<quint64, QString> balances;
+        mutable QSet<quint64> pending;
+        mutable QVector<quint64> queued;
+        mutable QTimer request_timer;
+};
+
+#endif // EMPLOYEEMODEL_HPP
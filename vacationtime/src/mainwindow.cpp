@@ -1,12 +1,79 @@
 #include "mainwindow.hpp"
 #include "ui_mainwindow.h"
 
+#include <QDate>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QStatusBar>
+
+#include <algorithm>
+
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
     connect(ui->actionAbout_VacationTime, SIGNAL(triggered()), this, SLOT(OpenAboutWindow()));
+    connect(ui->actionNew_Database, SIGNAL(triggered()), this, SLOT(NewDatabase()));
+    connect(ui->actionOpen_Database, SIGNAL(triggered()), this, SLOT(OpenDatabase()));
+    connect(ui->actionSave_Database, SIGNAL(triggered()), this, SLOT(SaveDatabase()));
+    connect(ui->actionSave_As_Database, SIGNAL(triggered()), this, SLOT(SaveDatabaseAs()));
+    connect(ui->actionClose, SIGNAL(triggered()), this, SLOT(close()));
+
+    // The first screen only needs names, each employee's history is read once it's needed
+    db.set_lazy_load(Vacationdb::Lazy_Load_Config_t{true, true});
+
+    // Loads, saves and balances run on the worker, results come back queued
+    worker = new DatabaseWorker(db);
+    worker->moveToThread(&worker_thread);
+    connect(&worker_thread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+    connect(this, SIGNAL(LoadRequested(QString)), worker, SLOT(Load(QString)));
+    connect(this, SIGNAL(SaveRequested(QString)), worker, SLOT(Save(QString)));
+    connect(this, SIGNAL(ClearRequested()), worker, SLOT(Clear()));
+    connect(worker, SIGNAL(IoFinished(QString)), this, SLOT(IoFinished(QString)));
+    worker_thread.start();
+
+    io_progress = new QProgressBar(this);
+    io_progress->setRange(0, 100);
+    io_progress->setMaximumWidth(200);
+    io_progress->hide();
+    ui->statusbar->addPermanentWidget(io_progress);
+    io_timer.setInterval(50);
+    connect(&io_timer, SIGNAL(timeout()), this, SLOT(PollIo()));
+
+    employees = new EmployeeModel(db, this);
+    connect(employees, SIGNAL(BalancesWanted(quint64, QVector<quint64>, quint64, QDate)), worker,
+            SLOT(ComputeBalances(quint64, QVector<quint64>, quint64, QDate)));
+    connect(worker, SIGNAL(BalancesReady(quint64, QVector<quint64>, QStringList)), employees,
+            SLOT(BalancesReady(quint64, QVector<quint64>, QStringList)));
+
+    employee_filter = new QLineEdit(this);
+    employee_filter->setPlaceholderText(tr("Filter employees by name"));
+    day_type_select = new QComboBox(this);
+
+    auto* controls = new QHBoxLayout();
+    controls->addWidget(employee_filter, 1);
+    controls->addWidget(day_type_select);
+    ui->verticalLayout->addLayout(controls);
+
+    // Rows are fetched as the view scrolls, so it never asks for the whole list
+    employee_view = new QTableView(this);
+    employee_view->setModel(employees);
+    employee_view->setSortingEnabled(true);
+    employee_view->sortByColumn(EmployeeModel::NameColumn, Qt::AscendingOrder);
+    employee_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    employee_view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    employee_view->horizontalHeader()->setStretchLastSection(true);
+    ui->verticalLayout->addWidget(employee_view, 1);
+
+    connect(employee_filter, SIGNAL(textChanged(QString)), employees, SLOT(SetFilter(QString)));
+    connect(day_type_select, SIGNAL(currentTextChanged(QString)), this,
+            SLOT(SelectDayType(QString)));
+    connect(employees, SIGNAL(modelReset()), this, SLOT(UpdateEmployeeCount()));
+
+    RefreshDatabase();
 }
 
 void MainWindow::OpenAboutWindow() {
@@ -14,8 +81,123 @@ void MainWindow::OpenAboutWindow() {
     abdialogue->show();
 }
 
+void MainWindow::RefreshDatabase() {
+    ui->label->setText(tr("Database: %1").arg(QString::fromStdString(db.get_current_filename())));
+
+    auto selected = day_type_select->currentText();
+    day_type_select->blockSignals(true);
+    day_type_select->clear();
+    for (auto&& name : db.list_day_names()) {
+        day_type_select->addItem(QString::fromStdString(name));
+    }
+    day_type_select->setCurrentIndex(std::max(day_type_select->findText(selected), 0));
+    day_type_select->blockSignals(false);
+
+    employees->Reload();
+    SelectDayType(day_type_select->currentText());
+}
+
+void MainWindow::NewDatabase() {
+    if (!io_running) {
+        BeginIo(tr("Clearing"));
+        emit ClearRequested();
+    }
+}
+
+void MainWindow::OpenDatabase() {
+    if (io_running) {
+        return;
+    }
+
+    auto filename = QFileDialog::getOpenFileName(this, tr("Open Database"), QString(),
+                                                 tr("Vacation Databases (*.json)"));
+    if (!filename.isEmpty()) {
+        BeginIo(tr("Loading %1").arg(filename));
+        emit LoadRequested(filename);
+    }
+}
+
+void MainWindow::SaveDatabase() {
+    if (!io_running) {
+        auto filename = QString::fromStdString(db.get_current_filename());
+        BeginIo(tr("Saving %1").arg(filename));
+        emit SaveRequested(filename);
+    }
+}
+
+void MainWindow::SaveDatabaseAs() {
+    if (io_running) {
+        return;
+    }
+
+    auto filename = QFileDialog::getSaveFileName(this, tr("Save Database"), QString(),
+                                                 tr("Vacation Databases (*.json)"));
+    if (!filename.isEmpty()) {
+        BeginIo(tr("Saving %1").arg(filename));
+        emit SaveRequested(filename);
+    }
+}
+
+void MainWindow::BeginIo(const QString& message) {
+    io_running = true;
+    // Showing rows would read the database, which waits for the load to finish
+    employees->Suspend();
+    employee_filter->setEnabled(false);
+    day_type_select->setEnabled(false);
+
+    statusBar()->showMessage(message);
+    io_progress->setValue(0);
+    io_progress->show();
+    io_timer.start();
+}
+
+void MainWindow::PollIo() {
+    // Never waits, unlike everything else the database offers
+    auto status = db.get_load_status();
+    io_progress->setValue(static_cast<int>(status.percentage));
+}
+
+void MainWindow::IoFinished(QString error) {
+    io_timer.stop();
+    io_progress->hide();
+    statusBar()->clearMessage();
+    io_running = false;
+    employee_filter->setEnabled(true);
+    day_type_select->setEnabled(true);
+
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, tr("VacationTime"), error);
+    }
+    RefreshDatabase();
+}
+
+void MainWindow::SelectDayType(const QString& name) {
+    if (name.isEmpty()) {
+        employees->ClearBalanceQuery();
+        return;
+    }
+
+    try {
+        auto day = db.find_day(name.toUtf8().constData());
+        employees->SetBalanceQuery(day, QDate::currentDate());
+    }
+    catch (Vacationdb::Day_Not_Found&) {
+        employees->ClearBalanceQuery();
+    }
+}
+
+void MainWindow::UpdateEmployeeCount() {
+    ui->label_2->setText(tr("Employee Count: %1 employees").arg(employees->EmployeeCount()));
+}
+
 MainWindow::~MainWindow()
 {
+    // The worker finishes what it is doing, then the view and model go, all
+    // before the database they read from
+    worker_thread.quit();
+    worker_thread.wait();
+    delete employee_view;
+    delete employees;
     delete ui;
     delete abdialogue;
 }
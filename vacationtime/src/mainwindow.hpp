@@ -1,8 +1,17 @@
 #ifndef MAINWINDOW_HPP
 #define MAINWINDOW_HPP
 
+#include <QComboBox>
+#include <QLineEdit>
 #include <QMainWindow>
+#include <QProgressBar>
+#include <QTableView>
+#include <QThread>
+#include <QTimer>
 #include "aboutdialogue.hpp"
+#include "databaseworker.hpp"
+#include "employeemodel.hpp"
+#include "vacationdb.hpp"
 
 namespace Ui {
     class MainWindow;
@@ -18,10 +27,44 @@ class MainWindow : public QMainWindow
 
     public slots:
         void OpenAboutWindow();
+        // Rereads everything shown about the database
+        void RefreshDatabase();
+
+        void NewDatabase();
+        void OpenDatabase();
+        void SaveDatabase();
+        void SaveDatabaseAs();
+
+    signals:
+        void LoadRequested(QString filename);
+        void SaveRequested(QString filename);
+        void ClearRequested();
+
+    private slots:
+        void SelectDayType(const QString& name);
+        void UpdateEmployeeCount();
+        void PollIo();
+        void IoFinished(QString error);
 
     private:
+        // Nothing else may touch the database until IoFinished
+        void BeginIo(const QString& message);
+
         Ui::MainWindow* ui;
-        AboutDialogue* abdialogue;
+        AboutDialogue* abdialogue = nullptr;
+
+        // Outlives the model and the worker, which read from it
+        Vacationdb::Database db;
+        QThread worker_thread;
+        DatabaseWorker* worker;
+        bool io_running = false;
+        QTimer io_timer;
+        QProgressBar* io_progress;
+
+        EmployeeModel* employees;
+        QLineEdit* employee_filter;
+        QComboBox* day_type_select;
+        QTableView* employee_view;
 };
 
 #endif // MAINWINDOW_HPP